@@ -0,0 +1,415 @@
+// Benchmarks every DSP and mixing hot path and reports the results as JSON.
+//
+//   groovdeck_bench [--quick] [--seconds=<s>] [--repeats=<n>] [--filter=<text>] [--out=<file.json>]
+//
+// Each case renders a fixed amount of audio from seeded noise, once to warm
+// up and then --repeats times, and reports the median as nanoseconds per
+// sample frame and as a multiple of real time. Cases cover the block sizes,
+// sample rates and voice counts below; --quick keeps one of each for a fast
+// smoke run. A readable table goes to stderr, the JSON to stdout or --out.
+
+#include <JuceHeader.h>
+#include "AudioEngine.h"
+
+namespace
+{
+    struct Options
+    {
+        double seconds = 5.0;
+        int repeats = 5;
+        bool quick = false;
+        juce::String filter;
+    };
+
+    struct Case
+    {
+        juce::String name;
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        int voices = 0;
+        double nsPerSample = 0.0;
+        double realtimeFactor = 0.0;
+    };
+
+    juce::AudioBuffer<float> makeNoise(double seconds, double sampleRate, juce::int64 seed)
+    {
+        juce::Random random(seed);
+        juce::AudioBuffer<float> buffer(2, (int)(seconds * sampleRate));
+
+        // Noise bursts with a decay, so transient detection and tails both have work
+        const int burstLength = (int)(0.25 * sampleRate);
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* samples = buffer.getWritePointer(ch);
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const float envelope = std::exp(-8.0f * (float)(i % burstLength) / (float)burstLength);
+                samples[i] = (random.nextFloat() * 2.0f - 1.0f) * envelope * 0.5f;
+            }
+        }
+
+        return buffer;
+    }
+
+    // Median of the timed runs, after one untimed warm-up run
+    template <typename Function>
+    double measure(const Options& options, Function&& run)
+    {
+        run();
+
+        std::vector<double> times;
+        for (int i = 0; i < options.repeats; ++i)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            run();
+            times.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    class Bench
+    {
+    public:
+        explicit Bench(const Options& o) : options(o) {}
+
+        const std::vector<Case>& getResults() const { return results; }
+
+        std::vector<double> getSampleRates() const
+        {
+            return options.quick ? std::vector<double> { 48000.0 } : std::vector<double> { 44100.0, 48000.0, 96000.0 };
+        }
+
+        std::vector<int> getBlockSizes() const
+        {
+            return options.quick ? std::vector<int> { 256 } : std::vector<int> { 64, 128, 256, 512 };
+        }
+
+        std::vector<int> getVoiceCounts() const
+        {
+            return options.quick ? std::vector<int> { 8 } : std::vector<int> { 1, 8, 32 };
+        }
+
+        bool wants(const juce::String& name) const
+        {
+            return options.filter.isEmpty() || name.containsIgnoreCase(options.filter);
+        }
+
+        // Renders options.seconds of audio block by block through processBlock
+        template <typename ProcessBlock>
+        void runBlocks(const juce::String& name, double sampleRate, int blockSize, int voices, ProcessBlock&& processBlock)
+        {
+            const int numBlocks = juce::jmax(1, (int)(options.seconds * sampleRate / blockSize));
+            juce::AudioBuffer<float> buffer(2, blockSize);
+
+            const double seconds = measure(options, [&]
+            {
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    buffer.clear();
+                    processBlock(buffer);
+                }
+            });
+
+            add(name, sampleRate, blockSize, voices, seconds, (double)numBlocks * blockSize);
+        }
+
+        void add(const juce::String& name, double sampleRate, int blockSize, int voices, double seconds, double numSamples)
+        {
+            Case result;
+            result.name = name;
+            result.sampleRate = sampleRate;
+            result.blockSize = blockSize;
+            result.voices = voices;
+            result.nsPerSample = seconds * 1.0e9 / numSamples;
+            result.realtimeFactor = numSamples / sampleRate / juce::jmax(1.0e-12, seconds);
+            results.push_back(result);
+
+            std::cerr << name.paddedRight(' ', 26) << juce::String((int)sampleRate).paddedLeft(' ', 6) << " Hz"
+                      << juce::String(blockSize).paddedLeft(' ', 6) << " blk"
+                      << juce::String(voices).paddedLeft(' ', 4) << " v"
+                      << juce::String(result.nsPerSample, 2).paddedLeft(' ', 12) << " ns/sample"
+                      << juce::String(result.realtimeFactor, 1).paddedLeft(' ', 10) << "x" << std::endl;
+        }
+
+        void looper()
+        {
+            if (!wants("looper"))
+                return;
+
+            for (auto sampleRate : getSampleRates())
+            {
+                const auto loop = makeNoise(4.0, sampleRate, 1);
+
+                for (auto blockSize : getBlockSizes())
+                {
+                    // Every track playing, one of them overdubbing
+                    LiveLooper looper;
+                    looper.prepareToPlay(blockSize, sampleRate);
+                    for (int track = 0; track < LiveLooper::numTracks; ++track)
+                        looper.loadLoop(track, loop);
+                    looper.startPlayback();
+                    looper.startRecording(0);
+
+                    juce::AudioBuffer<float> input(2, blockSize);
+                    input.copyFrom(0, 0, loop, 0, 0, blockSize);
+                    input.copyFrom(1, 0, loop, 1, 0, blockSize);
+
+                    runBlocks("looper", sampleRate, blockSize, 0, [&](juce::AudioBuffer<float>& buffer)
+                    {
+                        looper.renderNextBlock(juce::AudioSourceChannelInfo(buffer), input);
+                    });
+                }
+            }
+        }
+
+        void slicer()
+        {
+            if (!wants("slicer"))
+                return;
+
+            for (auto sampleRate : getSampleRates())
+            {
+                const auto sample = makeNoise(8.0, sampleRate, 2);
+
+                for (auto blockSize : getBlockSizes())
+                {
+                    for (auto voices : getVoiceCounts())
+                    {
+                        SampleSlicer slicer;
+                        slicer.prepareToPlay(blockSize, sampleRate);
+                        slicer.loadSample(sample);
+                        slicer.autoSlice(0.5);
+                        slicer.setVoiceFilter(true, MultimodeFilter::Mode::lowpass, MultimodeFilter::Slope::db24, 2000.0f, 1.0f);
+                        slicer.setVoiceFilterEnvelope(3.0f, 0.2f);
+
+                        int nextSlice = 0;
+
+                        // Keep the voice count steady; requests start on the next block
+                        runBlocks("slicer", sampleRate, blockSize, voices, [&](juce::AudioBuffer<float>& buffer)
+                        {
+                            for (int i = slicer.getNumActiveVoices(); i < voices; ++i)
+                                slicer.playSlice(nextSlice++ % slicer.getNumSlices());
+
+                            slicer.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer));
+                        });
+                    }
+                }
+            }
+        }
+
+        void sequencer()
+        {
+            if (!wants("sequencer"))
+                return;
+
+            for (auto sampleRate : getSampleRates())
+            {
+                for (auto blockSize : getBlockSizes())
+                {
+                    Sequencer sequencer;
+                    sequencer.prepareToPlay(blockSize, sampleRate);
+                    sequencer.setTempo(140.0);
+                    sequencer.setSteps(16);
+                    for (int step = 0; step < 16; ++step)
+                        sequencer.setStepActive(step, step % 3 != 1);
+                    sequencer.start();
+
+                    runBlocks("sequencer", sampleRate, blockSize, 0, [&](juce::AudioBuffer<float>& buffer)
+                    {
+                        sequencer.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer));
+                    });
+                }
+            }
+        }
+
+        void effects()
+        {
+            using Effect = EffectsProcessor::Effect;
+            const std::pair<const char*, std::vector<Effect>> configurations[] = {
+                { "effects/filter", { Effect::filter } },
+                { "effects/delay", { Effect::delay } },
+                { "effects/reverb", { Effect::reverb } },
+                { "effects/distortion", { Effect::distortion } },
+                { "effects/all", { Effect::filter, Effect::delay, Effect::reverb, Effect::distortion } }
+            };
+
+            for (const auto& configuration : configurations)
+            {
+                if (!wants(configuration.first))
+                    continue;
+
+                for (auto sampleRate : getSampleRates())
+                {
+                    const auto input = makeNoise(1.0, sampleRate, 3);
+
+                    for (auto blockSize : getBlockSizes())
+                    {
+                        EffectsProcessor processor;
+                        processor.prepareToPlay(sampleRate, blockSize);
+                        processor.setDistortionOversampling(2);
+                        for (auto effect : configuration.second)
+                            processor.setEffectEnabled(effect, true);
+
+                        juce::MidiBuffer midi;
+                        int position = 0;
+
+                        runBlocks(configuration.first, sampleRate, blockSize, 0, [&](juce::AudioBuffer<float>& buffer)
+                        {
+                            const int start = position % (input.getNumSamples() - blockSize);
+                            for (int ch = 0; ch < 2; ++ch)
+                                buffer.copyFrom(ch, 0, input, ch, start, blockSize);
+                            position += blockSize;
+
+                            processor.processBlock(buffer, midi);
+                        });
+                    }
+                }
+            }
+        }
+
+        void transients()
+        {
+            // Filtered on the name the case is reported under
+            const juce::String name = "sliceAtTransients";
+            if (!wants(name))
+                return;
+
+            for (auto sampleRate : getSampleRates())
+            {
+                const auto sample = makeNoise(options.seconds, sampleRate, 4);
+
+                SampleSlicer slicer;
+                slicer.prepareToPlay(512, sampleRate);
+                slicer.loadSample(sample);
+
+                const double seconds = measure(options, [&] { slicer.sliceAtTransients(0.5); });
+                add(name, sampleRate, 0, 0, seconds, sample.getNumSamples());
+            }
+        }
+
+        void project()
+        {
+            // Each case is filtered on its own name, so e.g. --filter=project/load
+            // runs just that one
+            const juce::String saveName = "project/save";
+            const juce::String loadName = "project/load";
+            if (!wants(saveName) && !wants(loadName))
+                return;
+
+            const double sampleRate = 48000.0;
+            const auto loop = makeNoise(options.seconds, sampleRate, 5);
+            const auto sample = makeNoise(options.seconds, sampleRate, 6);
+
+            auto file = juce::File::createTempFile(".groovdeck");
+
+            AudioEngine engine(AudioEngine::Mode::headless);
+            engine.prepareToPlay(512, sampleRate);
+            engine.getLiveLooper().loadLoop(0, loop);
+            engine.getSampleSlicer().loadSample(sample);
+            engine.getSampleSlicer().autoSlice(0.5);
+
+            // Embedded audio dominates both directions; count its frames
+            const double numSamples = (double)loop.getNumSamples() + sample.getNumSamples();
+
+            if (wants(saveName))
+            {
+                const double seconds = measure(options, [&]
+                {
+                    engine.saveProject(file);
+                    engine.getProjectManager().waitForPendingSaves();
+                });
+                add(saveName, sampleRate, 0, 0, seconds, numSamples);
+            }
+
+            if (wants(loadName))
+            {
+                engine.saveProject(file);
+                engine.getProjectManager().waitForPendingSaves();
+
+                AudioEngine loader;
+                loader.prepareToPlay(512, sampleRate);
+
+                const double seconds = measure(options, [&] { loader.loadProject(file, true); });
+                add(loadName, sampleRate, 0, 0, seconds, numSamples);
+            }
+
+            engine.releaseResources();
+            file.deleteFile();
+        }
+
+    private:
+        Options options;
+        std::vector<Case> results;
+    };
+
+    juce::var toJSON(const Options& options, const std::vector<Case>& results)
+    {
+        auto* root = new juce::DynamicObject();
+        root->setProperty("version", GROOVDECK_VERSION);
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("cores", juce::SystemStats::getNumCpus());
+        root->setProperty("seconds", options.seconds);
+        root->setProperty("repeats", options.repeats);
+
+        juce::Array<juce::var> cases;
+        for (const auto& result : results)
+        {
+            auto* item = new juce::DynamicObject();
+            item->setProperty("name", result.name);
+            item->setProperty("sampleRate", result.sampleRate);
+            item->setProperty("blockSize", result.blockSize);
+            item->setProperty("voices", result.voices);
+            item->setProperty("nsPerSample", result.nsPerSample);
+            item->setProperty("realtimeFactor", result.realtimeFactor);
+            cases.add(juce::var(item));
+        }
+
+        root->setProperty("results", cases);
+        return juce::var(root);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    Options options;
+    options.quick = args.containsOption("--quick");
+    if (options.quick)
+        options.seconds = 1.0;
+    if (args.containsOption("--seconds"))
+        options.seconds = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+    if (args.containsOption("--repeats"))
+        options.repeats = juce::jmax(1, args.getValueForOption("--repeats").getIntValue());
+    if (args.containsOption("--filter"))
+        options.filter = args.getValueForOption("--filter");
+
+    Bench bench(options);
+    bench.looper();
+    bench.slicer();
+    bench.sequencer();
+    bench.effects();
+    bench.transients();
+    bench.project();
+
+    const auto json = juce::JSON::toString(toJSON(options, bench.getResults()));
+
+    if (args.containsOption("--out"))
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out"));
+        if (!file.replaceWithText(json))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return 0;
+}
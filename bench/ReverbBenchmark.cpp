@@ -0,0 +1,96 @@
+// Compares the CPU cost of FDNReverb at each quality with juce::dsp::Reverb.
+//
+//   ReverbBenchmark [seconds] [blockSize] [sampleRate]
+//
+// Prints the time taken per second of stereo audio and the share of one core
+// that would be used in real time.
+
+#include <JuceHeader.h>
+#include "FDNReverb.h"
+
+namespace
+{
+    struct Result
+    {
+        juce::String name;
+        double seconds;
+    };
+
+    template <typename Processor>
+    double run(Processor& processor, juce::AudioBuffer<float>& input, int blockSize)
+    {
+        juce::AudioBuffer<float> buffer(input.getNumChannels(), blockSize);
+        const int numSamples = input.getNumSamples();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int position = 0; position + blockSize <= numSamples; position += blockSize)
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.copyFrom(ch, 0, input, ch, position, blockSize);
+
+            juce::dsp::AudioBlock<float> block(buffer);
+            processor.process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const double seconds = argc > 1 ? juce::String(argv[1]).getDoubleValue() : 20.0;
+    const int blockSize = argc > 2 ? juce::String(argv[2]).getIntValue() : 128;
+    const double sampleRate = argc > 3 ? juce::String(argv[3]).getDoubleValue() : 48000.0;
+
+    const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32)blockSize, 2 };
+
+    // Short noise bursts, so the tails are exercised as much as the input
+    juce::Random random(1234);
+    juce::AudioBuffer<float> input(2, (int)(seconds * sampleRate));
+    input.clear();
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        auto* samples = input.getWritePointer(ch);
+        for (int i = 0; i < input.getNumSamples(); ++i)
+            samples[i] = (i % (int)sampleRate) < (int)(0.1 * sampleRate) ? random.nextFloat() * 2.0f - 1.0f : 0.0f;
+    }
+
+    std::vector<Result> results;
+
+    {
+        juce::dsp::Reverb reverb;
+        reverb.prepare(spec);
+        juce::Reverb::Parameters parameters;
+        parameters.dryLevel = 0.0f;
+        reverb.setParameters(parameters);
+        results.push_back({ "juce::dsp::Reverb", run(reverb, input, blockSize) });
+    }
+
+    const std::pair<FDNReverb::Quality, const char*> qualities[] = {
+        { FDNReverb::Quality::eco, "FDNReverb eco" },
+        { FDNReverb::Quality::standard, "FDNReverb standard" },
+        { FDNReverb::Quality::high, "FDNReverb high" }
+    };
+
+    for (const auto& quality : qualities)
+    {
+        FDNReverb reverb;
+        reverb.prepare(spec);
+        reverb.setQuality(quality.first);
+        results.push_back({ quality.second, run(reverb, input, blockSize) });
+    }
+
+    std::cout << "Reverb benchmark: " << seconds << " s stereo, block " << blockSize
+              << ", " << sampleRate << " Hz" << std::endl;
+
+    for (const auto& result : results)
+    {
+        std::cout << juce::String(result.name).paddedRight(' ', 22)
+                  << juce::String(result.seconds / seconds * 1000.0, 3) << " ms per second  "
+                  << juce::String(result.seconds / seconds * 100.0, 2) << "% of a core  "
+                  << juce::String(result.seconds / results.front().seconds, 2) << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Bounces a GroovDeck project to an audio file without a sound card.
+//
+//   groovdeck_render <project.groovdeck> <output.wav|output.flac> [options]
+//
+//   --length=<seconds>   Length before the tail (default: four bars)
+//   --tail=<seconds>     Extra time for effects to ring out (default: 2)
+//   --rate=<hz>          Sample rate (default: 44100)
+//   --block=<samples>    Block size (default: 512)
+//   --bits=<n>           Bit depth (default: 24)
+//   --stems              Also write one file per track, <output>-<track>.<ext>,
+//                        without the master compressor and limiter
+//   --threads=<n>        Files rendered at once (default: one per core); each
+//                        file is rendered on a single thread
+//
+// Exits with 0 when every file was written.
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: groovdeck_render <project.groovdeck> <output.wav|output.flac> [--length=s] [--tail=s]"
+                     " [--rate=hz] [--block=n] [--bits=n] [--stems] [--threads=n]" << std::endl
+                  << "Files render in parallel, up to --threads at once; each file renders on one thread." << std::endl
+                  << "Stems skip the master compressor and limiter, so they sum to the mix before them." << std::endl;
+    }
+
+    juce::File getFile(const juce::ArgumentList::Argument& argument)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile(argument.text.unquoted());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // The engine expects JUCE to be set up, though its headless mode needs
+    // no running message loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    if (args.size() < 2 || args[0].isOption() || args[1].isOption())
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto projectFile = getFile(args[0]);
+    const auto outputFile = getFile(args[1]);
+
+    OfflineRenderer::Settings settings;
+    if (args.containsOption("--length"))
+        settings.lengthSeconds = args.getValueForOption("--length").getDoubleValue();
+    if (args.containsOption("--tail"))
+        settings.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+    if (args.containsOption("--block"))
+        settings.blockSize = args.getValueForOption("--block").getIntValue();
+    if (args.containsOption("--bits"))
+        settings.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+
+    const int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue() : 0;
+
+    if (!projectFile.existsAsFile())
+    {
+        std::cerr << "No such project: " << projectFile.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::vector<OfflineRenderer::Job> jobs;
+    jobs.push_back({ projectFile, outputFile, -1 });
+
+    if (args.containsOption("--stems"))
+    {
+        for (int i = 0; i < AudioEngine::numTracks; ++i)
+        {
+            const auto name = outputFile.getFileNameWithoutExtension() + "-" + AudioEngine::getTrackName((AudioEngine::Track)i)
+                            + outputFile.getFileExtension();
+            jobs.push_back({ projectFile, outputFile.getSiblingFile(name), i });
+        }
+    }
+
+    int lastPercent = -1;
+    juce::CriticalSection progressLock;
+
+    const auto results = OfflineRenderer::renderJobs(jobs, settings, numThreads, [&](double fraction)
+    {
+        const juce::ScopedLock sl(progressLock);
+        const int percent = (int)(fraction * 100.0);
+        if (percent / 10 != lastPercent / 10)
+        {
+            lastPercent = percent;
+            std::cout << percent << "%" << std::endl;
+        }
+    });
+
+    bool allOk = true;
+    for (const auto& result : results)
+    {
+        if (result.ok)
+        {
+            std::cout << result.job.outputFile.getFullPathName() << ": " << juce::String(result.audioSeconds, 1)
+                      << " s of audio in " << juce::String(result.renderSeconds, 2) << " s ("
+                      << juce::String(result.audioSeconds / juce::jmax(1.0e-6, result.renderSeconds), 1)
+                      << "x real time)" << std::endl;
+        }
+        else
+        {
+            std::cerr << result.error << std::endl;
+            allOk = false;
+        }
+    }
+
+    return allOk ? 0 : 1;
+}
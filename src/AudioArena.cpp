@@ -0,0 +1,251 @@
+#include "AudioArena.h"
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC || JUCE_ANDROID
+ #include <sys/mman.h>
+ #define GROOVDECK_HAS_MLOCK 1
+#else
+ #define GROOVDECK_HAS_MLOCK 0
+#endif
+
+namespace
+{
+    juce::String formatBytes(size_t numBytes)
+    {
+        return juce::String((double)numBytes / (1024.0 * 1024.0), 1) + " MB";
+    }
+
+    char* alignPointer(char* start)
+    {
+        const auto misalignment = (size_t)((juce::pointer_sized_uint)start % AudioArena::alignment);
+        return misalignment == 0 ? start : start + (AudioArena::alignment - misalignment);
+    }
+}
+
+AudioArena::Block::Block(Block&& other) noexcept
+    : owner(other.owner), subsystem(other.subsystem), data(other.data), size(other.size),
+      heapData(std::move(other.heapData))
+{
+    other.owner = nullptr;
+    other.data = nullptr;
+    other.size = 0;
+}
+
+AudioArena::Block& AudioArena::Block::operator=(Block&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        owner = other.owner;
+        subsystem = other.subsystem;
+        data = other.data;
+        size = other.size;
+        heapData = std::move(other.heapData);
+
+        other.owner = nullptr;
+        other.data = nullptr;
+        other.size = 0;
+    }
+
+    return *this;
+}
+
+void AudioArena::Block::release()
+{
+    if (owner != nullptr)
+        owner->free(*this);
+
+    owner = nullptr;
+    data = nullptr;
+    size = 0;
+    heapData.free();
+}
+
+AudioArena::AudioArena()
+{
+}
+
+AudioArena::~AudioArena()
+{
+    // Every block must be gone first; their owners are destroyed before us
+    jassert(blocks.empty());
+    unlock();
+}
+
+bool AudioArena::reserve(size_t budget)
+{
+    const juce::ScopedLock sl(lockObject);
+
+    if (!blocks.empty())
+        return false;
+
+    unlock();
+    memory.free();
+    base = nullptr;
+    capacity = 0;
+
+    budget = roundUp(budget);
+    if (budget == 0)
+        return true;
+
+    memory.malloc(budget + alignment);
+    if (memory == nullptr)
+        return false;
+
+    base = alignPointer(memory.get());
+    capacity = budget;
+
+    // Writing every page makes the system back it now, not on the audio thread
+    std::memset(base, 0, capacity);
+    return true;
+}
+
+bool AudioArena::lock()
+{
+    const juce::ScopedLock sl(lockObject);
+
+    if (locked || capacity == 0)
+        return locked;
+
+   #if GROOVDECK_HAS_MLOCK
+    locked = mlock(base, capacity) == 0;
+   #endif
+
+    return locked;
+}
+
+void AudioArena::unlock()
+{
+    const juce::ScopedLock sl(lockObject);
+
+   #if GROOVDECK_HAS_MLOCK
+    if (locked)
+        munlock(base, capacity);
+   #endif
+
+    locked = false;
+}
+
+AudioArena::Block AudioArena::allocate(Subsystem subsystem, size_t numBytes)
+{
+    Block block;
+    block.owner = this;
+    block.subsystem = subsystem;
+    block.size = roundUp(juce::jmax((size_t)1, numBytes));
+
+    const juce::ScopedLock sl(lockObject);
+
+    const auto offset = findFreeRange(block.size);
+    if (offset < capacity)
+    {
+        blocks[offset] = block.size;
+        block.data = base + offset;
+    }
+    else
+    {
+        block.heapData.malloc(block.size + alignment);
+        block.data = alignPointer(block.heapData.get());
+        usage[(size_t)subsystem].spilledBytes += block.size;
+    }
+
+    // Zeroed either way: a reused range still holds its last owner's audio
+    std::memset(block.data, 0, block.size);
+
+    auto& used = usage[(size_t)subsystem];
+    used.bytes += block.size;
+    used.peakBytes = juce::jmax(used.peakBytes, used.bytes);
+    ++used.numBlocks;
+
+    return block;
+}
+
+AudioArena::Block AudioArena::allocateFrom(AudioArena* arena, Subsystem subsystem, size_t numBytes)
+{
+    if (arena != nullptr)
+        return arena->allocate(subsystem, numBytes);
+
+    Block block;
+    block.subsystem = subsystem;
+    block.size = roundUp(juce::jmax((size_t)1, numBytes));
+    block.heapData.malloc(block.size + alignment);
+    block.data = alignPointer(block.heapData.get());
+    std::memset(block.data, 0, block.size);
+    return block;
+}
+
+size_t AudioArena::findFreeRange(size_t numBytes) const
+{
+    // First fit between the blocks in use; capacity if nothing fits
+    size_t start = 0;
+    for (const auto& [offset, size] : blocks)
+    {
+        if (offset - start >= numBytes)
+            return start;
+
+        start = offset + size;
+    }
+
+    return capacity - start >= numBytes ? start : capacity;
+}
+
+void AudioArena::free(Block& block)
+{
+    const juce::ScopedLock sl(lockObject);
+
+    auto& used = usage[(size_t)block.subsystem];
+    used.bytes -= block.size;
+    --used.numBlocks;
+
+    if (block.isSpilled())
+        used.spilledBytes -= block.size;
+    else
+        blocks.erase((size_t)(static_cast<char*>(block.data) - base));
+}
+
+AudioArena::Usage AudioArena::getUsage(Subsystem subsystem) const
+{
+    const juce::ScopedLock sl(lockObject);
+    return usage[(size_t)subsystem];
+}
+
+size_t AudioArena::getUsedBytes() const
+{
+    const juce::ScopedLock sl(lockObject);
+
+    size_t total = 0;
+    for (const auto& block : blocks)
+        total += block.second;
+
+    return total;
+}
+
+juce::String AudioArena::getSubsystemName(Subsystem subsystem)
+{
+    switch (subsystem)
+    {
+        case Subsystem::looper:  return "Looper";
+        case Subsystem::slicer:  return "Slicer";
+        case Subsystem::effects: return "Effects";
+    }
+    return {};
+}
+
+juce::String AudioArena::createReport() const
+{
+    juce::String report;
+    report << "Audio memory: " << formatBytes(getUsedBytes()) << " of " << formatBytes(capacity) << " reserved"
+           << (locked ? ", locked" : ", not locked") << juce::newLine;
+    report << juce::String("subsystem").paddedRight(' ', 20) << "    used     peak  spilled  blocks" << juce::newLine;
+
+    for (int i = 0; i < numSubsystems; ++i)
+    {
+        const auto used = getUsage((Subsystem)i);
+        report << getSubsystemName((Subsystem)i).paddedRight(' ', 20)
+               << formatBytes(used.bytes).paddedLeft(' ', 8)
+               << formatBytes(used.peakBytes).paddedLeft(' ', 9)
+               << formatBytes(used.spilledBytes).paddedLeft(' ', 9)
+               << juce::String(used.numBlocks).paddedLeft(' ', 8) << juce::newLine;
+    }
+
+    return report;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+
+// One block of memory, reserved up front, that the engine's large audio
+// buffers are carved from: looper tracks, the slicer's sample and the effect
+// delay lines. Reserving everything at once keeps memory use predictable,
+// lets the whole lot be locked into RAM, and touches every page before the
+// audio thread first needs it.
+//
+// Blocks are handed out and returned on the message thread, in prepare
+// calls or when loading; the audio thread only reads and writes them. A
+// request that does not fit, or comes before the arena is reserved, is
+// served from the heap instead and counted as spilled, so a budget that is
+// too small shows up in the report rather than as missing audio.
+class AudioArena
+{
+public:
+    static constexpr size_t alignment = 64;                 // Bytes: a cache line, enough for any vector load
+    static constexpr size_t defaultBudget = (size_t)256 << 20;
+
+    enum class Subsystem
+    {
+        looper,
+        slicer,
+        effects
+    };
+
+    static constexpr int numSubsystems = 3;
+
+    struct Usage
+    {
+        size_t bytes = 0;           // In use now, arena and heap together
+        size_t spilledBytes = 0;    // Of those, served from the heap
+        size_t peakBytes = 0;
+        int numBlocks = 0;
+    };
+
+    // A zeroed, aligned region, owned like a unique_ptr: it goes back to
+    // the arena, or the heap, when destroyed or released
+    class Block
+    {
+    public:
+        Block() = default;
+        ~Block() { release(); }
+
+        Block(Block&& other) noexcept;
+        Block& operator=(Block&& other) noexcept;
+
+        template <typename Type>
+        Type* getData() const { return static_cast<Type*>(data); }
+
+        size_t getSize() const { return size; }
+        bool isSpilled() const { return heapData != nullptr; }
+        explicit operator bool() const { return data != nullptr; }
+
+        void release();
+
+    private:
+        friend class AudioArena;
+
+        AudioArena* owner = nullptr;
+        Subsystem subsystem = Subsystem::looper;
+        void* data = nullptr;
+        size_t size = 0;
+        juce::HeapBlock<char> heapData;
+
+        JUCE_DECLARE_NON_COPYABLE(Block)
+    };
+
+    AudioArena();
+    ~AudioArena();
+
+    // Allocates and prefaults budget bytes. Fails, keeping the current
+    // reservation, while any block is still handed out.
+    bool reserve(size_t budget);
+    bool isReserved() const { return capacity > 0; }
+    size_t getCapacity() const { return capacity; }
+
+    // Pins the reservation in RAM so it is never paged out; false if the
+    // system refused, typically over RLIMIT_MEMLOCK
+    bool lock();
+    void unlock();
+    bool isLocked() const { return locked; }
+
+    // Any size; rounded up to the alignment. With no arena, e.g. a source
+    // used on its own in a test, allocateFrom serves it from the heap.
+    Block allocate(Subsystem subsystem, size_t numBytes);
+    static Block allocateFrom(AudioArena* arena, Subsystem subsystem, size_t numBytes);
+
+    static size_t roundUp(size_t numBytes) { return (numBytes + alignment - 1) & ~(alignment - 1); }
+
+    Usage getUsage(Subsystem subsystem) const;
+    size_t getUsedBytes() const;        // Of the reservation
+    static juce::String getSubsystemName(Subsystem subsystem);
+
+    // Reservation, lock state and usage per subsystem, one line each
+    juce::String createReport() const;
+
+private:
+    juce::HeapBlock<char> memory;
+    char* base = nullptr;               // memory, aligned
+    size_t capacity = 0;
+    bool locked = false;
+
+    // Offset to size of every block handed out from the reservation
+    std::map<size_t, size_t> blocks;
+    std::array<Usage, numSubsystems> usage;
+    juce::CriticalSection lockObject;
+
+    size_t findFreeRange(size_t numBytes) const;
+    void free(Block& block);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioArena)
+};
@@ -0,0 +1,48 @@
+#include "AudioDeviceHost.h"
+
+AudioDeviceHost::AudioDeviceHost(AudioEngine& e, int numInputChannels, int numOutputChannels)
+    : engine(e)
+{
+    player.setSource(&engine);
+
+    deviceManager.initialise(numInputChannels, numOutputChannels, nullptr, true);
+    deviceManager.addAudioCallback(this);
+}
+
+AudioDeviceHost::~AudioDeviceHost()
+{
+    deviceManager.removeAudioCallback(this);
+    player.setSource(nullptr);
+}
+
+void AudioDeviceHost::audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                                       float* const* outputChannelData, int numOutputChannels,
+                                                       int numSamples, const juce::AudioIODeviceCallbackContext& context)
+{
+    if (!threadConfigured.load())
+    {
+        if (auto* config = realtimeConfig.load())
+            config->applyToAudioThread();
+
+        threadConfigured = true;
+    }
+
+    player.audioDeviceIOCallbackWithContext(inputChannelData, numInputChannels, outputChannelData, numOutputChannels,
+                                            numSamples, context);
+}
+
+void AudioDeviceHost::audioDeviceAboutToStart(juce::AudioIODevice* device)
+{
+    // A new start may come with a new audio thread
+    threadConfigured = false;
+
+    // The player prepares the engine, which wants to know the device first
+    engine.setAudioDevice(device);
+    player.audioDeviceAboutToStart(device);
+}
+
+void AudioDeviceHost::audioDeviceStopped()
+{
+    player.audioDeviceStopped();
+    engine.setAudioDevice(nullptr);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioEngine.h"
+#include "RealtimeConfig.h"
+
+// Plays an AudioEngine through the sound card. Owns the device manager and
+// tells the engine which device it is running on before each start, so the
+// engine itself never touches a device and can be rendered offline too.
+class AudioDeviceHost : private juce::AudioIODeviceCallback
+{
+public:
+    AudioDeviceHost(AudioEngine& engine, int numInputChannels = 2, int numOutputChannels = 2);
+    ~AudioDeviceHost() override;
+
+    juce::AudioDeviceManager& getDeviceManager() { return deviceManager; }
+
+    // Has each new audio thread set itself up for realtime work in its first
+    // callback; nullptr to stop. The config must outlive the host.
+    void setRealtimeConfig(RealtimeConfig* config) { realtimeConfig = config; threadConfigured = false; }
+
+private:
+    AudioEngine& engine;
+    juce::AudioDeviceManager deviceManager;
+    juce::AudioSourcePlayer player;
+    std::atomic<RealtimeConfig*> realtimeConfig { nullptr };
+    std::atomic<bool> threadConfigured { false };
+
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                          float* const* outputChannelData, int numOutputChannels,
+                                          int numSamples, const juce::AudioIODeviceCallbackContext& context) override;
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceStopped() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioDeviceHost)
+};
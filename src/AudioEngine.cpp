@@ -1,46 +1,264 @@
 #include "AudioEngine.h"
 
-AudioEngine::AudioEngine()
+AudioEngine::AudioEngine(Mode engineMode)
+    : mode(engineMode), projectManager(samplePool)
 {
     formatManager.registerBasicFormats();
-    deviceManager.initialise(2, 2, nullptr, true);
-    deviceManager.addAudioCallback(this);
+    projectManager.captureState = [this](ProjectData& data) { captureProjectState(data); };
+
+    liveLooper.setArena(&audioArena);
+    sampleSlicer.setArena(&audioArena);
+    effectsProcessor.setArena(&audioArena);
+    for (auto& chain : trackEffects)
+        chain.setArena(&audioArena);
+    for (auto& bus : auxBuses)
+        bus.getEffects().setArena(&audioArena);
+
+    // Bus effects run 100% wet; the return level sets how much comes back
+    if (auto* reverb = static_cast<ReverbUnit*>(getAuxBus(Bus::reverb).getEffects().addEffect(EffectUnit::Type::reverb)))
+        reverb->setParameters(0.5f, 0.5f, 1.0f, 0.0f);
+
+    if (auto* delay = static_cast<DelayUnit*>(getAuxBus(Bus::delay).getEffects().addEffect(EffectUnit::Type::delay)))
+        delay->setParameters(0.5f, 0.3f, 1.0f);
 }
 
 AudioEngine::~AudioEngine()
 {
-    deviceManager.removeAudioCallback(this);
+    // Last auto-save while every source is still alive
+    if (projectManager.isAutoSaveEnabled())
+        projectManager.performAutoSave();
+    projectManager.captureState = nullptr;
+
     unloadAudioFile();
 }
 
 void AudioEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
+    if (!audioArena.isReserved())
+        audioArena.reserve(AudioArena::defaultBudget);
+
     transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
     effectsProcessor.prepareToPlay(sampleRate, samplesPerBlockExpected);
     liveLooper.prepareToPlay(samplesPerBlockExpected, sampleRate);
     sequencer.prepareToPlay(samplesPerBlockExpected, sampleRate);
     sampleSlicer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    midiController.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    clipLauncher.prepare(sampleRate);
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = (juce::uint32)juce::jmax(1, samplesPerBlockExpected);
+    spec.numChannels = 2;
+
+    for (auto& chain : trackEffects)
+        chain.prepare(spec);
+
+    for (auto& bus : auxBuses)
+        bus.prepare(spec);
+
+    masterDynamics.prepare(spec);
+    profiler.prepare(sampleRate);
+
+    if (mode == Mode::live)
+        xrunMonitor.prepare(sampleRate);
+
+    currentSampleRate = sampleRate;
+    samplesUntilSnapshot = 0;
+
+    trackBuffer.setSize(2, (int)spec.maximumBlockSize);
+    inputBuffer.setSize(2, (int)spec.maximumBlockSize);
+
+    if (auto* device = currentDevice)
+        midiController.setOutputLatency(device->getOutputLatencyInSamples() + masterDynamics.getLatencySamples());
+
+    incomingMidi.ensureSize(MIDIEventQueue::capacity * 3);
+    blockMidi.ensureSize(MIDIEventQueue::capacity * 3);
 }
 
 void AudioEngine::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    // Get audio from transport source (file playback)
-    transportSource.getNextAudioBlock(bufferToFill);
-    
-    // Mix in live looper
-    liveLooper.getNextAudioBlock(bufferToFill);
-    
-    // Mix in sequencer
-    sequencer.getNextAudioBlock(bufferToFill);
-    
-    // Mix in sample slicer
-    sampleSlicer.getNextAudioBlock(bufferToFill);
+    profiler.beginBlock(bufferToFill.numSamples);
+
+    // Collect MIDI that arrived since the last block, placed at sample offsets
+    incomingMidi.clear();
+    if (mode == Mode::live)
+        midiController.removeNextBlockOfMessages(incomingMidi, bufferToFill.numSamples);
+
+    // Tempo-synced effects follow the sequencer
+    const double tempo = sequencer.getTempo();
+    for (auto& chain : trackEffects)
+        chain.setTempo(tempo);
+    for (auto& bus : auxBuses)
+        bus.getEffects().setTempo(tempo);
+    effectsProcessor.setTempo(tempo);
+
+    // Track buffers are sized for the expected block; split anything larger
+    const int maxBlockSize = trackBuffer.getNumSamples();
+    if (maxBlockSize == 0)
+        bufferToFill.clearActiveBufferRegion();
+
+    for (int offset = 0; maxBlockSize > 0 && offset < bufferToFill.numSamples; offset += maxBlockSize)
+    {
+        const int numSamples = juce::jmin(maxBlockSize, bufferToFill.numSamples - offset);
+        const juce::AudioSourceChannelInfo block(bufferToFill.buffer, bufferToFill.startSample + offset, numSamples);
+
+        blockMidi.clear();
+        blockMidi.addEvents(incomingMidi, offset, numSamples, -offset);
+
+        // The device's input arrives in the output buffer; keep it for the
+        // looper before mixing over it
+        for (int ch = 0; ch < inputBuffer.getNumChannels(); ++ch)
+            inputBuffer.copyFrom(ch, 0, *block.buffer, juce::jmin(ch, block.buffer->getNumChannels() - 1), block.startSample, numSamples);
+
+        block.clearActiveBufferRegion();
+        renderTracks(block, blockMidi);
+    }
     
     // Apply effects if enabled
     if (effectsProcessor.isEffectEnabled())
     {
-        juce::MidiBuffer midiBuffer;
-        effectsProcessor.processBlock(*bufferToFill.buffer, midiBuffer);
+        const DSPProfiler::ScopedTimer timer(profiler, DSPProfiler::Node::masterEffects);
+        effectsProcessor.processBlock(*bufferToFill.buffer, incomingMidi);
+    }
+
+    // Nothing leaves the engine above the limiter's ceiling
+    {
+        const DSPProfiler::ScopedTimer timer(profiler, DSPProfiler::Node::masterDynamics);
+        auto outputBlock = juce::dsp::AudioBlock<float>(*bufferToFill.buffer)
+                               .getSubBlock((size_t)bufferToFill.startSample, (size_t)bufferToFill.numSamples);
+        masterDynamics.process(juce::dsp::ProcessContextReplacing<float>(outputBlock));
+    }
+
+    // Flush this block's outgoing MIDI and clock as one timestamped batch
+    if (mode == Mode::live)
+        midiController.sendNextBlockOfMessages(bufferToFill.numSamples);
+
+    profiler.endBlock();
+    if (mode == Mode::live)
+        checkForXruns(bufferToFill.numSamples);
+    captureUISnapshot(bufferToFill.numSamples);
+}
+
+void AudioEngine::checkForXruns(int numSamples)
+{
+    static_assert(numTracks <= XrunMonitor::maxTracks && numBuses <= XrunMonitor::maxBuses,
+                  "XrunMonitor::GraphState is too small for the engine");
+
+    XrunMonitor::GraphState graph;
+    graph.numTracks = numTracks;
+    graph.numBuses = numBuses;
+
+    for (int i = 0; i < numTracks; ++i)
+        graph.insertCounts[(size_t)i] = trackEffects[(size_t)i].getNumActiveStages();
+
+    for (int i = 0; i < numBuses; ++i)
+        graph.busesActive[(size_t)i] = !auxBuses[(size_t)i].isIdle();
+
+    graph.masterEffectsEnabled = effectsProcessor.isEffectEnabled();
+    graph.slicerVoices = sampleSlicer.getNumActiveVoices();
+
+    const int deviceXruns = currentDevice != nullptr ? currentDevice->getXRunCount() : -1;
+    xrunMonitor.endBlock(profiler, numSamples, deviceXruns, graph);
+}
+
+void AudioEngine::captureUISnapshot(int numSamples)
+{
+    static_assert(numTracks == ClipLauncher::numTracks && numTracks <= EngineSnapshot::maxClipTracks,
+                  "The clip grid needs one column per track");
+    static_assert(LiveLooper::numTracks <= EngineSnapshot::maxLooperTracks, "EngineSnapshot is too small for the looper");
+
+    samplesUntilSnapshot -= numSamples;
+    if (samplesUntilSnapshot > 0)
+        return;
+
+    samplesUntilSnapshot += juce::jmax(1, (int)(currentSampleRate / uiSnapshotRateHz));
+
+    auto& snapshot = uiSnapshots.getWriteBuffer();
+    snapshot.serial = ++snapshotSerial;
+
+    snapshot.transportPlaying = transportSource.isPlaying();
+    snapshot.transportPosition = transportSource.getCurrentPosition();
+    snapshot.transportLength = transportSource.getLengthInSeconds();
+
+    snapshot.looperMasterLength = liveLooper.getMasterLength();
+    for (int i = 0; i < LiveLooper::numTracks; ++i)
+    {
+        const double length = liveLooper.getTrackLength(i);
+        snapshot.looperStates[(size_t)i] = (int)liveLooper.getTrackState(i);
+        snapshot.looperPositions[(size_t)i] = length > 0.0 ? (float)(liveLooper.getTrackPosition(i) / length) : 0.0f;
+    }
+
+    snapshot.sequencerPlaying = sequencer.isPlaying();
+    snapshot.sequencerStep = sequencer.getCurrentStep();
+    snapshot.sequencerNumSteps = sequencer.getNumSteps();
+
+    for (int i = 0; i < ClipLauncher::numTracks; ++i)
+    {
+        snapshot.clipPlayingScenes[(size_t)i] = clipLauncher.getPlayingScene(i);
+        snapshot.clipQueuedScenes[(size_t)i] = clipLauncher.getQueuedScene(i);
+    }
+
+    snapshot.slicerNumVoices = sampleSlicer.getVoicePositions(snapshot.slicerPlayheads.data(),
+                                                              EngineSnapshot::maxSlicerPlayheads);
+
+    uiSnapshots.publish();
+}
+
+void AudioEngine::renderTracks(const juce::AudioSourceChannelInfo& bufferToFill, const juce::MidiBuffer& midi)
+{
+    const int numSamples = bufferToFill.numSamples;
+    const int numChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), trackBuffer.getNumChannels());
+    const juce::AudioSourceChannelInfo trackInfo(&trackBuffer, 0, numSamples);
+
+    for (auto& bus : auxBuses)
+        bus.beginBlock(numSamples);
+
+    // Launches line up with the sequencer's bars while it plays
+    clipLauncher.beginBlock(numSamples, sequencer.getTempo(), sequencer.isPlaying() ? sequencer.getBeatPosition() : -1.0);
+
+    for (int i = 0; i < numTracks; ++i)
+    {
+        const auto track = (Track)i;
+        trackBuffer.clear(0, numSamples);
+
+        {
+            const DSPProfiler::ScopedTimer timer(profiler, (DSPProfiler::Node)((int)DSPProfiler::Node::filePlayer + i));
+
+            switch (track)
+            {
+                case Track::filePlayer: transportSource.getNextAudioBlock(trackInfo); break;
+                case Track::looper:     liveLooper.renderNextBlock(trackInfo, inputBuffer); break;
+                case Track::sequencer:  sequencer.getNextAudioBlock(trackInfo); break;
+
+                // Triggered sample-accurately from MIDI
+                case Track::slicer:     sampleSlicer.renderNextBlock(trackInfo, midi); break;
+            }
+
+            clipLauncher.renderTrack(i, trackBuffer, numSamples);
+        }
+
+        if (trackMuted[(size_t)i].load())
+            continue;
+
+        {
+            const DSPProfiler::ScopedTimer timer(profiler, (DSPProfiler::Node)((int)DSPProfiler::Node::filePlayerInserts + i));
+            auto block = juce::dsp::AudioBlock<float>(trackBuffer).getSubBlock(0, (size_t)numSamples);
+            trackEffects[(size_t)i].process(block);
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            bufferToFill.buffer->addFrom(ch, bufferToFill.startSample, trackBuffer, ch, 0, numSamples);
+
+        for (auto& bus : auxBuses)
+            bus.addSend(i, trackBuffer, numSamples);
+    }
+
+    clipLauncher.endBlock();
+
+    for (int i = 0; i < numBuses; ++i)
+    {
+        const DSPProfiler::ScopedTimer timer(profiler, (DSPProfiler::Node)((int)DSPProfiler::Node::reverbBus + i));
+        auxBuses[(size_t)i].addReturnTo(bufferToFill);
     }
 }
 
@@ -51,6 +269,14 @@ void AudioEngine::releaseResources()
     liveLooper.releaseResources();
     sequencer.releaseResources();
     sampleSlicer.releaseResources();
+
+    for (auto& chain : trackEffects)
+        chain.reset();
+
+    for (auto& bus : auxBuses)
+        bus.reset();
+
+    masterDynamics.reset();
 }
 
 bool AudioEngine::loadAudioFile(const juce::File& file)
@@ -62,6 +288,7 @@ bool AudioEngine::loadAudioFile(const juce::File& file)
     {
         audioSource.reset(new juce::AudioFormatReaderSource(audioFileReader.get(), true));
         transportSource.setSource(audioSource.get(), 0, nullptr, audioFileReader->sampleRate);
+        audioFile = file;
         return true;
     }
     return false;
@@ -72,6 +299,7 @@ void AudioEngine::unloadAudioFile()
     transportSource.setSource(nullptr);
     audioSource = nullptr;
     audioFileReader = nullptr;
+    audioFile = juce::File();
 }
 
 void AudioEngine::startPlayback()
@@ -93,4 +321,344 @@ void AudioEngine::setLooping(bool shouldLoop)
 void AudioEngine::setGain(float newGain)
 {
     transportSource.setGain(newGain);
-} 
\ No newline at end of file
+}
+
+void AudioEngine::captureProjectState(ProjectData& data)
+{
+    // Start from the stored project so names and settings without a live
+    // source of truth are kept
+    projectManager.exportProjectData(data);
+
+    data.tempo = sequencer.getTempo();
+    data.sequencer.numSteps = sequencer.getNumSteps();
+    data.sequencer.tempo = sequencer.getTempo();
+    data.sequencer.stepStates.resize((size_t)data.sequencer.numSteps);
+    data.sequencer.stepVelocities.resize((size_t)data.sequencer.numSteps);
+    for (int i = 0; i < data.sequencer.numSteps; ++i)
+    {
+        data.sequencer.stepStates[(size_t)i] = sequencer.getStepActive(i);
+        data.sequencer.stepVelocities[(size_t)i] = sequencer.getStepVelocity(i);
+    }
+
+    using Effect = EffectsProcessor::Effect;
+    auto& fx = data.effects;
+    const auto reverbParameters = effectsProcessor.getReverbParameters();
+    fx.reverbEnabled = effectsProcessor.isEffectEnabled(Effect::reverb);
+    fx.reverbRoomSize = reverbParameters.roomSize;
+    fx.reverbDamping = reverbParameters.damping;
+    fx.reverbWetLevel = reverbParameters.wetLevel;
+    fx.reverbDryLevel = reverbParameters.dryLevel;
+    fx.delayEnabled = effectsProcessor.isEffectEnabled(Effect::delay);
+    fx.delayTime = effectsProcessor.getDelayTime();
+    fx.delayFeedback = effectsProcessor.getDelayFeedback();
+    fx.delayMix = effectsProcessor.getDelayMix();
+    fx.filterEnabled = effectsProcessor.isEffectEnabled(Effect::filter);
+    fx.filterCutoff = effectsProcessor.getFilterCutoff();
+    fx.filterResonance = effectsProcessor.getFilterResonance();
+    fx.distortionEnabled = effectsProcessor.isEffectEnabled(Effect::distortion);
+    fx.distortionDrive = effectsProcessor.getDistortionDrive();
+    fx.distortionMix = effectsProcessor.getDistortionMix();
+
+    // Every looper track, with the master its loops were measured against
+    data.looperMasterLength = liveLooper.getMasterLength();
+    data.looper.assign((size_t)LiveLooper::numTracks, {});
+    for (int i = 0; i < LiveLooper::numTracks; ++i)
+    {
+        auto& track = data.looper[(size_t)i];
+        track.loopLength = liveLooper.getTrackLength(i);
+        track.loopGain = liveLooper.getTrackGain(i);
+        track.loopEnd = track.loopLength;
+        track.hasLoop = liveLooper.hasLoop(i);
+        track.lengthFactor = liveLooper.getLengthFactor(i);
+        track.muted = liveLooper.isTrackMuted(i);
+        track.reversed = liveLooper.isTrackReversed(i);
+
+        if (auto loop = liveLooper.getLoopSnapshot(i))
+        {
+            track.audio.key = "looper/" + juce::String(i);
+            track.audio.buffer = std::move(loop);
+            track.audio.sampleRate = liveLooper.getSampleRate();
+        }
+    }
+
+    data.slicer.sampleFile = sampleSlicer.getSampleFile().getFullPathName();
+    data.slicer.sliceNames.clear();
+    data.slicer.sliceStartTimes.clear();
+    data.slicer.sliceEndTimes.clear();
+    for (int i = 0; i < sampleSlicer.getNumSlices(); ++i)
+    {
+        const auto& slice = sampleSlicer.getSlice(i);
+        data.slicer.sliceNames.push_back(slice.name);
+        data.slicer.sliceStartTimes.push_back(slice.startTime);
+        data.slicer.sliceEndTimes.push_back(slice.endTime);
+    }
+    data.slicer.sample = {};
+    if (auto sample = sampleSlicer.getSampleSnapshot())
+    {
+        data.slicer.sample.key = "slicer";
+        data.slicer.sample.buffer = std::move(sample);
+        data.slicer.sample.sampleRate = sampleSlicer.getSampleRate();
+    }
+}
+
+bool AudioEngine::captureClip(Track track, int scene)
+{
+    ClipLauncher::Clip clip;
+    clip.name = getTrackName(track);
+    const double beatsPerSecond = sequencer.getTempo() / 60.0;
+
+    // Clips own their audio under a key per slot, so recapturing replaces it
+    const auto key = "clip/" + getTrackName(track) + "/" + juce::String(scene);
+
+    switch (track)
+    {
+        case Track::filePlayer:
+        {
+            if (audioFileReader == nullptr || !audioFile.existsAsFile())
+                return false;
+
+            // Decoded in the background, straight from the file
+            clip.type = ClipLauncher::ClipType::loop;
+            clip.name = audioFile.getFileNameWithoutExtension();
+            clip.sampleKey = audioFile.getFullPathName();
+            clip.lengthBeats = juce::jmax(1.0, std::round(transportSource.getLengthInSeconds() * beatsPerSecond));
+
+            if (!samplePool.contains(clip.sampleKey))
+                samplePool.addFile(clip.sampleKey, audioFile);
+            break;
+        }
+
+        case Track::looper:
+        {
+            // Every unmuted layer, mixed
+            auto loop = liveLooper.getMixSnapshot();
+            if (loop == nullptr)
+                return false;
+
+            clip.type = ClipLauncher::ClipType::loop;
+            clip.sampleKey = key;
+            clip.lengthBeats = juce::jmax(1.0, std::round(loop->getNumSamples() / liveLooper.getSampleRate() * beatsPerSecond));
+            samplePool.addBuffer(key, std::move(loop), liveLooper.getSampleRate());
+            break;
+        }
+
+        case Track::sequencer:
+        {
+            // No audio: plays the Sequencer's own trigger pulses
+            clip.type = ClipLauncher::ClipType::pattern;
+            for (int i = 0; i < sequencer.getNumSteps(); ++i)
+                clip.stepVelocities.push_back(sequencer.getStepActive(i) ? sequencer.getStepVelocity(i) : 0.0f);
+            break;
+        }
+
+        case Track::slicer:
+        {
+            auto sample = sampleSlicer.getSampleSnapshot();
+            if (sample == nullptr || sampleSlicer.getNumSlices() == 0)
+                return false;
+
+            clip.type = ClipLauncher::ClipType::slices;
+            clip.sampleKey = key;
+
+            // One slice per step, in order
+            const double sampleRate = sampleSlicer.getSampleRate();
+            for (int i = 0; i < sampleSlicer.getNumSlices(); ++i)
+            {
+                const auto& slice = sampleSlicer.getSlice(i);
+                clip.slices.push_back({ (int)(slice.startTime * sampleRate), (int)(slice.endTime * sampleRate) });
+                clip.sliceSteps.push_back(slice.active ? i : -1);
+            }
+
+            samplePool.addBuffer(key, std::move(sample), sampleRate);
+            break;
+        }
+    }
+
+    clipLauncher.setClip((int)track, scene, std::move(clip));
+    return true;
+}
+
+juce::String AudioEngine::getTrackName(Track track)
+{
+    switch (track)
+    {
+        case Track::filePlayer: return "player";
+        case Track::looper:     return "looper";
+        case Track::sequencer:  return "sequencer";
+        case Track::slicer:     return "slicer";
+    }
+
+    return {};
+}
+
+void AudioEngine::applyProjectState(const ProjectData& data, bool waitForAudio)
+{
+    sequencer.setTempo(data.sequencer.tempo);
+    sequencer.setSteps(data.sequencer.numSteps);
+    for (int i = 0; i < data.sequencer.numSteps; ++i)
+    {
+        if ((size_t)i < data.sequencer.stepStates.size())
+            sequencer.setStepActive(i, data.sequencer.stepStates[(size_t)i]);
+        if ((size_t)i < data.sequencer.stepVelocities.size())
+            sequencer.setStepVelocity(i, data.sequencer.stepVelocities[(size_t)i]);
+    }
+
+    const auto& fx = data.effects;
+    effectsProcessor.setReverbParameters(fx.reverbRoomSize, fx.reverbDamping, fx.reverbWetLevel, fx.reverbDryLevel);
+    effectsProcessor.setDelayParameters(fx.delayTime, fx.delayFeedback, fx.delayMix);
+    effectsProcessor.setFilterParameters(fx.filterCutoff, fx.filterResonance);
+    effectsProcessor.setDistortionParameters(fx.distortionDrive, fx.distortionMix);
+    effectsProcessor.setEffectEnabled(EffectsProcessor::Effect::reverb, fx.reverbEnabled);
+    effectsProcessor.setEffectEnabled(EffectsProcessor::Effect::delay, fx.delayEnabled);
+    effectsProcessor.setEffectEnabled(EffectsProcessor::Effect::filter, fx.filterEnabled);
+    effectsProcessor.setEffectEnabled(EffectsProcessor::Effect::distortion, fx.distortionEnabled);
+
+    liveLooper.clearAll();
+    for (int i = 0; i < LiveLooper::numTracks; ++i)
+    {
+        const auto track = (size_t)i < data.looper.size() ? data.looper[(size_t)i] : ProjectData::LooperData();
+        liveLooper.setTrackGain(i, track.loopGain);
+        liveLooper.setTrackMuted(i, track.muted);
+        liveLooper.setTrackReversed(i, track.reversed);
+        liveLooper.setLengthFactor(i, track.lengthFactor);
+    }
+
+    // Decode now or in the background, handing the result and the rate it
+    // was recorded at over on the message thread
+    auto restore = [this, waitForAudio](const juce::String& key, std::function<void(SamplePool::BufferPtr, double)> onLoaded)
+    {
+        auto withRate = [this, key, onLoaded](SamplePool::BufferPtr audio)
+        {
+            onLoaded(std::move(audio), samplePool.getSampleRate(key));
+        };
+
+        if (waitForAudio)
+            withRate(samplePool.getBuffer(key));
+        else
+            samplePool.preload(key, std::move(withRate));
+    };
+
+    // The loops go in together once all are decoded, in whatever order
+    // that happens, so the master can go first. The extra count holds them
+    // back until every decode has been asked for.
+    auto loops = std::make_shared<std::vector<LoadedLoop>>(data.looper.size());
+    auto numPending = std::make_shared<int>(1);
+    auto loadLoops = [this, tracks = data.looper, masterLength = data.looperMasterLength, loops, numPending]
+    {
+        if (--*numPending == 0)
+            restoreLoops(tracks, *loops, masterLength);
+    };
+
+    for (size_t i = 0; i < data.looper.size(); ++i)
+    {
+        const auto& audio = data.looper[i].audio;
+        if (audio.buffer != nullptr)
+        {
+            (*loops)[i] = { audio.buffer, audio.sampleRate };
+        }
+        else if (audio.key.isNotEmpty())
+        {
+            ++*numPending;
+            restore(audio.key, [loops, i, loadLoops](SamplePool::BufferPtr buffer, double sampleRate)
+            {
+                (*loops)[i] = { std::move(buffer), sampleRate };
+                loadLoops();
+            });
+        }
+    }
+
+    loadLoops();
+
+    // One slice table for the audio thread, not one per slice
+    std::vector<Slice> slices;
+    for (size_t i = 0; i < data.slicer.sliceNames.size(); ++i)
+    {
+        Slice slice;
+        slice.startTime = i < data.slicer.sliceStartTimes.size() ? data.slicer.sliceStartTimes[i] : 0.0;
+        slice.endTime = i < data.slicer.sliceEndTimes.size() ? data.slicer.sliceEndTimes[i] : 0.0;
+        slice.name = data.slicer.sliceNames[i];
+        slices.push_back(slice);
+    }
+    sampleSlicer.setSlices(std::move(slices));
+
+    const juce::File sampleFile(data.slicer.sampleFile);
+    auto restoreSample = [this, sampleFile](SamplePool::BufferPtr audio, double sampleRate)
+    {
+        if (audio != nullptr)
+            sampleSlicer.loadSample(*audio, sampleRate, sampleFile);
+    };
+
+    if (data.slicer.sample.buffer != nullptr)
+    {
+        restoreSample(data.slicer.sample.buffer, data.slicer.sample.sampleRate);
+    }
+    else if (data.slicer.sample.key.isNotEmpty())
+    {
+        restore(data.slicer.sample.key, restoreSample);
+    }
+    else if (sampleFile.existsAsFile())
+    {
+        // Older projects only reference the file; decode it through the pool too
+        samplePool.addFile(sampleFile.getFullPathName(), sampleFile);
+        restore(sampleFile.getFullPathName(), restoreSample);
+    }
+}
+
+void AudioEngine::restoreLoops(const std::vector<ProjectData::LooperData>& tracks, const std::vector<LoadedLoop>& loops,
+                               double masterLength)
+{
+    // The first loop loaded sets the master and the rest are rounded to
+    // multiples or divisions of it, so the track as long as the saved
+    // master goes first, or failing that the one nearest to it
+    const int numTracks = juce::jmin((int)loops.size(), LiveLooper::numTracks);
+    int first = -1;
+    double nearest = 0.0;
+
+    for (int i = 0; i < numTracks; ++i)
+    {
+        const double length = tracks[(size_t)i].loopLength;
+        if (loops[(size_t)i].first == nullptr)
+            continue;
+
+        const double distance = masterLength > 0.0 && length > 0.0 ? std::abs(std::log2(length / masterLength)) : 0.0;
+        if (first < 0 || distance < nearest)
+        {
+            first = i;
+            nearest = distance;
+        }
+    }
+
+    if (first < 0)
+        return;
+
+    liveLooper.loadLoop(first, *loops[(size_t)first].first, loops[(size_t)first].second);
+    for (int i = 0; i < numTracks; ++i)
+    {
+        if (i != first && loops[(size_t)i].first != nullptr)
+            liveLooper.loadLoop(i, *loops[(size_t)i].first, loops[(size_t)i].second);
+    }
+
+    // Loading sets each factor from the loop's length; the saved ones are
+    // what the tracks record with next
+    for (int i = 0; i < numTracks; ++i)
+        liveLooper.setLengthFactor(i, tracks[(size_t)i].lengthFactor);
+}
+
+bool AudioEngine::saveProject(const juce::File& file)
+{
+    ProjectData data;
+    captureProjectState(data);
+    projectManager.importProjectData(data);
+    return projectManager.saveProject(file);
+}
+
+bool AudioEngine::loadProject(const juce::File& file, bool waitForAudio)
+{
+    if (!projectManager.loadProject(file))
+        return false;
+
+    ProjectData data;
+    projectManager.exportProjectData(data);
+    applyProjectState(data, waitForAudio);
+    return true;
+}
@@ -1,17 +1,59 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AudioArena.h"
 #include "EffectsProcessor.h"
+#include "AuxBus.h"
+#include "DSPProfiler.h"
+#include "XrunMonitor.h"
+#include "MasterDynamics.h"
 #include "LiveLooper.h"
 #include "Sequencer.h"
 #include "SampleSlicer.h"
 #include "MIDIController.h"
 #include "ProjectManager.h"
+#include "SamplePool.h"
+#include "ClipLauncher.h"
+#include "EngineSnapshot.h"
+#include "TripleBuffer.h"
 
+// The whole mixer and effects graph as one AudioSource. It owns no audio
+// device: AudioDeviceHost plays it through the sound card, OfflineRenderer
+// pulls blocks from it as fast as it can.
 class AudioEngine : public juce::AudioSource
 {
 public:
-    AudioEngine();
+    // Sources that render into their own buffer, each through its own insert
+    // chain, before being summed into the master effects
+    enum class Track
+    {
+        filePlayer,
+        looper,
+        sequencer,
+        slicer
+    };
+
+    static constexpr int numTracks = 4;
+
+    // Shared effects fed by per-track sends
+    enum class Bus
+    {
+        reverb,
+        delay
+    };
+
+    static constexpr int numBuses = 2;
+
+    // A live engine plays through a device, talks MIDI and watches for
+    // dropouts. A headless one, e.g. for offline rendering, never touches a
+    // MIDI device and starts none of the threads or timers those need.
+    enum class Mode
+    {
+        live,
+        headless
+    };
+
+    explicit AudioEngine(Mode mode = Mode::live);
     ~AudioEngine() override;
 
     // AudioSource methods
@@ -19,20 +61,53 @@ public:
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
     void releaseResources() override;
 
+    // The device the engine is playing through, for latency and xrun counts;
+    // nullptr when rendering offline. Set before prepareToPlay.
+    void setAudioDevice(juce::AudioIODevice* device) { currentDevice = device; }
+
     // Audio file management
     bool loadAudioFile(const juce::File& file);
     void unloadAudioFile();
 
+    // The memory loops, the slicer's sample and effect delay lines are taken
+    // from. prepareToPlay reserves AudioArena::defaultBudget unless it has
+    // been reserved already, so reserve here first for another budget.
+    AudioArena& getAudioArena() { return audioArena; }
+
     // Playback control
     void startPlayback();
     void stopPlayback();
     void setLooping(bool shouldLoop);
     void setGain(float newGain);
 
+    // A muted track keeps running, so it stays in time, but is not heard
+    void setTrackMuted(Track track, bool muted) { trackMuted[(size_t)track] = muted; }
+    bool isTrackMuted(Track track) const { return trackMuted[(size_t)track].load(); }
+    static juce::String getTrackName(Track track);
+
     // Effects control
     EffectsProcessor& getEffectsProcessor() { return effectsProcessor; }
     void setEffectsEnabled(bool enabled) { effectsProcessor.setEffectEnabled(enabled); }
     bool isEffectsEnabled() const { return effectsProcessor.isEffectEnabled(); }
+    EffectChain& getTrackEffects(Track track) { return trackEffects[(size_t)track]; }
+    AuxBus& getAuxBus(Bus bus) { return auxBuses[(size_t)bus]; }
+    void setTrackSend(Track track, Bus bus, float level) { auxBuses[(size_t)bus].setSendLevel((int)track, level); }
+    float getTrackSend(Track track, Bus bus) const { return auxBuses[(size_t)bus].getSendLevel((int)track); }
+
+    // Compressor and limiter on the final mix, after the master effects
+    MasterDynamics& getMasterDynamics() { return masterDynamics; }
+
+    // Time spent per source and effect node, relative to the block duration
+    DSPProfiler& getProfiler() { return profiler; }
+
+    // Dropouts, with the node timings and graph state of the block behind each
+    XrunMonitor& getXrunMonitor() { return xrunMonitor; }
+
+    // Playheads and transport state for the UI, captured on the audio thread
+    // uiSnapshotRateHz times a second. Message thread; returns false when
+    // nothing new has been captured since the last call.
+    static constexpr double uiSnapshotRateHz = 120.0;
+    bool readUISnapshot(EngineSnapshot& destination) { return uiSnapshots.read(destination); }
 
     // Live looper access
     LiveLooper& getLiveLooper() { return liveLooper; }
@@ -48,19 +123,72 @@ public:
     
     // Project manager access
     ProjectManager& getProjectManager() { return projectManager; }
+    SamplePool& getSamplePool() { return samplePool; }
+
+    // Session grid, played on top of each track's own source through its
+    // inserts and sends
+    ClipLauncher& getClipLauncher() { return clipLauncher; }
+
+    // Turns what a track holds now into a clip in the given scene: the
+    // player's file or the looper's layers as a loop, the sequencer's
+    // steps as a pattern, the slicer's sample and slices as a slice set.
+    // The audio is registered in the sample pool. Message thread; returns
+    // false if the track has nothing to capture.
+    bool captureClip(Track track, int scene);
+
+    // Project state. Capture is cheap: recorded audio is shared, not copied.
+    // Applying starts background decodes for embedded audio, which is handed
+    // to the looper and slicer on the message thread once ready, unless
+    // waitForAudio is set: then it decodes on the calling thread, which is
+    // what headless use without a message loop needs.
+    void captureProjectState(ProjectData& data);
+    void applyProjectState(const ProjectData& data, bool waitForAudio = false);
+    bool saveProject(const juce::File& file);
+    bool loadProject(const juce::File& file, bool waitForAudio = false);
 
 private:
+    // First, so it outlives every buffer taken from it
+    AudioArena audioArena;
+    const Mode mode;
+
     std::unique_ptr<juce::AudioFormatReader> audioFileReader;
     std::unique_ptr<juce::AudioFormatReaderSource> audioSource;
     juce::AudioTransportSource transportSource;
     juce::AudioFormatManager formatManager;
-    juce::AudioDeviceManager deviceManager;
+    SamplePool samplePool;
+    ClipLauncher clipLauncher { samplePool };
+    juce::File audioFile;
     EffectsProcessor effectsProcessor;
     LiveLooper liveLooper;
     Sequencer sequencer;
     SampleSlicer sampleSlicer;
     MIDIController midiController;
     ProjectManager projectManager;
+    juce::MidiBuffer incomingMidi;
+    juce::MidiBuffer blockMidi;
+
+    std::array<EffectChain, numTracks> trackEffects;
+    std::array<AuxBus, numBuses> auxBuses;
+    MasterDynamics masterDynamics;
+    DSPProfiler profiler;
+    XrunMonitor xrunMonitor;
+    juce::AudioIODevice* currentDevice = nullptr;
+    TripleBuffer<EngineSnapshot> uiSnapshots;
+    double currentSampleRate = 44100.0;
+    int samplesUntilSnapshot = 0;
+    juce::uint32 snapshotSerial = 0;
+    juce::AudioBuffer<float> trackBuffer;
+    juce::AudioBuffer<float> inputBuffer;
+    std::array<std::atomic<bool>, numTracks> trackMuted {};
+
+    // A decoded loop and the rate it was recorded at
+    using LoadedLoop = std::pair<SamplePool::BufferPtr, double>;
+
+    void renderTracks(const juce::AudioSourceChannelInfo& bufferToFill, const juce::MidiBuffer& midi);
+    void checkForXruns(int numSamples);
+    void captureUISnapshot(int numSamples);
+    void restoreLoops(const std::vector<ProjectData::LooperData>& tracks, const std::vector<LoadedLoop>& loops,
+                      double masterLength);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioEngine)
 }; 
\ No newline at end of file
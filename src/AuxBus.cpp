@@ -0,0 +1,117 @@
+#include "AuxBus.h"
+
+AuxBus::AuxBus()
+    : returnLevel(1.0f), lastReturnGain(1.0f), blockSize(0), hasInput(false), idle(true),
+      silentSamples(0)
+{
+    for (auto& level : sendLevels)
+        level = 0.0f;
+
+    lastSendGains.fill(0.0f);
+}
+
+AuxBus::~AuxBus()
+{
+}
+
+void AuxBus::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    effects.prepare(spec);
+    busBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+    reset();
+}
+
+void AuxBus::reset()
+{
+    effects.reset();
+    busBuffer.clear();
+
+    for (size_t i = 0; i < lastSendGains.size(); ++i)
+        lastSendGains[i] = sendLevels[i].load();
+
+    lastReturnGain = returnLevel.load();
+    idle = true;
+    silentSamples = 0;
+}
+
+void AuxBus::setSendLevel(int source, float level)
+{
+    if (juce::isPositiveAndBelow(source, maxSources))
+        sendLevels[(size_t)source] = juce::jmax(0.0f, level);
+}
+
+float AuxBus::getSendLevel(int source) const
+{
+    return juce::isPositiveAndBelow(source, maxSources) ? sendLevels[(size_t)source].load() : 0.0f;
+}
+
+void AuxBus::beginBlock(int numSamples)
+{
+    blockSize = juce::jmin(numSamples, busBuffer.getNumSamples());
+    hasInput = false;
+
+    if (!idle)
+        busBuffer.clear(0, blockSize);
+}
+
+void AuxBus::addSend(int source, const juce::AudioBuffer<float>& sourceBuffer, int numSamples)
+{
+    if (!juce::isPositiveAndBelow(source, maxSources))
+        return;
+
+    auto& lastGain = lastSendGains[(size_t)source];
+    const float gain = sendLevels[(size_t)source].load();
+
+    if (gain == 0.0f && lastGain == 0.0f)
+        return;
+
+    if (idle)
+    {
+        busBuffer.clear(0, blockSize);
+        idle = false;
+    }
+
+    // Ramp from the last block's level so send changes don't click
+    const int numToAdd = juce::jmin(numSamples, blockSize);
+    for (int ch = 0; ch < busBuffer.getNumChannels(); ++ch)
+    {
+        const int sourceChannel = juce::jmin(ch, sourceBuffer.getNumChannels() - 1);
+        busBuffer.addFromWithRamp(ch, 0, sourceBuffer.getReadPointer(sourceChannel), numToAdd, lastGain, gain);
+    }
+
+    lastGain = gain;
+    hasInput = true;
+}
+
+void AuxBus::addReturnTo(const juce::AudioSourceChannelInfo& destination)
+{
+    if (idle)
+        return;
+
+    auto block = juce::dsp::AudioBlock<float>(busBuffer).getSubBlock(0, (size_t)blockSize);
+    effects.process(block);
+
+    const float gain = returnLevel.load();
+    const int numSamples = juce::jmin(blockSize, destination.numSamples);
+    const int numChannels = juce::jmin(destination.buffer->getNumChannels(), busBuffer.getNumChannels());
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        destination.buffer->addFromWithRamp(ch, destination.startSample, busBuffer.getReadPointer(ch),
+                                            numSamples, lastReturnGain, gain);
+
+    lastReturnGain = gain;
+
+    // With nothing sent, keep running until the return has been silent for a
+    // whole tail, not just between two delay repeats. What the chain still
+    // holds is cleared, so it cannot play out when a send comes back.
+    if (hasInput || busBuffer.getMagnitude(0, blockSize) >= EffectUnit::silenceThreshold)
+    {
+        silentSamples = 0;
+    }
+    else if ((silentSamples += blockSize) >= effects.getTailSamples())
+    {
+        effects.clearState();
+        silentSamples = 0;
+        idle = true;
+    }
+}
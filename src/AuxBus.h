@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "EffectChain.h"
+
+// A send/return bus. Sources add a scaled copy of their signal each block,
+// the sum runs through one shared effect chain (set up 100% wet) and the
+// return is mixed into the master. When nothing is sent and the return has
+// stayed silent for as long as the chain can hold sound, the chain is
+// cleared and the bus is skipped.
+class AuxBus
+{
+public:
+    static constexpr int maxSources = 16;
+
+    AuxBus();
+    ~AuxBus();
+
+    // Called with the audio stopped
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    EffectChain& getEffects() { return effects; }
+
+    // Message thread
+    void setSendLevel(int source, float level);
+    float getSendLevel(int source) const;
+    void setReturnLevel(float level) { returnLevel = level; }
+    float getReturnLevel() const { return returnLevel.load(); }
+
+    // Audio thread, once per block: beginBlock, addSend for each source,
+    // then addReturnTo
+    void beginBlock(int numSamples);
+    void addSend(int source, const juce::AudioBuffer<float>& sourceBuffer, int numSamples);
+    void addReturnTo(const juce::AudioSourceChannelInfo& destination);
+
+    bool isIdle() const { return idle; }
+
+private:
+    EffectChain effects;
+    juce::AudioBuffer<float> busBuffer;
+
+    std::array<std::atomic<float>, maxSources> sendLevels;
+    std::array<float, maxSources> lastSendGains;   // Audio thread only
+    std::atomic<float> returnLevel;
+    float lastReturnGain;
+
+    int blockSize;
+    bool hasInput;
+    bool idle;
+    int silentSamples;      // Of the return, in a row
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AuxBus)
+};
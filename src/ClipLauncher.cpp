@@ -0,0 +1,483 @@
+#include "ClipLauncher.h"
+
+int ClipLauncher::Clip::getNumSteps() const
+{
+    switch (type)
+    {
+        case ClipType::loop:    return 0;
+        case ClipType::pattern: return (int)stepVelocities.size();
+        case ClipType::slices:  return (int)sliceSteps.size();
+    }
+
+    return 0;
+}
+
+ClipLauncher::ClipLauncher(SamplePool& pool)
+    : samplePool(pool)
+{
+    for (auto& request : requestedScenes)
+        request = nothingQueued;
+
+    for (auto& scene : playingScenes)
+        scene = stopped;
+
+    // The audio thread always finds a grid, even an empty one
+    publishGrid();
+}
+
+ClipLauncher::~ClipLauncher()
+{
+}
+
+void ClipLauncher::setClip(int track, int scene, Clip clip, bool waitForAudio)
+{
+    if (!juce::isPositiveAndBelow(track, numTracks) || !juce::isPositiveAndBelow(scene, numScenes))
+        return;
+
+    auto& slot = slots[(size_t)track][(size_t)scene];
+    const int generation = ++slot.generation;
+
+    // Only patterns can do without audio; they play a trigger pulse instead
+    if (clip.sampleKey.isEmpty())
+    {
+        if (clip.type == ClipType::pattern)
+            install(track, scene, std::make_shared<const Clip>(std::move(clip)));
+        else
+            install(track, scene, nullptr);
+        return;
+    }
+
+    auto onLoaded = [safeThis = juce::WeakReference<ClipLauncher>(this), track, scene, generation, clip](SamplePool::BufferPtr audio) mutable
+    {
+        if (safeThis == nullptr || safeThis->slots[(size_t)track][(size_t)scene].generation != generation)
+            return;
+
+        if (audio == nullptr)
+        {
+            safeThis->install(track, scene, nullptr);
+            return;
+        }
+
+        clip.audio = std::move(audio);
+        clip.audioSampleRate = safeThis->samplePool.getSampleRate(clip.sampleKey);
+        safeThis->install(track, scene, std::make_shared<const Clip>(std::move(clip)));
+    };
+
+    if (auto audio = samplePool.getBufferIfLoaded(clip.sampleKey))
+    {
+        onLoaded(std::move(audio));
+    }
+    else if (waitForAudio)
+    {
+        onLoaded(samplePool.getBuffer(clip.sampleKey));
+    }
+    else
+    {
+        // Until the audio is in memory the slot is empty to the audio thread
+        slot.clip = nullptr;
+        slot.loading = true;
+        publishGrid();
+        samplePool.preload(clip.sampleKey, std::move(onLoaded));
+    }
+}
+
+void ClipLauncher::clearClip(int track, int scene)
+{
+    if (!juce::isPositiveAndBelow(track, numTracks) || !juce::isPositiveAndBelow(scene, numScenes))
+        return;
+
+    ++slots[(size_t)track][(size_t)scene].generation;
+    install(track, scene, nullptr);
+}
+
+void ClipLauncher::clearAll()
+{
+    for (auto& trackSlots : slots)
+    {
+        for (auto& slot : trackSlots)
+        {
+            ++slot.generation;
+            slot.clip = nullptr;
+            slot.loading = false;
+        }
+    }
+
+    publishGrid();
+}
+
+ClipLauncher::SlotState ClipLauncher::getSlotState(int track, int scene) const
+{
+    if (!juce::isPositiveAndBelow(track, numTracks) || !juce::isPositiveAndBelow(scene, numScenes))
+        return SlotState::empty;
+
+    const auto& slot = slots[(size_t)track][(size_t)scene];
+    if (slot.clip != nullptr)
+        return SlotState::ready;
+
+    return slot.loading ? SlotState::loading : SlotState::empty;
+}
+
+const ClipLauncher::Clip* ClipLauncher::getClip(int track, int scene) const
+{
+    if (!juce::isPositiveAndBelow(track, numTracks) || !juce::isPositiveAndBelow(scene, numScenes))
+        return nullptr;
+
+    return slots[(size_t)track][(size_t)scene].clip.get();
+}
+
+void ClipLauncher::install(int track, int scene, ClipPtr clip)
+{
+    auto& slot = slots[(size_t)track][(size_t)scene];
+    slot.clip = std::move(clip);
+    slot.loading = false;
+    publishGrid();
+}
+
+void ClipLauncher::publishGrid()
+{
+    // A copy of the shared pointers: clips are shared between grids, and the
+    // last reference to a replaced clip goes with a retired grid, which only
+    // the message thread deletes
+    auto newGrid = std::make_unique<Grid>();
+    for (size_t track = 0; track < (size_t)numTracks; ++track)
+        for (size_t scene = 0; scene < (size_t)numScenes; ++scene)
+            (*newGrid)[track][scene] = { slots[track][scene].clip, slots[track][scene].generation };
+
+    publishedGrid.publish(std::move(newGrid));
+}
+
+void ClipLauncher::launchClip(int track, int scene)
+{
+    if (juce::isPositiveAndBelow(track, numTracks) && juce::isPositiveAndBelow(scene, numScenes))
+        requestedScenes[(size_t)track] = scene;
+}
+
+void ClipLauncher::launchScene(int scene)
+{
+    if (juce::isPositiveAndBelow(scene, numScenes))
+        requestedScene = scene;
+}
+
+void ClipLauncher::stopTrack(int track)
+{
+    if (juce::isPositiveAndBelow(track, numTracks))
+        requestedScenes[(size_t)track] = stopped;
+}
+
+void ClipLauncher::stopAll()
+{
+    requestedScene = stopped;
+}
+
+int ClipLauncher::getQueuedScene(int track) const
+{
+    const int scene = requestedScene.load();
+    if (scene != nothingQueued)
+        return scene;
+
+    return requestedScenes[(size_t)track].load();
+}
+
+void ClipLauncher::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    beatPosition = 0.0;
+    launchOffset = -1;
+
+    for (int i = 0; i < numTracks; ++i)
+    {
+        tracks[(size_t)i] = {};
+        playingScenes[(size_t)i] = stopped;
+    }
+}
+
+void ClipLauncher::beginBlock(int numSamples, double tempo, double transportBeat)
+{
+    grid = publishedGrid.acquire();
+    blockSize = numSamples;
+    samplesPerBeat = sampleRate * 60.0 / juce::jmax(1.0, tempo);
+    launchOffset = -1;
+
+    if (transportBeat >= 0.0)
+        beatPosition = transportBeat;
+
+    // Follow slots replaced or cleared on the message thread since the last block
+    for (int i = 0; i < numTracks; ++i)
+    {
+        auto& state = tracks[(size_t)i];
+        const int scene = playingScenes[(size_t)i].load();
+        const GridSlot* slot = scene >= 0 && grid != nullptr ? &(*grid)[(size_t)i][(size_t)scene] : nullptr;
+        const Clip* clip = slot != nullptr ? slot->clip.get() : nullptr;
+
+        // Compared by generation too: a new clip can be allocated where a
+        // freed one was, and must not inherit its voice or step
+        if (clip == state.clip && (clip == nullptr || slot->generation == state.generation))
+            continue;
+
+        if (clip == nullptr)
+        {
+            state = {};
+            playingScenes[(size_t)i] = stopped;
+        }
+        else
+        {
+            state.clip = clip;
+            state.generation = slot->generation;
+            state.voiceActive = false;
+            state.voiceEnd = 0;
+        }
+    }
+
+    if (!hasPendingRequests())
+        return;
+
+    // The epsilon keeps a launch point that falls exactly on a block boundary
+    // from being pushed back a whole quantum by rounding
+    const double quantum = launchQuantum.load();
+    double offset = 0.0;
+    if (quantum > 0.0)
+    {
+        const double launchBeat = std::ceil(beatPosition / quantum - 1.0e-9) * quantum;
+        offset = juce::jmax(0.0, (launchBeat - beatPosition) * samplesPerBeat);
+    }
+
+    if (offset < (double)numSamples)
+    {
+        launchOffset = (int)offset;
+        takeRequests();
+    }
+}
+
+void ClipLauncher::renderTrack(int track, juce::AudioBuffer<float>& buffer, int numSamples)
+{
+    auto& state = tracks[(size_t)track];
+    const int scene = launchOffset >= 0 ? launchScenes[(size_t)track] : nothingQueued;
+
+    if (scene == nothingQueued)
+    {
+        render(state, buffer, 0, numSamples);
+        return;
+    }
+
+    // Switch sample-accurately, at the same offset on every track
+    render(state, buffer, 0, launchOffset);
+    startClip(track, scene);
+    render(state, buffer, launchOffset, numSamples - launchOffset);
+}
+
+void ClipLauncher::endBlock()
+{
+    beatPosition += (double)blockSize / samplesPerBeat;
+    publishedGrid.release();
+    grid = nullptr;
+}
+
+bool ClipLauncher::hasPendingRequests() const
+{
+    if (requestedScene.load() != nothingQueued)
+        return true;
+
+    for (auto& request : requestedScenes)
+        if (request.load() != nothingQueued)
+            return true;
+
+    return false;
+}
+
+void ClipLauncher::takeRequests()
+{
+    const int scene = requestedScene.exchange(nothingQueued);
+
+    for (int i = 0; i < numTracks; ++i)
+    {
+        int request = requestedScenes[(size_t)i].exchange(nothingQueued);
+        if (scene != nothingQueued)
+            request = scene;
+
+        // An empty slot stops its track in a scene launch, and is ignored
+        // when launched on its own
+        if (request >= 0 && (grid == nullptr || (*grid)[(size_t)i][(size_t)request].clip == nullptr))
+            request = scene != nothingQueued ? stopped : nothingQueued;
+
+        launchScenes[(size_t)i] = request;
+    }
+}
+
+void ClipLauncher::startClip(int track, int scene)
+{
+    auto& state = tracks[(size_t)track];
+    state = {};
+
+    if (scene >= 0 && grid != nullptr)
+    {
+        const auto& slot = (*grid)[(size_t)track][(size_t)scene];
+        state.clip = slot.clip.get();
+        state.generation = slot.generation;
+    }
+
+    playingScenes[(size_t)track] = state.clip != nullptr ? scene : stopped;
+}
+
+void ClipLauncher::render(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (state.clip == nullptr || numSamples <= 0)
+        return;
+
+    if (state.clip->type == ClipType::loop)
+        renderLoop(state, buffer, startSample, numSamples);
+    else
+        renderSteps(state, buffer, startSample, numSamples);
+}
+
+void ClipLauncher::renderLoop(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    const auto& clip = *state.clip;
+    state.position += numSamples;
+
+    if (clip.audio == nullptr || clip.audio->getNumChannels() == 0)
+        return;
+
+    const auto& audio = *clip.audio;
+    const int audioLength = audio.getNumSamples();
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+    const double loopLength = juce::jmax(1.0, clip.lengthBeats * samplesPerBeat);
+    const double increment = clip.audioSampleRate > 0.0 ? clip.audioSampleRate / sampleRate : 1.0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* in = audio.getReadPointer(juce::jmin(ch, audio.getNumChannels() - 1));
+        float* out = buffer.getWritePointer(ch, startSample);
+        double position = state.loopPosition;
+
+        // Audio shorter than the loop leaves silence until it comes round
+        // again; longer audio is cut off at the loop length
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const double readPosition = position * increment;
+            const int index = (int)readPosition;
+
+            if (index + 1 < audioLength)
+            {
+                const float fraction = (float)(readPosition - index);
+                out[i] += clip.gain * (in[index] + fraction * (in[index + 1] - in[index]));
+            }
+
+            position += 1.0;
+            if (position >= loopLength)
+                position -= loopLength;
+        }
+    }
+
+    state.loopPosition = std::fmod(state.loopPosition + numSamples, loopLength);
+}
+
+void ClipLauncher::renderSteps(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    const double stepLength = samplesPerBeat / juce::jmax(1, state.clip->stepsPerBeat);
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        if ((double)state.position >= state.nextStepSample)
+        {
+            triggerStep(state);
+            state.nextStepSample += stepLength;
+            continue;
+        }
+
+        const int run = juce::jmin(numSamples - done, (int)std::ceil(state.nextStepSample - (double)state.position));
+        renderVoice(state, buffer, startSample + done, run);
+        state.position += run;
+        done += run;
+    }
+}
+
+void ClipLauncher::triggerStep(TrackState& state)
+{
+    const auto& clip = *state.clip;
+    const int numSteps = clip.getNumSteps();
+    if (numSteps == 0)
+        return;
+
+    const int step = state.step % numSteps;
+    state.step = (step + 1) % numSteps;
+
+    const int audioLength = clip.audio != nullptr ? clip.audio->getNumSamples() : 0;
+
+    if (clip.type == ClipType::pattern)
+    {
+        const float velocity = clip.stepVelocities[(size_t)step];
+        if (velocity <= 0.0f)
+            return;
+
+        // Without audio, the same 10 ms pulse the Sequencer plays
+        state.voicePosition = 0.0;
+        state.voiceEnd = clip.audio != nullptr ? audioLength : (int)(0.01 * sampleRate);
+        state.voiceGain = velocity * clip.gain;
+        state.voiceActive = true;
+    }
+    else
+    {
+        const int slice = clip.sliceSteps[(size_t)step];
+        if (!juce::isPositiveAndBelow(slice, (int)clip.slices.size()))
+            return;
+
+        const auto range = clip.slices[(size_t)slice];
+        state.voicePosition = (double)juce::jmax(0, range.getStart());
+        state.voiceEnd = juce::jmin(range.getEnd(), audioLength);
+        state.voiceGain = clip.gain;
+        state.voiceActive = state.voicePosition < state.voiceEnd;
+    }
+}
+
+void ClipLauncher::renderVoice(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (!state.voiceActive)
+        return;
+
+    const auto& clip = *state.clip;
+    const int numChannels = juce::jmin(2, buffer.getNumChannels());
+
+    if (clip.audio == nullptr)
+    {
+        const int count = juce::jmin(numSamples, state.voiceEnd - (int)state.voicePosition);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* out = buffer.getWritePointer(ch, startSample);
+            for (int i = 0; i < count; ++i)
+                out[i] += state.voiceGain * 0.5f;
+        }
+
+        state.voicePosition += count;
+        state.voiceActive = (int)state.voicePosition < state.voiceEnd;
+        return;
+    }
+
+    const auto& audio = *clip.audio;
+    if (audio.getNumChannels() == 0)
+    {
+        state.voiceActive = false;
+        return;
+    }
+
+    const double increment = clip.audioSampleRate > 0.0 ? clip.audioSampleRate / sampleRate : 1.0;
+    const int count = juce::jlimit(0, numSamples, (int)std::ceil((state.voiceEnd - 1 - state.voicePosition) / increment));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* in = audio.getReadPointer(juce::jmin(ch, audio.getNumChannels() - 1));
+        float* out = buffer.getWritePointer(ch, startSample);
+        double position = state.voicePosition;
+
+        for (int i = 0; i < count; ++i)
+        {
+            const int index = (int)position;
+            const float fraction = (float)(position - index);
+            out[i] += state.voiceGain * (in[index] + fraction * (in[index + 1] - in[index]));
+            position += increment;
+        }
+    }
+
+    state.voicePosition += count * increment;
+    state.voiceActive = count > 0 && state.voicePosition < state.voiceEnd - 1;
+}
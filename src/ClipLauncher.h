@@ -0,0 +1,173 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplePool.h"
+#include "RealtimeObject.h"
+
+// Session grid of clip slots, one column per engine track and one row per
+// scene. A slot holds a loop, a step pattern playing a one-shot, or a slice
+// set stepping through ranges of one sample. Launches wait for the next
+// launch quantum; launching a scene switches every track at the same sample,
+// stopping those whose slot in that scene is empty.
+//
+// Clip audio always comes from the sample pool. A slot only becomes
+// launchable once its audio is decoded, and the grid the audio thread reads
+// is an immutable copy published through a RealtimeObject, so a launch is a
+// pointer swap with no I/O or allocation.
+class ClipLauncher
+{
+public:
+    static constexpr int numTracks = 4;    // One per AudioEngine::Track
+    static constexpr int numScenes = 8;
+
+    enum class ClipType
+    {
+        loop,       // Plays the audio, repeating every lengthBeats
+        pattern,    // Each step with a velocity retriggers the audio
+        slices      // Each step plays one range of the audio
+    };
+
+    struct Clip
+    {
+        ClipType type = ClipType::loop;
+        juce::String name;
+        juce::String sampleKey;             // Audio in the sample pool; none for a pattern plays a trigger pulse
+        float gain = 1.0f;
+
+        double lengthBeats = 4.0;           // Loops only
+        int stepsPerBeat = 4;               // Patterns and slice sets
+        std::vector<float> stepVelocities;  // Patterns: 0 rests
+        std::vector<juce::Range<int>> slices;   // Slice sets: sample ranges of the audio
+        std::vector<int> sliceSteps;        // Slice sets: slice per step, -1 rests
+
+        // Filled in from the pool when the slot is set
+        SamplePool::BufferPtr audio;
+        double audioSampleRate = 0.0;
+
+        int getNumSteps() const;
+    };
+
+    enum class SlotState
+    {
+        empty,
+        loading,
+        ready
+    };
+
+    // Scene values for a track that is not playing, or has no launch queued
+    static constexpr int stopped = -1;
+    static constexpr int nothingQueued = -2;
+
+    explicit ClipLauncher(SamplePool& pool);
+    ~ClipLauncher();
+
+    // Message thread. The clip's audio is decoded through the pool first, in
+    // the background unless waitForAudio is set; a slot replaced meanwhile
+    // ignores the late result.
+    void setClip(int track, int scene, Clip clip, bool waitForAudio = false);
+    void clearClip(int track, int scene);
+    void clearAll();
+    SlotState getSlotState(int track, int scene) const;
+    const Clip* getClip(int track, int scene) const;
+
+    // Any thread. Requests take effect at the next multiple of the launch
+    // quantum on the sequencer's beat grid, so clips land on its bars; with
+    // the sequencer stopped the grid carries on from where it left off, or
+    // counts from when the audio started. 0 switches at the start of the
+    // next block.
+    void launchClip(int track, int scene);
+    void launchScene(int scene);
+    void stopTrack(int track);
+    void stopAll();
+    void setLaunchQuantum(double beats) { launchQuantum = juce::jmax(0.0, beats); }
+    double getLaunchQuantum() const { return launchQuantum.load(); }
+
+    // What each track is playing, and what it will switch to at the next
+    // launch point. A scene launch overrides clip launches queued with it.
+    int getPlayingScene(int track) const { return playingScenes[(size_t)track].load(); }
+    int getQueuedScene(int track) const;
+
+    // Called with the audio stopped
+    void prepare(double sampleRate);
+
+    // Audio thread, once per block: beginBlock, renderTrack for each track,
+    // then endBlock. Clip audio is added to what the track already holds.
+    // transportBeat is the sequencer's position in beats, negative while it
+    // is stopped.
+    void beginBlock(int numSamples, double tempo, double transportBeat = -1.0);
+    void renderTrack(int track, juce::AudioBuffer<float>& buffer, int numSamples);
+    void endBlock();
+
+private:
+    using ClipPtr = std::shared_ptr<const Clip>;
+
+    struct Slot
+    {
+        ClipPtr clip;
+        bool loading = false;
+        int generation = 0;
+    };
+
+    // A slot as the audio thread sees it. The generation tells a replaced
+    // clip from the one before it, even at a reused address.
+    struct GridSlot
+    {
+        ClipPtr clip;
+        int generation = 0;
+    };
+
+    using Grid = std::array<std::array<GridSlot, numScenes>, numTracks>;
+
+    struct TrackState
+    {
+        const Clip* clip = nullptr;     // Looked up in the grid every block
+        int generation = 0;             // Of the slot the clip came from
+        double loopPosition = 0.0;      // Samples into the loop
+        double nextStepSample = 0.0;    // Samples from the launch until the next step
+        juce::int64 position = 0;       // Samples since the launch
+        int step = 0;
+
+        // Patterns and slice sets play one voice at a time
+        bool voiceActive = false;
+        double voicePosition = 0.0;
+        int voiceEnd = 0;
+        float voiceGain = 0.0f;
+    };
+
+    SamplePool& samplePool;
+
+    // Message thread
+    std::array<std::array<Slot, numScenes>, numTracks> slots;
+    RealtimeObject<Grid> publishedGrid;
+
+    // Requests, consumed at the next launch point
+    std::array<std::atomic<int>, numTracks> requestedScenes;
+    std::atomic<int> requestedScene { nothingQueued };
+    std::atomic<double> launchQuantum { 4.0 };
+    std::array<std::atomic<int>, numTracks> playingScenes;
+
+    // Audio thread only
+    std::array<TrackState, numTracks> tracks;
+    std::array<int, numTracks> launchScenes {};     // Taken from the requests at the launch point
+    const Grid* grid = nullptr;
+    double sampleRate = 44100.0;
+    double samplesPerBeat = 22050.0;
+    double beatPosition = 0.0;          // The launch grid, following the transport
+    int launchOffset = -1;              // Where in this block the launch happens, -1 if not
+    int blockSize = 0;
+
+    void install(int track, int scene, ClipPtr clip);
+    void publishGrid();
+
+    bool hasPendingRequests() const;
+    void takeRequests();
+    void startClip(int track, int scene);
+    void render(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void renderLoop(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void renderSteps(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void renderVoice(TrackState& state, juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void triggerStep(TrackState& state);
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(ClipLauncher)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ClipLauncher)
+};
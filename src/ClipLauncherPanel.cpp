@@ -0,0 +1,163 @@
+#include "ClipLauncherPanel.h"
+
+ClipLauncherPanel::ClipLauncherPanel(AudioEngine& engine)
+    : audioEngine(engine),
+      clipLauncher(engine.getClipLauncher())
+{
+    for (int track = 0; track < numTracks; ++track)
+    {
+        trackLabels[(size_t)track].setText(AudioEngine::getTrackName((AudioEngine::Track)track), juce::dontSendNotification);
+        trackLabels[(size_t)track].setJustificationType(juce::Justification::centred);
+        addAndMakeVisible(trackLabels[(size_t)track]);
+
+        for (int scene = 0; scene < numScenes; ++scene)
+        {
+            auto& button = slotButtons[(size_t)track][(size_t)scene];
+            button.onClick = [this, track, scene] { slotClicked(track, scene); };
+            addAndMakeVisible(button);
+        }
+
+        stopButtons[(size_t)track].setButtonText("Stop");
+        stopButtons[(size_t)track].onClick = [this, track] { clipLauncher.stopTrack(track); };
+        addAndMakeVisible(stopButtons[(size_t)track]);
+    }
+
+    for (int scene = 0; scene < numScenes; ++scene)
+    {
+        sceneButtons[(size_t)scene].setButtonText("Scene " + juce::String(scene + 1));
+        sceneButtons[(size_t)scene].onClick = [this, scene] { clipLauncher.launchScene(scene); };
+        addAndMakeVisible(sceneButtons[(size_t)scene]);
+    }
+
+    stopAllButton.setButtonText("Stop All");
+    stopAllButton.onClick = [this] { clipLauncher.stopAll(); };
+    addAndMakeVisible(stopAllButton);
+
+    deleteButton.setButtonText("Delete");
+    addAndMakeVisible(deleteButton);
+
+    // Launch quantum in beats
+    quantumBox.addItem("Now", 1);
+    quantumBox.addItem("1 Beat", 2);
+    quantumBox.addItem("1 Bar", 3);
+    quantumBox.addItem("2 Bars", 4);
+    quantumBox.setSelectedId(3, juce::dontSendNotification);
+    quantumBox.onChange = [this]
+    {
+        const double beats[] = { 0.0, 1.0, 4.0, 8.0 };
+        clipLauncher.setLaunchQuantum(beats[juce::jlimit(0, 3, quantumBox.getSelectedId() - 1)]);
+    };
+    addAndMakeVisible(quantumBox);
+
+    updateSlots();
+}
+
+ClipLauncherPanel::~ClipLauncherPanel()
+{
+}
+
+void ClipLauncherPanel::paint(juce::Graphics& g)
+{
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+}
+
+void ClipLauncherPanel::resized()
+{
+    auto area = getLocalBounds().reduced(4);
+
+    // Options along the top, stop buttons along the bottom, scene buttons
+    // down the right
+    auto optionsArea = area.removeFromTop(36);
+    stopAllButton.setBounds(optionsArea.removeFromRight(100).reduced(2));
+    quantumBox.setBounds(optionsArea.removeFromRight(110).reduced(2));
+    deleteButton.setBounds(optionsArea.removeFromLeft(100).reduced(2));
+
+    auto labelArea = area.removeFromTop(20);
+    auto stopArea = area.removeFromBottom(36);
+    auto sceneArea = area.removeFromRight(90);
+    stopArea.removeFromRight(90);
+    labelArea.removeFromRight(90);
+
+    const int columnWidth = area.getWidth() / numTracks;
+    const int rowHeight = area.getHeight() / numScenes;
+
+    for (int scene = 0; scene < numScenes; ++scene)
+        sceneButtons[(size_t)scene].setBounds(sceneArea.removeFromTop(rowHeight).reduced(2));
+
+    for (int track = 0; track < numTracks; ++track)
+    {
+        trackLabels[(size_t)track].setBounds(labelArea.removeFromLeft(columnWidth));
+        stopButtons[(size_t)track].setBounds(stopArea.removeFromLeft(columnWidth).reduced(2));
+
+        auto column = area.removeFromLeft(columnWidth);
+        for (int scene = 0; scene < numScenes; ++scene)
+            slotButtons[(size_t)track][(size_t)scene].setBounds(column.removeFromTop(rowHeight).reduced(2));
+    }
+}
+
+void ClipLauncherPanel::slotClicked(int track, int scene)
+{
+    if (deleteButton.getToggleState())
+    {
+        clipLauncher.clearClip(track, scene);
+    }
+    else if (clipLauncher.getSlotState(track, scene) == ClipLauncher::SlotState::empty)
+    {
+        audioEngine.captureClip((AudioEngine::Track)track, scene);
+    }
+    else
+    {
+        clipLauncher.launchClip(track, scene);
+    }
+
+    updateSlots();
+}
+
+void ClipLauncherPanel::showSnapshot(const EngineSnapshot& snapshot)
+{
+    shown = snapshot;
+
+    // Setting an unchanged colour or text repaints nothing, so refreshing
+    // every slot only costs the ones that differ
+    updateSlots();
+}
+
+void ClipLauncherPanel::updateSlots()
+{
+    for (int track = 0; track < numTracks; ++track)
+    {
+        const int playing = shown.clipPlayingScenes[(size_t)track];
+        const int queued = shown.clipQueuedScenes[(size_t)track];
+
+        for (int scene = 0; scene < numScenes; ++scene)
+        {
+            auto& button = slotButtons[(size_t)track][(size_t)scene];
+            const auto state = clipLauncher.getSlotState(track, scene);
+
+            juce::Colour colour = juce::Colours::darkgrey.darker();
+            juce::String text;
+
+            if (state == ClipLauncher::SlotState::loading)
+            {
+                text = "...";
+            }
+            else if (state == ClipLauncher::SlotState::ready)
+            {
+                text = clipLauncher.getClip(track, scene)->name;
+                colour = juce::Colours::steelblue.darker();
+            }
+
+            if (scene == playing && state == ClipLauncher::SlotState::ready)
+                colour = juce::Colours::green;
+            else if (scene == queued)
+                colour = juce::Colours::orange.darker();
+
+            button.setButtonText(text);
+            button.setColour(juce::TextButton::buttonColourId, colour);
+        }
+
+        stopButtons[(size_t)track].setColour(juce::TextButton::buttonColourId,
+                                             queued == ClipLauncher::stopped ? juce::Colours::orange.darker()
+                                                                             : getLookAndFeel().findColour(juce::TextButton::buttonColourId));
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioEngine.h"
+#include "EngineSnapshot.h"
+
+// The session grid: a column of clip slots per track, a launch button per
+// scene and a stop button per track. Tapping an empty slot captures what its
+// track holds now; tapping a full one launches it, or clears it while Delete
+// is on.
+class ClipLauncherPanel : public juce::Component
+{
+public:
+    explicit ClipLauncherPanel(AudioEngine& engine);
+    ~ClipLauncherPanel() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    // Colours the slots by what is playing, queued and still loading,
+    // repainting only the ones that change
+    void showSnapshot(const EngineSnapshot& snapshot);
+
+private:
+    static constexpr int numTracks = ClipLauncher::numTracks;
+    static constexpr int numScenes = ClipLauncher::numScenes;
+
+    AudioEngine& audioEngine;
+    ClipLauncher& clipLauncher;
+
+    std::array<std::array<juce::TextButton, numScenes>, numTracks> slotButtons;
+    std::array<juce::TextButton, numScenes> sceneButtons;
+    std::array<juce::TextButton, numTracks> stopButtons;
+    std::array<juce::Label, numTracks> trackLabels;
+    juce::TextButton stopAllButton;
+    juce::ToggleButton deleteButton;
+    juce::ComboBox quantumBox;
+
+    EngineSnapshot shown;
+
+    void slotClicked(int track, int scene);
+    void updateSlots();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ClipLauncherPanel)
+};
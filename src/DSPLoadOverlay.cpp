@@ -0,0 +1,145 @@
+#include "DSPLoadOverlay.h"
+
+namespace
+{
+    constexpr int rowHeight = 18;
+    constexpr int headerHeight = 22;
+    constexpr int refreshHz = 4;
+
+    juce::Colour getLoadColour(double load)
+    {
+        if (load > 0.8)
+            return juce::Colours::red;
+        if (load > 0.5)
+            return juce::Colours::orange;
+        return juce::Colours::limegreen;
+    }
+}
+
+DSPLoadOverlay::DSPLoadOverlay(DSPProfiler& p, XrunMonitor& monitor)
+    : profiler(p), xrunMonitor(monitor)
+{
+    setOpaque(false);
+}
+
+DSPLoadOverlay::~DSPLoadOverlay()
+{
+    stopTimer();
+}
+
+int DSPLoadOverlay::getIdealHeight() const
+{
+    return headerHeight + rowHeight * (DSPProfiler::numNodes + 2) + 8;
+}
+
+void DSPLoadOverlay::visibilityChanged()
+{
+    // Only poll while someone is looking
+    if (isVisible())
+    {
+        timerCallback();
+        startTimerHz(refreshHz);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+void DSPLoadOverlay::timerCallback()
+{
+    for (int i = 0; i < DSPProfiler::numNodes; ++i)
+        stats[(size_t)i] = profiler.getStats((DSPProfiler::Node)i);
+
+    numXruns = xrunMonitor.getNumXruns();
+
+    if (frameMonitor != nullptr)
+        frameStats = frameMonitor->getStats();
+
+    if (audioArena != nullptr)
+    {
+        arenaSpilledBytes = 0;
+        for (int i = 0; i < AudioArena::numSubsystems; ++i)
+            arenaSpilledBytes += audioArena->getUsage((AudioArena::Subsystem)i).spilledBytes;
+
+        arenaUsedBytes = audioArena->getUsedBytes();
+    }
+
+    repaint();
+}
+
+void DSPLoadOverlay::mouseDown(const juce::MouseEvent&)
+{
+    juce::Logger::writeToLog(profiler.createReport());
+    if (audioArena != nullptr)
+        juce::Logger::writeToLog(audioArena->createReport());
+    xrunMonitor.dumpToLog();
+    profiler.resetStats();
+
+    if (frameMonitor != nullptr)
+        frameMonitor->resetStats();
+}
+
+void DSPLoadOverlay::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.75f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 6.0f);
+
+    auto area = getLocalBounds().reduced(8, 4);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+
+    auto header = area.removeFromTop(headerHeight);
+    g.setColour(numXruns > 0 ? juce::Colours::red : juce::Colours::white);
+    g.drawText("Xruns: " + juce::String(numXruns), header.removeFromRight(90), juce::Justification::centredRight);
+
+    g.setColour(juce::Colours::white);
+    g.drawText("DSP load  avg / p99 / max", header, juce::Justification::centredLeft);
+
+    for (int i = 0; i < DSPProfiler::numNodes; ++i)
+    {
+        const auto& nodeStats = stats[(size_t)i];
+        auto row = area.removeFromTop(rowHeight);
+
+        g.setColour(juce::Colours::lightgrey);
+        g.drawText(DSPProfiler::getNodeName((DSPProfiler::Node)i), row.removeFromLeft(110), juce::Justification::centredLeft);
+
+        const auto numbers = juce::String(nodeStats.average * 100.0, 1) + " / "
+                           + juce::String(nodeStats.p99 * 100.0, 1) + " / "
+                           + juce::String(nodeStats.maximum * 100.0, 1);
+        g.drawText(numbers, row.removeFromRight(130), juce::Justification::centredRight);
+
+        // Bar for the average, tick for p99, both against the full block
+        auto bar = row.reduced(4, 5).toFloat();
+        g.setColour(juce::Colours::darkgrey);
+        g.fillRect(bar);
+
+        g.setColour(getLoadColour(nodeStats.average));
+        g.fillRect(bar.withWidth(bar.getWidth() * (float)juce::jmin(1.0, nodeStats.average)));
+
+        g.setColour(getLoadColour(nodeStats.p99));
+        const float p99X = bar.getX() + bar.getWidth() * (float)juce::jmin(1.0, nodeStats.p99);
+        g.drawVerticalLine((int)p99X, bar.getY() - 2.0f, bar.getBottom() + 2.0f);
+    }
+
+    if (frameMonitor != nullptr)
+    {
+        auto row = area.removeFromTop(rowHeight);
+        g.setColour(frameStats.numLate > 0 ? juce::Colours::orange : juce::Colours::lightgrey);
+        g.drawText("UI frames " + juce::String(frameStats.averageMs, 1) + " ms avg, "
+                       + juce::String(frameStats.worstMs, 1) + " worst, " + juce::String(frameStats.numLate) + " late"
+                       + (frameStats.refreshDivider > 1 ? ", 1/" + juce::String(frameStats.refreshDivider) + " rate" : ""),
+                   row, juce::Justification::centredLeft);
+    }
+
+    if (audioArena != nullptr)
+    {
+        const auto toMB = [](size_t numBytes) { return juce::String((double)numBytes / (1024.0 * 1024.0), 1); };
+
+        auto row = area.removeFromTop(rowHeight);
+        g.setColour(arenaSpilledBytes > 0 ? juce::Colours::orange : juce::Colours::lightgrey);
+        g.drawText("Audio memory " + toMB(arenaUsedBytes) + " / " + toMB(audioArena->getCapacity()) + " MB"
+                       + (audioArena->isLocked() ? ", locked" : "")
+                       + (arenaSpilledBytes > 0 ? ", " + toMB(arenaSpilledBytes) + " MB over" : ""),
+                   row, juce::Justification::centredLeft);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPProfiler.h"
+#include "XrunMonitor.h"
+#include "FrameBudgetMonitor.h"
+#include "AudioArena.h"
+
+// Semi-transparent table of DSP load per node, refreshed a few times a
+// second. Each row shows average, p99 and maximum load with a bar for the
+// average and a tick for p99, under a count of dropouts so far and, with a
+// frame monitor set, the UI's own frame times and, with an arena set, audio
+// memory in use. Clicking it writes the full
+// report and the recent dropouts to the log and starts the statistics
+// afresh.
+class DSPLoadOverlay : public juce::Component,
+                       private juce::Timer
+{
+public:
+    DSPLoadOverlay(DSPProfiler& profiler, XrunMonitor& xrunMonitor);
+    ~DSPLoadOverlay() override;
+
+    void paint(juce::Graphics&) override;
+    void mouseDown(const juce::MouseEvent&) override;
+    void visibilityChanged() override;
+
+    // Height needed to show every node
+    int getIdealHeight() const;
+
+    // Adds a row of UI frame times; nullptr to remove it
+    void setFrameMonitor(FrameBudgetMonitor* monitor) { frameMonitor = monitor; }
+
+    // Adds a row of audio memory use; nullptr to remove it
+    void setAudioArena(AudioArena* arena) { audioArena = arena; }
+
+private:
+    DSPProfiler& profiler;
+    XrunMonitor& xrunMonitor;
+    FrameBudgetMonitor* frameMonitor = nullptr;
+    int numXruns = 0;
+    FrameBudgetMonitor::Stats frameStats;
+    AudioArena* audioArena = nullptr;
+    size_t arenaUsedBytes = 0;
+    size_t arenaSpilledBytes = 0;
+    std::array<DSPProfiler::Stats, DSPProfiler::numNodes> stats;
+
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DSPLoadOverlay)
+};
@@ -0,0 +1,143 @@
+#include "DSPProfiler.h"
+
+DSPProfiler::DSPProfiler()
+    : blockStart(0), ticksPerBlock(1.0), sampleRate(44100.0), resetRequested(false)
+{
+    blockTicks.fill(0);
+    lastBlockLoads.fill(0.0f);
+    clearHistograms();
+}
+
+void DSPProfiler::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    resetRequested = true;
+}
+
+void DSPProfiler::beginBlock(int numSamples)
+{
+    if (resetRequested.exchange(false))
+        clearHistograms();
+
+    blockTicks.fill(0);
+    ticksPerBlock = juce::jmax(1.0, numSamples / sampleRate * (double)juce::Time::getHighResolutionTicksPerSecond());
+    blockStart = juce::Time::getHighResolutionTicks();
+}
+
+void DSPProfiler::endBlock()
+{
+    blockTicks[(size_t)Node::total] = juce::Time::getHighResolutionTicks() - blockStart;
+
+    for (int i = 0; i < numNodes; ++i)
+    {
+        const double load = (double)blockTicks[(size_t)i] / ticksPerBlock;
+        lastBlockLoads[(size_t)i] = (float)load;
+        record(histograms[(size_t)i], load);
+    }
+}
+
+void DSPProfiler::record(Histogram& histogram, double load)
+{
+    // Single writer, so plain load/store pairs are enough
+    const int bucket = juce::jlimit(0, numBuckets - 1, (int)(load * 100.0));
+    auto& count = histogram.buckets[(size_t)bucket];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    histogram.loadSum.store(histogram.loadSum.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+
+    if (load > histogram.maximum.load(std::memory_order_relaxed))
+        histogram.maximum.store(load, std::memory_order_relaxed);
+
+    histogram.numBlocks.store(histogram.numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void DSPProfiler::clearHistograms()
+{
+    for (auto& histogram : histograms)
+    {
+        for (auto& bucket : histogram.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+
+        histogram.loadSum.store(0.0, std::memory_order_relaxed);
+        histogram.maximum.store(0.0, std::memory_order_relaxed);
+        histogram.numBlocks.store(0, std::memory_order_release);
+    }
+}
+
+DSPProfiler::Stats DSPProfiler::getStats(Node node) const
+{
+    const auto& histogram = histograms[(size_t)node];
+
+    Stats stats;
+    stats.numBlocks = histogram.numBlocks.load(std::memory_order_acquire);
+    if (stats.numBlocks == 0)
+        return stats;
+
+    stats.average = histogram.loadSum.load(std::memory_order_relaxed) / (double)stats.numBlocks;
+    stats.maximum = histogram.maximum.load(std::memory_order_relaxed);
+
+    // The counts may move on while we read; the bucket totals are the
+    // reference for the percentile rather than numBlocks
+    std::array<juce::uint32, numBuckets> counts;
+    juce::uint64 total = 0;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        counts[(size_t)i] = histogram.buckets[(size_t)i].load(std::memory_order_relaxed);
+        total += counts[(size_t)i];
+    }
+
+    const auto tail = total / 100;
+    juce::uint64 above = 0;
+    for (int i = numBuckets - 1; i >= 0; --i)
+    {
+        above += counts[(size_t)i];
+        if (above > tail)
+        {
+            // Upper edge of the bucket, but never more than was actually seen
+            stats.p99 = juce::jmin(stats.maximum, (i + 1) / 100.0);
+            break;
+        }
+    }
+
+    return stats;
+}
+
+juce::String DSPProfiler::createReport() const
+{
+    juce::String report;
+    report << "DSP load (% of block duration), " << (juce::int64)getStats(Node::total).numBlocks << " blocks" << juce::newLine;
+    report << juce::String("node").paddedRight(' ', 20) << "    avg     p99     max" << juce::newLine;
+
+    for (int i = 0; i < numNodes; ++i)
+    {
+        const auto stats = getStats((Node)i);
+        report << getNodeName((Node)i).paddedRight(' ', 20)
+               << juce::String(stats.average * 100.0, 1).paddedLeft(' ', 7)
+               << juce::String(stats.p99 * 100.0, 1).paddedLeft(' ', 8)
+               << juce::String(stats.maximum * 100.0, 1).paddedLeft(' ', 8) << juce::newLine;
+    }
+
+    return report;
+}
+
+juce::String DSPProfiler::getNodeName(Node node)
+{
+    switch (node)
+    {
+        case Node::filePlayer:        return "File player";
+        case Node::looper:            return "Looper";
+        case Node::sequencer:         return "Sequencer";
+        case Node::slicer:            return "Slicer";
+        case Node::filePlayerInserts: return "File player FX";
+        case Node::looperInserts:     return "Looper FX";
+        case Node::sequencerInserts:  return "Sequencer FX";
+        case Node::slicerInserts:     return "Slicer FX";
+        case Node::reverbBus:         return "Reverb bus";
+        case Node::delayBus:          return "Delay bus";
+        case Node::masterEffects:     return "Master FX";
+        case Node::masterDynamics:    return "Master dynamics";
+        case Node::total:             return "Total";
+    }
+
+    return {};
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Per-block timing of every node in the audio graph, as a fraction of the
+// block's duration (1.0 = the whole time budget). The audio thread is the
+// only writer: it times nodes with the monotonic high-resolution clock,
+// sums them over the block and adds each load to a fixed histogram of
+// relaxed atomics, so recording never locks or allocates. Any thread can
+// read average, p99 and maximum load from the histograms.
+class DSPProfiler
+{
+public:
+    enum class Node
+    {
+        filePlayer,
+        looper,
+        sequencer,
+        slicer,
+        filePlayerInserts,
+        looperInserts,
+        sequencerInserts,
+        slicerInserts,
+        reverbBus,
+        delayBus,
+        masterEffects,
+        masterDynamics,
+        total
+    };
+
+    static constexpr int numNodes = 13;
+
+    // 1% of the block per bucket; the last one also holds everything over
+    static constexpr int numBuckets = 200;
+
+    struct Stats
+    {
+        double average = 0.0;
+        double p99 = 0.0;
+        double maximum = 0.0;
+        juce::uint64 numBlocks = 0;
+    };
+
+    // Adds the time from construction to destruction to a node
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(DSPProfiler& p, Node n)
+            : profiler(p), node(n), start(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedTimer() { profiler.addTicks(node, juce::Time::getHighResolutionTicks() - start); }
+
+    private:
+        DSPProfiler& profiler;
+        Node node;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+    DSPProfiler();
+
+    void prepare(double sampleRate);
+
+    // Audio thread. Everything between beginBlock and endBlock is the total.
+    void beginBlock(int numSamples);
+    void addTicks(Node node, juce::int64 ticks) { blockTicks[(size_t)node] += ticks; }
+    void endBlock();
+
+    // Audio thread: the block being timed and the loads of the last one
+    juce::int64 getBlockStartTicks() const { return blockStart; }
+    const std::array<float, numNodes>& getLastBlockLoads() const { return lastBlockLoads; }
+
+    // Any thread. Resetting happens at the start of the next block.
+    Stats getStats(Node node) const;
+    void resetStats() { resetRequested = true; }
+    juce::String createReport() const;
+
+    static juce::String getNodeName(Node node);
+
+private:
+    struct Histogram
+    {
+        std::array<std::atomic<juce::uint32>, numBuckets> buckets;
+        std::atomic<juce::uint64> numBlocks { 0 };
+        std::atomic<double> loadSum { 0.0 };
+        std::atomic<double> maximum { 0.0 };
+    };
+
+    std::array<Histogram, numNodes> histograms;
+
+    // Audio thread only
+    std::array<juce::int64, numNodes> blockTicks;
+    std::array<float, numNodes> lastBlockLoads;
+    juce::int64 blockStart;
+    double ticksPerBlock;
+    double sampleRate;
+    std::atomic<bool> resetRequested;
+
+    void clearHistograms();
+    void record(Histogram& histogram, double load);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DSPProfiler)
+};
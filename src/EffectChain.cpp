@@ -0,0 +1,192 @@
+#include "EffectChain.h"
+
+EffectChain::EffectChain()
+    : currentSpec { 44100.0, 0, 2 }, isPrepared(false), tempo(120.0), numActiveStages(0)
+{
+    compile();
+}
+
+EffectChain::~EffectChain()
+{
+}
+
+void EffectChain::setArena(AudioArena* newArena)
+{
+    audioArena = newArena;
+
+    for (auto& unit : units)
+        unit->setArena(newArena);
+}
+
+void EffectChain::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    currentSpec = spec;
+    isPrepared = spec.maximumBlockSize > 0;
+
+    for (auto& unit : units)
+        unit->prepare(spec);
+
+    scratchBlock = juce::dsp::AudioBlock<float>(scratchData, spec.numChannels, spec.maximumBlockSize);
+    levelRamp.assign(spec.maximumBlockSize, 0.0f);
+}
+
+void EffectChain::reset()
+{
+    // Re-preparing clears every unit's state and crossfade
+    for (auto& unit : units)
+        unit->prepare(currentSpec);
+}
+
+EffectUnit* EffectChain::addEffect(EffectUnit::Type type, int index)
+{
+    if ((int)units.size() >= maxSlots)
+        return nullptr;
+
+    std::shared_ptr<EffectUnit> unit = EffectUnit::create(type);
+    unit->setArena(audioArena);
+    if (isPrepared)
+        unit->prepare(currentSpec);
+
+    if (index < 0 || index > (int)units.size())
+        index = (int)units.size();
+
+    units.insert(units.begin() + index, unit);
+    compile();
+    return unit.get();
+}
+
+void EffectChain::removeEffect(int index)
+{
+    if (!juce::isPositiveAndBelow(index, (int)units.size()))
+        return;
+
+    units.erase(units.begin() + index);
+    compile();
+}
+
+void EffectChain::moveEffect(int fromIndex, int toIndex)
+{
+    const int numUnits = (int)units.size();
+    if (!juce::isPositiveAndBelow(fromIndex, numUnits) || !juce::isPositiveAndBelow(toIndex, numUnits)
+        || fromIndex == toIndex)
+        return;
+
+    auto unit = units[(size_t)fromIndex];
+    units.erase(units.begin() + fromIndex);
+    units.insert(units.begin() + toIndex, unit);
+    compile();
+}
+
+void EffectChain::setOrder(const std::vector<EffectUnit*>& order)
+{
+    // Units not mentioned keep their relative order after the listed ones
+    std::vector<std::shared_ptr<EffectUnit>> reordered;
+    reordered.reserve(units.size());
+
+    for (auto* unit : order)
+    {
+        const int index = indexOf(unit);
+        if (index >= 0 && std::find(reordered.begin(), reordered.end(), units[(size_t)index]) == reordered.end())
+            reordered.push_back(units[(size_t)index]);
+    }
+
+    for (auto& unit : units)
+    {
+        if (std::find(reordered.begin(), reordered.end(), unit) == reordered.end())
+            reordered.push_back(unit);
+    }
+
+    units = std::move(reordered);
+    compile();
+}
+
+void EffectChain::clear()
+{
+    units.clear();
+    compile();
+}
+
+EffectUnit* EffectChain::getEffect(int index) const
+{
+    return juce::isPositiveAndBelow(index, (int)units.size()) ? units[(size_t)index].get() : nullptr;
+}
+
+int EffectChain::indexOf(const EffectUnit* unit) const
+{
+    for (size_t i = 0; i < units.size(); ++i)
+    {
+        if (units[i].get() == unit)
+            return (int)i;
+    }
+    return -1;
+}
+
+void EffectChain::compile()
+{
+    auto chain = std::make_unique<CompiledChain>();
+    chain->units = units;
+
+    for (auto& unit : units)
+    {
+        auto& stage = chain->stages[(size_t)chain->numStages++];
+        stage.process = unit->getProcessFunction();
+        stage.unit = unit.get();
+    }
+
+    compiled.publish(std::move(chain));
+}
+
+void EffectChain::process(juce::dsp::AudioBlock<float>& block)
+{
+    const auto* chain = compiled.acquire();
+    numActiveStages = 0;
+
+    if (chain->numStages > 0 && isPrepared)
+    {
+        const auto numChannels = juce::jmin(block.getNumChannels(), scratchBlock.getNumChannels());
+        const auto maxBlockSize = (size_t)currentSpec.maximumBlockSize;
+        auto channels = block.getSubsetChannelBlock(0, numChannels);
+
+        EffectScratch scratch { scratchBlock.getSubsetChannelBlock(0, numChannels), levelRamp.data(), tempo.load() };
+
+        // The scratch space is sized for the prepared block size; split anything larger
+        for (size_t offset = 0; offset < channels.getNumSamples(); offset += maxBlockSize)
+        {
+            auto subBlock = channels.getSubBlock(offset, juce::jmin(maxBlockSize, channels.getNumSamples() - offset));
+
+            for (int i = 0; i < chain->numStages; ++i)
+            {
+                const auto& stage = chain->stages[(size_t)i];
+                stage.process(*stage.unit, subBlock, scratch);
+            }
+        }
+
+        for (int i = 0; i < chain->numStages; ++i)
+            numActiveStages += chain->stages[(size_t)i].unit->isActive() ? 1 : 0;
+    }
+
+    compiled.release();
+}
+
+int EffectChain::getTailSamples()
+{
+    // In series, each unit's tail runs on through the ones after it
+    const auto* chain = compiled.acquire();
+
+    int total = 0;
+    for (int i = 0; i < chain->numStages; ++i)
+        total += chain->stages[(size_t)i].unit->getTailSamples();
+
+    compiled.release();
+    return total;
+}
+
+void EffectChain::clearState()
+{
+    const auto* chain = compiled.acquire();
+
+    for (int i = 0; i < chain->numStages; ++i)
+        chain->stages[(size_t)i].unit->clearState();
+
+    compiled.release();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "EffectUnit.h"
+#include "RealtimeObject.h"
+
+// An ordered list of effect slots. Edits happen on the message thread and
+// recompile the chain into a flat array of {process function, unit} stages,
+// which is swapped in for the audio thread without locks. Reordering keeps
+// the units, so delay and reverb tails survive it.
+class EffectChain
+{
+public:
+    static constexpr int maxSlots = 8;
+
+    EffectChain();
+    ~EffectChain();
+
+    // Where units keep their delay lines, for units added from now on as
+    // well. Set before prepare.
+    void setArena(AudioArena* newArena);
+
+    // Called with the audio stopped
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // Message thread. addEffect returns nullptr once the chain is full.
+    EffectUnit* addEffect(EffectUnit::Type type, int index = -1);
+    void removeEffect(int index);
+    void moveEffect(int fromIndex, int toIndex);
+    void setOrder(const std::vector<EffectUnit*>& order);
+    void clear();
+
+    int getNumEffects() const { return (int)units.size(); }
+    EffectUnit* getEffect(int index) const;
+    int indexOf(const EffectUnit* unit) const;
+
+    // Tempo for tempo-synced effects, e.g. a delay set in beats
+    void setTempo(double bpm) { tempo = bpm; }
+
+    // Audio thread
+    void process(juce::dsp::AudioBlock<float>& block);
+
+    // Audio thread: how many units did any work in the last process call
+    int getNumActiveStages() const { return numActiveStages; }
+
+    // Audio thread: how long the chain can keep sounding after its input
+    // stops, with silent gaps, and emptying it, e.g. before a bus goes idle
+    int getTailSamples();
+    void clearState();
+
+private:
+    struct Stage
+    {
+        EffectUnit::ProcessFunction process = nullptr;
+        EffectUnit* unit = nullptr;
+    };
+
+    struct CompiledChain
+    {
+        std::array<Stage, maxSlots> stages;
+        int numStages = 0;
+
+        // Keeps removed units alive until the audio thread has moved on
+        std::vector<std::shared_ptr<EffectUnit>> units;
+    };
+
+    std::vector<std::shared_ptr<EffectUnit>> units;
+    RealtimeObject<CompiledChain> compiled;
+
+    AudioArena* audioArena = nullptr;
+    juce::dsp::ProcessSpec currentSpec;
+    bool isPrepared;
+    std::atomic<double> tempo;
+    int numActiveStages;
+
+    // Scratch space for crossfades and wet signals, sized in prepare
+    juce::HeapBlock<char> scratchData;
+    juce::dsp::AudioBlock<float> scratchBlock;
+    std::vector<float> levelRamp;
+
+    void compile();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EffectChain)
+};
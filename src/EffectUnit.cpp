@@ -0,0 +1,346 @@
+#include "EffectUnit.h"
+
+namespace
+{
+    // Long enough to avoid clicks, short enough to feel instant
+    constexpr double crossfadeSeconds = 0.02;
+}
+
+std::unique_ptr<EffectUnit> EffectUnit::create(Type type)
+{
+    switch (type)
+    {
+        case Type::filter:     return std::make_unique<FilterUnit>();
+        case Type::delay:      return std::make_unique<DelayUnit>();
+        case Type::reverb:     return std::make_unique<ReverbUnit>();
+        case Type::distortion: return std::make_unique<DistortionUnit>();
+    }
+
+    jassertfalse;
+    return nullptr;
+}
+
+juce::String EffectUnit::getTypeName(Type type)
+{
+    switch (type)
+    {
+        case Type::filter:     return "Filter";
+        case Type::delay:      return "Delay";
+        case Type::reverb:     return "Reverb";
+        case Type::distortion: return "Distortion";
+    }
+
+    return {};
+}
+
+EffectUnit::EffectUnit(Type unitType, ProcessFunction function, ResetFunction reset)
+    : type(unitType), processFunction(function), resetFunction(reset)
+{
+}
+
+void EffectUnit::clearState()
+{
+    resetFunction(*this);
+    silentSamples = 0;
+}
+
+void EffectUnit::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    const bool isOn = enabled.load();
+    level.reset(spec.sampleRate, crossfadeSeconds);
+    level.setCurrentAndTargetValue(isOn ? 1.0f : 0.0f);
+    active = isOn;
+}
+
+template <typename Unit>
+void EffectUnit::processStage(EffectUnit& base, juce::dsp::AudioBlock<float>& block, EffectScratch& scratch)
+{
+    auto& unit = static_cast<Unit&>(base);
+
+    const float target = base.enabled.load() ? 1.0f : 0.0f;
+    if (target != base.level.getTargetValue())
+    {
+        base.level.setTargetValue(target);
+        base.active = true;
+        base.silentSamples = 0;
+    }
+
+    // Disabled and silent: skipped entirely
+    if (!base.active.load())
+        return;
+
+    if constexpr (Unit::followsTempo)
+        unit.setTempo(scratch.tempo);
+
+    if constexpr (Unit::hasTail)
+        base.tailSamples = unit.getTailSamples();
+
+    const auto numSamples = block.getNumSamples();
+    const bool fading = base.level.isSmoothing();
+
+    if constexpr (!Unit::hasTail)
+    {
+        if (!fading && target == 1.0f)
+        {
+            // Fully on: straight in place, no extra copies
+            unit.process(block);
+            return;
+        }
+    }
+
+    auto* ramp = scratch.levelRamp;
+    for (size_t i = 0; i < numSamples; ++i)
+        ramp[i] = base.level.getNextValue();
+
+    auto wet = scratch.block.getSubBlock(0, numSamples);
+    wet.copyFrom(block);
+
+    if constexpr (!Unit::hasTail)
+    {
+        // Crossfade the processed signal against the dry one
+        unit.process(wet);
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* out = block.getChannelPointer(ch);
+            auto* processed = wet.getChannelPointer(ch);
+            for (size_t i = 0; i < numSamples; ++i)
+                out[i] += (processed[i] - out[i]) * ramp[i];
+        }
+
+        if (!base.level.isSmoothing() && target == 0.0f)
+        {
+            base.active = false;
+            unit.reset();
+        }
+    }
+    else
+    {
+        for (size_t ch = 0; ch < wet.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::multiply(wet.getChannelPointer(ch), ramp, (int)numSamples);
+
+        unit.process(wet);
+
+        const float dryLoss = 1.0f - unit.getDryLevel();
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* out = block.getChannelPointer(ch);
+            auto* tail = wet.getChannelPointer(ch);
+            for (size_t i = 0; i < numSamples; ++i)
+                out[i] = out[i] * (1.0f - ramp[i] * dryLoss) + tail[i];
+        }
+
+        if (!base.level.isSmoothing() && target == 0.0f)
+        {
+            // A delay is silent between its repeats, so only a whole tail's
+            // length of silence means nothing is left in the unit
+            const auto range = wet.findMinAndMax();
+            if (juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd())) >= silenceThreshold)
+                base.silentSamples = 0;
+            else if ((base.silentSamples += (int)numSamples) >= unit.getTailSamples())
+            {
+                base.active = false;
+                base.silentSamples = 0;
+                unit.reset();
+            }
+        }
+    }
+}
+
+//==============================================================================
+FilterUnit::FilterUnit()
+    : EffectUnit(Type::filter, &processStage<FilterUnit>, &resetStage<FilterUnit>), cutoff(1000.0f), resonance(0.7f),
+      mode((int)MultimodeFilter::Mode::lowpass), slope((int)MultimodeFilter::Slope::db12),
+      lfoRate(0.0f), lfoDepth(0.0f)
+{
+}
+
+void FilterUnit::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    EffectUnit::prepare(spec);
+    filter.prepare(spec.sampleRate);
+}
+
+void FilterUnit::setParameters(float newCutoff, float newResonance)
+{
+    cutoff = newCutoff;
+    resonance = newResonance;
+}
+
+void FilterUnit::setMode(MultimodeFilter::Mode newMode, MultimodeFilter::Slope newSlope)
+{
+    mode = (int)newMode;
+    slope = (int)newSlope;
+}
+
+void FilterUnit::setLFO(float rateHz, float depthOctaves)
+{
+    lfoRate = rateHz;
+    lfoDepth = depthOctaves;
+}
+
+void FilterUnit::process(juce::dsp::AudioBlock<float>& block)
+{
+    filter.setCutoff(cutoff.load());
+    filter.setResonance(resonance.load());
+    filter.setMode((MultimodeFilter::Mode)mode.load());
+    filter.setSlope((MultimodeFilter::Slope)slope.load());
+    filter.setLFO(lfoRate.load(), lfoDepth.load());
+
+    float* channels[MultimodeFilter::maxChannels] = {};
+    const int numChannels = juce::jmin((int)block.getNumChannels(), MultimodeFilter::maxChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = block.getChannelPointer((size_t)ch);
+
+    filter.process(channels, numChannels, (int)block.getNumSamples());
+}
+
+//==============================================================================
+DelayUnit::DelayUnit()
+    : EffectUnit(Type::delay, &processStage<DelayUnit>, &resetStage<DelayUnit>)
+{
+}
+
+void DelayUnit::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    EffectUnit::prepare(spec);
+    delay.prepare(spec);
+}
+
+void DelayUnit::setParameters(float time, float feedback, float mix)
+{
+    auto parameters = delay.getParameters();
+    parameters.timeSeconds = time;
+    parameters.feedback = feedback;
+    parameters.mix = mix;
+    delay.setParameters(parameters);
+}
+
+void DelayUnit::setPingPong(bool shouldPingPong)
+{
+    auto parameters = delay.getParameters();
+    parameters.pingPong = shouldPingPong;
+    delay.setParameters(parameters);
+}
+
+void DelayUnit::setTempoSync(bool shouldSync, float beats)
+{
+    auto parameters = delay.getParameters();
+    parameters.tempoSync = shouldSync;
+    parameters.beats = beats;
+    delay.setParameters(parameters);
+}
+
+void DelayUnit::setFeedbackFilter(float lowCutHz, float highCutHz)
+{
+    auto parameters = delay.getParameters();
+    parameters.lowCutHz = lowCutHz;
+    parameters.highCutHz = highCutHz;
+    delay.setParameters(parameters);
+}
+
+void DelayUnit::process(juce::dsp::AudioBlock<float>& block)
+{
+    // Wet only; the dry path is mixed in by processStage
+    delay.process(juce::dsp::ProcessContextReplacing<float>(block));
+}
+
+//==============================================================================
+ReverbUnit::ReverbUnit()
+    : EffectUnit(Type::reverb, &processStage<ReverbUnit>, &resetStage<ReverbUnit>),
+      roomSize(0.5f), damping(0.5f), wetLevel(0.33f), dryLevel(0.67f), preDelayMs(20.0f)
+{
+    setParameters(0.5f, 0.5f, 0.33f, 0.67f);
+}
+
+void ReverbUnit::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    EffectUnit::prepare(spec);
+    reverb.prepare(spec);
+    setParameters(roomSize.load(), damping.load(), wetLevel.load(), dryLevel.load());
+}
+
+void ReverbUnit::setParameters(float newRoomSize, float newDamping, float newWetLevel, float newDryLevel)
+{
+    roomSize = newRoomSize;
+    damping = newDamping;
+    wetLevel = newWetLevel;
+    dryLevel = newDryLevel;
+
+    // The reverb itself runs wet-only; the dry level is applied in processStage
+    auto fdnParameters = reverb.getParameters();
+    fdnParameters.decaySeconds = 0.3f * std::pow(30.0f, juce::jlimit(0.0f, 1.0f, newRoomSize));
+    fdnParameters.damping = newDamping;
+    fdnParameters.wetLevel = newWetLevel;
+    fdnParameters.earlyLevel = newWetLevel * 0.5f;
+    fdnParameters.preDelayMs = preDelayMs.load();
+    reverb.setParameters(fdnParameters);
+}
+
+juce::Reverb::Parameters ReverbUnit::getParameters() const
+{
+    juce::Reverb::Parameters parameters;
+    parameters.roomSize = roomSize.load();
+    parameters.damping = damping.load();
+    parameters.wetLevel = wetLevel.load();
+    parameters.dryLevel = dryLevel.load();
+    return parameters;
+}
+
+void ReverbUnit::setPreDelay(float milliseconds)
+{
+    preDelayMs = juce::jlimit(0.0f, FDNReverb::maxPreDelayMs, milliseconds);
+    setParameters(roomSize.load(), damping.load(), wetLevel.load(), dryLevel.load());
+}
+
+void ReverbUnit::process(juce::dsp::AudioBlock<float>& block)
+{
+    juce::dsp::ProcessContextReplacing<float> context(block);
+    reverb.process(context);
+}
+
+//==============================================================================
+DistortionUnit::DistortionUnit()
+    : EffectUnit(Type::distortion, &processStage<DistortionUnit>, &resetStage<DistortionUnit>)
+{
+}
+
+void DistortionUnit::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    EffectUnit::prepare(spec);
+    shaper.prepare(spec);
+}
+
+void DistortionUnit::setParameters(float drive, float mix)
+{
+    auto parameters = shaper.getParameters();
+    parameters.drive = drive;
+    parameters.mix = mix;
+    shaper.setParameters(parameters);
+}
+
+void DistortionUnit::setCurve(Waveshaper::Curve curve)
+{
+    auto parameters = shaper.getParameters();
+    parameters.curve = curve;
+    shaper.setParameters(parameters);
+}
+
+void DistortionUnit::setOversampling(int factor)
+{
+    auto parameters = shaper.getParameters();
+    parameters.oversampling = factor;
+    shaper.setParameters(parameters);
+}
+
+void DistortionUnit::setBits(float bits)
+{
+    auto parameters = shaper.getParameters();
+    parameters.bits = bits;
+    shaper.setParameters(parameters);
+}
+
+void DistortionUnit::process(juce::dsp::AudioBlock<float>& block)
+{
+    shaper.process(juce::dsp::ProcessContextReplacing<float>(block));
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "FDNReverb.h"
+#include "StereoDelay.h"
+#include "Waveshaper.h"
+#include "MultimodeFilter.h"
+
+// Scratch space an EffectChain lends its effects while processing
+struct EffectScratch
+{
+    juce::dsp::AudioBlock<float> block;
+    float* levelRamp = nullptr;
+    double tempo = 120.0;
+};
+
+// One effect in an EffectChain. The chain calls each unit through a plain
+// function pointer picked when the unit is created, so processing involves
+// no virtual dispatch; only preparation goes through the vtable.
+//
+// Enabling or disabling crossfades over a few milliseconds. Units with a tail
+// (delay, reverb) run wet-only and fade their input instead of their output,
+// so switching them off lets the tail ring out; they go idle, and cost
+// nothing, once their output has stayed silent for as long as they can hold
+// sound.
+class EffectUnit
+{
+public:
+    enum class Type
+    {
+        filter,
+        delay,
+        reverb,
+        distortion
+    };
+
+    static constexpr int numTypes = 4;
+
+    // A tail or bus return below this has rung out and can go idle
+    static inline const float silenceThreshold = juce::Decibels::decibelsToGain(-90.0f);
+
+    using ProcessFunction = void (*)(EffectUnit&, juce::dsp::AudioBlock<float>&, EffectScratch&);
+    using ResetFunction = void (*)(EffectUnit&);
+
+    static std::unique_ptr<EffectUnit> create(Type type);
+    static juce::String getTypeName(Type type);
+
+    virtual ~EffectUnit() = default;
+
+    Type getType() const { return type; }
+    ProcessFunction getProcessFunction() const { return processFunction; }
+
+    // Called with the audio stopped, or before the unit is added to a running chain
+    virtual void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // Where units with delay lines keep them; the heap if never set
+    virtual void setArena(AudioArena*) {}
+
+    void setEnabled(bool shouldBeEnabled) { enabled = shouldBeEnabled; }
+    bool isEnabled() const { return enabled.load(); }
+    bool isActive() const { return active.load(); }
+
+    // Audio thread: how long the output can stay silent while the unit still
+    // holds sound, as of the last block (0 for units without a tail), and
+    // clearing that sound without reallocating anything
+    int getTailSamples() const { return tailSamples; }
+    void clearState();
+
+protected:
+    EffectUnit(Type type, ProcessFunction processFunction, ResetFunction resetFunction);
+
+    template <typename Unit>
+    static void processStage(EffectUnit& unit, juce::dsp::AudioBlock<float>& block, EffectScratch& scratch);
+
+    template <typename Unit>
+    static void resetStage(EffectUnit& unit) { static_cast<Unit&>(unit).reset(); }
+
+private:
+    const Type type;
+    const ProcessFunction processFunction;
+    const ResetFunction resetFunction;
+    std::atomic<bool> enabled { true };
+    std::atomic<bool> active { true };     // Processing, possibly only a tail
+    juce::SmoothedValue<float> level;      // Audio thread only
+    int silentSamples = 0;                 // Audio thread: of the tail, in a row
+    int tailSamples = 0;                   // Audio thread
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EffectUnit)
+};
+
+class FilterUnit : public EffectUnit
+{
+public:
+    static constexpr bool hasTail = false;
+    static constexpr bool followsTempo = false;
+
+    FilterUnit();
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+
+    void setParameters(float cutoff, float resonance);
+    void setMode(MultimodeFilter::Mode mode, MultimodeFilter::Slope slope);
+    void setLFO(float rateHz, float depthOctaves);
+
+    float getCutoff() const { return cutoff.load(); }
+    float getResonance() const { return resonance.load(); }
+    MultimodeFilter::Mode getMode() const { return (MultimodeFilter::Mode)mode.load(); }
+    MultimodeFilter::Slope getSlope() const { return (MultimodeFilter::Slope)slope.load(); }
+
+    void process(juce::dsp::AudioBlock<float>& block);
+    void reset() { filter.reset(); }
+    float getDryLevel() const { return 1.0f; }
+
+private:
+    MultimodeFilter filter;
+    std::atomic<float> cutoff;
+    std::atomic<float> resonance;
+    std::atomic<int> mode;
+    std::atomic<int> slope;
+    std::atomic<float> lfoRate;
+    std::atomic<float> lfoDepth;
+};
+
+class DelayUnit : public EffectUnit
+{
+public:
+    static constexpr bool hasTail = true;
+    static constexpr bool followsTempo = true;
+
+    DelayUnit();
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void setArena(AudioArena* arena) override { delay.setArena(arena); }
+
+    void setParameters(float time, float feedback, float mix);
+    void setPingPong(bool shouldPingPong);
+    void setTempoSync(bool shouldSync, float beats);
+    void setFeedbackFilter(float lowCutHz, float highCutHz);
+
+    StereoDelay::Parameters getDelayParameters() const { return delay.getParameters(); }
+    float getTime() const { return delay.getParameters().timeSeconds; }
+    float getFeedback() const { return delay.getParameters().feedback; }
+    float getMix() const { return delay.getMix(); }
+
+    void setTempo(double bpm) { delay.setTempo(bpm); }
+    void process(juce::dsp::AudioBlock<float>& block);
+    void reset() { delay.reset(); }
+    float getDryLevel() const { return 1.0f - delay.getMix(); }
+    int getTailSamples() const { return delay.getTailSamples(); }
+
+private:
+    StereoDelay delay;
+};
+
+class ReverbUnit : public EffectUnit
+{
+public:
+    static constexpr bool hasTail = true;
+    static constexpr bool followsTempo = false;
+
+    ReverbUnit();
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void setArena(AudioArena* arena) override { reverb.setArena(arena); }
+
+    // Room size maps to a decay time of 0.3 to 9 seconds
+    void setParameters(float roomSize, float damping, float wetLevel, float dryLevel);
+    juce::Reverb::Parameters getParameters() const;
+
+    void setQuality(FDNReverb::Quality quality) { reverb.setQuality(quality); }
+    FDNReverb::Quality getQuality() const { return reverb.getQuality(); }
+    void setPreDelay(float milliseconds);
+
+    void process(juce::dsp::AudioBlock<float>& block);
+    void reset() { reverb.reset(); }
+    float getDryLevel() const { return dryLevel.load(); }
+    int getTailSamples() const { return reverb.getTailSamples(); }
+
+private:
+    FDNReverb reverb;
+
+    // Shared with the audio thread, which reads the dry level
+    std::atomic<float> roomSize;
+    std::atomic<float> damping;
+    std::atomic<float> wetLevel;
+    std::atomic<float> dryLevel;
+    std::atomic<float> preDelayMs;
+};
+
+class DistortionUnit : public EffectUnit
+{
+public:
+    static constexpr bool hasTail = false;
+    static constexpr bool followsTempo = false;
+
+    DistortionUnit();
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+
+    void setParameters(float drive, float mix);
+    void setCurve(Waveshaper::Curve curve);
+    void setOversampling(int factor);
+    void setBits(float bits);
+
+    Waveshaper::Parameters getShaperParameters() const { return shaper.getParameters(); }
+    float getDrive() const { return shaper.getParameters().drive; }
+    float getMix() const { return shaper.getParameters().mix; }
+
+    void process(juce::dsp::AudioBlock<float>& block);
+    void reset() { shaper.reset(); }
+    float getDryLevel() const { return 1.0f; }
+
+private:
+    Waveshaper shaper;
+};
@@ -8,6 +8,12 @@ EffectsPanel::EffectsPanel(AudioEngine& engine)
     delayToggle.setButtonText("Delay");
     filterToggle.setButtonText("Filter");
     distortionToggle.setButtonText("Distortion");
+
+    auto& effects = audioEngine.getEffectsProcessor();
+    reverbToggle.setToggleState(effects.isEffectEnabled(EffectsProcessor::Effect::reverb), juce::dontSendNotification);
+    delayToggle.setToggleState(effects.isEffectEnabled(EffectsProcessor::Effect::delay), juce::dontSendNotification);
+    filterToggle.setToggleState(effects.isEffectEnabled(EffectsProcessor::Effect::filter), juce::dontSendNotification);
+    distortionToggle.setToggleState(effects.isEffectEnabled(EffectsProcessor::Effect::distortion), juce::dontSendNotification);
     
     // Setup sliders
     setupSlider(reverbRoomSize, reverbLabel, "Reverb Room Size", 0.0, 1.0, 0.01, 0.5);
@@ -142,7 +148,17 @@ void EffectsPanel::sliderValueChanged(juce::Slider* slider)
 
 void EffectsPanel::buttonClicked(juce::Button* button)
 {
-    updateEffectParameters();
+    auto& effects = audioEngine.getEffectsProcessor();
+    const bool enabled = button->getToggleState();
+
+    if (button == &reverbToggle)
+        effects.setEffectEnabled(EffectsProcessor::Effect::reverb, enabled);
+    else if (button == &delayToggle)
+        effects.setEffectEnabled(EffectsProcessor::Effect::delay, enabled);
+    else if (button == &filterToggle)
+        effects.setEffectEnabled(EffectsProcessor::Effect::filter, enabled);
+    else if (button == &distortionToggle)
+        effects.setEffectEnabled(EffectsProcessor::Effect::distortion, enabled);
 }
 
 void EffectsPanel::setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& name,
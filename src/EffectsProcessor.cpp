@@ -1,11 +1,16 @@
 #include "EffectsProcessor.h"
 
 EffectsProcessor::EffectsProcessor()
-    : delayWritePosition(0), isEnabled(true)
+    : isEnabled(true)
 {
-    // Initialize delay buffer
-    delayBuffer.setSize(2, 44100 * 2); // 2 seconds at 44.1kHz
-    delayBuffer.clear();
+    // Default order, all off until switched on
+    filter = static_cast<FilterUnit*>(chain.addEffect(Effect::filter));
+    delay = static_cast<DelayUnit*>(chain.addEffect(Effect::delay));
+    reverb = static_cast<ReverbUnit*>(chain.addEffect(Effect::reverb));
+    distortion = static_cast<DistortionUnit*>(chain.addEffect(Effect::distortion));
+
+    for (int i = 0; i < numEffects; ++i)
+        getUnit((Effect)i)->setEnabled(false);
 }
 
 EffectsProcessor::~EffectsProcessor()
@@ -14,27 +19,17 @@ EffectsProcessor::~EffectsProcessor()
 
 void EffectsProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    // Prepare DSP modules
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
+    spec.maximumBlockSize = (juce::uint32)juce::jmax(1, samplesPerBlock);
     spec.numChannels = 2;
 
-    reverb.prepare(spec);
-    delay.prepare(spec);
-    filter.prepare(spec);
-    distortion.prepare(spec);
-
-    // Set default parameters
-    setReverbParameters(0.5f, 0.5f, 0.33f, 0.67f);
-    setDelayParameters(0.5f, 0.3f, 0.3f);
-    setFilterParameters(1000.0f, 0.7f);
-    setDistortionParameters(1.0f, 0.5f);
+    chain.prepare(spec);
 }
 
 void EffectsProcessor::releaseResources()
 {
-    delayBuffer.clear();
+    chain.reset();
 }
 
 void EffectsProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
@@ -43,39 +38,69 @@ void EffectsProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Midi
         return;
 
     juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    chain.process(block);
+}
 
-    // Apply effects in series
-    filter.process(context);
-    delay.process(context);
-    reverb.process(context);
-    distortion.process(context);
+EffectUnit* EffectsProcessor::getUnit(Effect effect) const
+{
+    switch (effect)
+    {
+        case Effect::filter:     return filter;
+        case Effect::delay:      return delay;
+        case Effect::reverb:     return reverb;
+        case Effect::distortion: return distortion;
+    }
+    return nullptr;
+}
+
+void EffectsProcessor::setEffectEnabled(Effect effect, bool enabled)
+{
+    getUnit(effect)->setEnabled(enabled);
+}
+
+bool EffectsProcessor::isEffectEnabled(Effect effect) const
+{
+    return getUnit(effect)->isEnabled();
+}
+
+bool EffectsProcessor::isEffectActive(Effect effect) const
+{
+    return getUnit(effect)->isActive();
+}
+
+void EffectsProcessor::setEffectOrder(const std::array<Effect, numEffects>& order)
+{
+    std::vector<EffectUnit*> units;
+    for (auto effect : order)
+        units.push_back(getUnit(effect));
+
+    chain.setOrder(units);
+}
+
+std::array<EffectsProcessor::Effect, EffectsProcessor::numEffects> EffectsProcessor::getEffectOrder() const
+{
+    std::array<Effect, numEffects> order;
+    for (int i = 0; i < numEffects; ++i)
+        order[(size_t)i] = chain.getEffect(i)->getType();
+    return order;
 }
 
 void EffectsProcessor::setReverbParameters(float roomSize, float damping, float wetLevel, float dryLevel)
 {
-    juce::Reverb::Parameters params;
-    params.roomSize = roomSize;
-    params.damping = damping;
-    params.wetLevel = wetLevel;
-    params.dryLevel = dryLevel;
-    reverb.setParameters(params);
+    reverb->setParameters(roomSize, damping, wetLevel, dryLevel);
 }
 
 void EffectsProcessor::setDelayParameters(float time, float feedback, float mix)
 {
-    delay.setDelay(time);
-    delay.setFeedback(feedback);
-    delay.setMix(mix);
+    delay->setParameters(time, feedback, mix);
 }
 
 void EffectsProcessor::setFilterParameters(float cutoff, float resonance)
 {
-    filter.setCutoffFrequency(cutoff);
-    filter.setResonance(resonance);
+    filter->setParameters(cutoff, resonance);
 }
 
 void EffectsProcessor::setDistortionParameters(float drive, float mix)
 {
-    distortion.setGainDecibels(drive * 24.0f);
-} 
\ No newline at end of file
+    distortion->setParameters(drive, mix);
+}
@@ -1,52 +1,71 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EffectChain.h"
 
-class EffectsProcessor : public juce::AudioProcessor
+// The master effects: one filter, delay, reverb and distortion in an
+// EffectChain, in a reorderable order. Not a juce::AudioProcessor, so the
+// engine builds without the GUI modules.
+class EffectsProcessor
 {
 public:
+    using Effect = EffectUnit::Type;
+    static constexpr int numEffects = EffectUnit::numTypes;
+
     EffectsProcessor();
-    ~EffectsProcessor() override;
+    ~EffectsProcessor();
+
+    // Where the delay and reverb keep their lines; set before prepareToPlay
+    void setArena(AudioArena* arena) { chain.setArena(arena); }
 
-    // AudioProcessor methods
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void prepareToPlay(double sampleRate, int samplesPerBlock);
+    void releaseResources();
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&);
 
     // Effect controls
     void setReverbParameters(float roomSize, float damping, float wetLevel, float dryLevel);
     void setDelayParameters(float time, float feedback, float mix);
     void setFilterParameters(float cutoff, float resonance);
     void setDistortionParameters(float drive, float mix);
+    void setReverbQuality(FDNReverb::Quality quality) { reverb->setQuality(quality); }
+    void setDelayPingPong(bool shouldPingPong) { delay->setPingPong(shouldPingPong); }
+    void setDelayTempoSync(bool shouldSync, float beats) { delay->setTempoSync(shouldSync, beats); }
+    void setDistortionCurve(Waveshaper::Curve curve) { distortion->setCurve(curve); }
+    void setDistortionOversampling(int factor) { distortion->setOversampling(factor); }
+    void setTempo(double bpm) { chain.setTempo(bpm); }
+
+    juce::Reverb::Parameters getReverbParameters() const { return reverb->getParameters(); }
+    float getDelayTime() const { return delay->getTime(); }
+    float getDelayFeedback() const { return delay->getFeedback(); }
+    float getDelayMix() const { return delay->getMix(); }
+    float getFilterCutoff() const { return filter->getCutoff(); }
+    float getFilterResonance() const { return filter->getResonance(); }
+    float getDistortionDrive() const { return distortion->getDrive(); }
+    float getDistortionMix() const { return distortion->getMix(); }
 
-    // Effect bypass
+    // Whole-chain bypass
     void setEffectEnabled(bool enabled) { isEnabled = enabled; }
     bool isEffectEnabled() const { return isEnabled; }
 
-    // AudioProcessor interface
-    const juce::String getName() const override { return "EffectsProcessor"; }
-    bool acceptsMidi() const override { return false; }
-    bool producesMidi() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
-    int getNumPrograms() override { return 1; }
-    int getCurrentProgram() override { return 0; }
-    void setCurrentProgram(int) override {}
-    const juce::String getProgramName(int) override { return {}; }
-    void changeProgramName(int, const juce::String&) override {}
-    bool hasEditor() const override { return false; }
-    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
-    void getStateInformation(juce::MemoryBlock&) override {}
-    void setStateInformation(const void*, int) override {}
+    // Per-effect enable. Switching crossfades; a disabled delay or reverb
+    // rings out and then goes idle.
+    void setEffectEnabled(Effect effect, bool enabled);
+    bool isEffectEnabled(Effect effect) const;
+    bool isEffectActive(Effect effect) const;
 
-private:
-    juce::dsp::Reverb reverb;
-    juce::dsp::Delay<float> delay;
-    juce::dsp::StateVariableFilter::Filter<float> filter;
-    juce::dsp::Gain<float> distortion;
+    // Processing order, e.g. to put distortion before the filter
+    void setEffectOrder(const std::array<Effect, numEffects>& order);
+    std::array<Effect, numEffects> getEffectOrder() const;
 
-    juce::AudioBuffer<float> delayBuffer;
-    int delayWritePosition;
+private:
+    EffectChain chain;
+    FilterUnit* filter;
+    DelayUnit* delay;
+    ReverbUnit* reverb;
+    DistortionUnit* distortion;
     bool isEnabled;
 
+    EffectUnit* getUnit(Effect effect) const;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EffectsProcessor)
-}; 
\ No newline at end of file
+}; 
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// What the UI shows of the engine, copied on the audio thread at a fixed
+// rate and handed to the message thread through a TripleBuffer. Panels
+// draw from this rather than reading members the audio thread is writing.
+struct EngineSnapshot
+{
+    static constexpr int maxSlicerPlayheads = 16;
+    static constexpr int maxClipTracks = 4;
+    static constexpr int maxLooperTracks = 8;
+
+    juce::uint32 serial = 0;                // Counts snapshots; 0 before the first
+
+    bool transportPlaying = false;
+    double transportPosition = 0.0;         // Seconds
+    double transportLength = 0.0;
+
+    double looperMasterLength = 0.0;        // Seconds, 0 before the first loop
+    std::array<int, maxLooperTracks> looperStates {};       // LiveLooper::TrackState per track
+    std::array<float, maxLooperTracks> looperPositions {};  // Fractions of each track's loop
+
+    bool sequencerPlaying = false;
+    int sequencerStep = 0;
+    int sequencerNumSteps = 0;
+
+    std::array<int, maxClipTracks> clipPlayingScenes { -1, -1, -1, -1 };  // Per track, ClipLauncher::stopped if none
+    std::array<int, maxClipTracks> clipQueuedScenes { -2, -2, -2, -2 };   // ClipLauncher::nothingQueued if none
+
+    int slicerNumVoices = 0;
+    std::array<float, maxSlicerPlayheads> slicerPlayheads {};   // Fractions of the sample, first slicerNumVoices used
+};
@@ -0,0 +1,350 @@
+#include "FDNReverb.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define GROOVDECK_FDN_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define GROOVDECK_FDN_NEON 1
+#endif
+
+namespace
+{
+    // Mutually prime line lengths at 48 kHz, roughly 23 to 56 ms
+    constexpr int lineLengthsAt48k[FDNReverb::numLines] = { 1087, 1283, 1511, 1709, 1949, 2179, 2437, 2663 };
+
+    // Input is spread into the network with alternating signs
+    constexpr float inputGains[FDNReverb::numLines] = { 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f };
+
+    // Early reflections after the pre-delay: time in ms, left gain, right gain.
+    // Standard quality uses the first six, high quality all twelve.
+    struct EarlyTap
+    {
+        float timeMs;
+        float left;
+        float right;
+    };
+
+    constexpr EarlyTap earlyTaps[] = {
+        { 4.3f, 0.84f, 0.52f },  { 7.9f, 0.49f, 0.78f },  { 11.2f, 0.69f, 0.41f },
+        { 15.7f, 0.36f, 0.63f }, { 19.1f, 0.55f, 0.31f }, { 23.9f, 0.28f, 0.47f },
+        { 28.3f, 0.40f, 0.23f }, { 33.1f, 0.19f, 0.35f }, { 37.6f, 0.29f, 0.16f },
+        { 43.2f, 0.13f, 0.24f }, { 49.7f, 0.18f, 0.10f }, { 56.1f, 0.08f, 0.15f }
+    };
+
+    constexpr int numTapsStandard = 6;
+    constexpr int numTapsHigh = 12;
+    constexpr float maxEarlyTapMs = 60.0f;
+
+    constexpr float modulationRateHz = 0.5f;
+    constexpr float modulationDepthAt48k = 6.0f;
+
+    // 1 / sqrt(8), keeps the Hadamard matrix orthonormal
+    constexpr float hadamardScale = 0.35355339f;
+
+   #if GROOVDECK_FDN_SSE
+    // [x0+x2, x1+x3, x0-x2, x1-x3]
+    inline __m128 butterflyPairs(__m128 v)
+    {
+        const __m128 sign = _mm_set_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+        return _mm_add_ps(_mm_movelh_ps(v, v), _mm_mul_ps(_mm_movehl_ps(v, v), sign));
+    }
+
+    // [x0+x1, x0-x1, x2+x3, x2-x3]
+    inline __m128 butterflyNeighbours(__m128 v)
+    {
+        const __m128 sign = _mm_set_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+        const __m128 even = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 odd = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+        return _mm_add_ps(even, _mm_mul_ps(odd, sign));
+    }
+   #elif GROOVDECK_FDN_NEON
+    alignas(16) const float pairSigns[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+    alignas(16) const float neighbourSigns[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+
+    inline float32x4_t butterflyPairs(float32x4_t v)
+    {
+        const float32x2_t low = vget_low_f32(v);
+        const float32x2_t high = vget_high_f32(v);
+        return vmlaq_f32(vcombine_f32(low, low), vcombine_f32(high, high), vld1q_f32(pairSigns));
+    }
+
+    inline float32x4_t butterflyNeighbours(float32x4_t v)
+    {
+        const float32x4x2_t split = vtrnq_f32(v, v); // [x0,x0,x2,x2], [x1,x1,x3,x3]
+        return vmlaq_f32(split.val[0], split.val[1], vld1q_f32(neighbourSigns));
+    }
+   #endif
+}
+
+FDNReverb::FDNReverb()
+    : sampleRate(44100.0), lineSize(0), lineMask(0), writePosition(0),
+      dampingCoefficient(1.0f), preDelayMask(0), preDelayWritePosition(0), preDelaySamples(0),
+      lfoSin(0.0f), lfoCos(1.0f), lfoRotateSin(0.0f), lfoRotateCos(1.0f), modulationDepth(0.0f),
+      decaySeconds(1.6f), damping(0.5f), preDelayMs(20.0f), earlyLevel(0.5f), wetLevel(1.0f), width(1.0f),
+      quality((int)Quality::standard), parametersChanged(true)
+{
+    lineLengths.fill(0);
+    tapDelays.fill(0);
+}
+
+void FDNReverb::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    const double scale = sampleRate / 48000.0;
+
+    modulationDepth = (float)(modulationDepthAt48k * scale);
+
+    int longest = 0;
+    for (int i = 0; i < numLines; ++i)
+    {
+        lineLengths[(size_t)i] = juce::roundToInt(lineLengthsAt48k[i] * scale);
+        longest = juce::jmax(longest, lineLengths[(size_t)i]);
+    }
+
+    lineSize = juce::nextPowerOfTwo(longest + (int)std::ceil(modulationDepth) + 2);
+    lineMask = lineSize - 1;
+
+    for (size_t i = 0; i < tapDelays.size(); ++i)
+        tapDelays[i] = juce::roundToInt(earlyTaps[i].timeMs * 0.001 * sampleRate);
+
+    const int preDelaySize = juce::nextPowerOfTwo((int)((maxPreDelayMs + maxEarlyTapMs) * 0.001 * sampleRate) + 1);
+    preDelayMask = preDelaySize - 1;
+
+    const size_t linesBytes = AudioArena::roundUp((size_t)(lineSize * numLines) * sizeof(float));
+    memory = AudioArena::allocateFrom(audioArena, AudioArena::Subsystem::effects,
+                                      linesBytes + (size_t)preDelaySize * sizeof(float));
+    lines = memory.getData<float>();
+    preDelayLine = lines + linesBytes / sizeof(float);
+
+    const double lfoIncrement = juce::MathConstants<double>::twoPi * modulationRateHz / sampleRate;
+    lfoRotateSin = (float)std::sin(lfoIncrement);
+    lfoRotateCos = (float)std::cos(lfoIncrement);
+
+    reset();
+    updateCoefficients();
+}
+
+void FDNReverb::reset()
+{
+    if (lines != nullptr)
+    {
+        juce::FloatVectorOperations::clear(lines, lineSize * numLines);
+        juce::FloatVectorOperations::clear(preDelayLine, preDelayMask + 1);
+    }
+    std::fill(std::begin(lineOutputs), std::end(lineOutputs), 0.0f);
+    std::fill(std::begin(dampingState), std::end(dampingState), 0.0f);
+
+    writePosition = 0;
+    preDelayWritePosition = 0;
+    lfoSin = 0.0f;
+    lfoCos = 1.0f;
+}
+
+void FDNReverb::setParameters(const Parameters& newParameters)
+{
+    decaySeconds = newParameters.decaySeconds;
+    damping = newParameters.damping;
+    preDelayMs = newParameters.preDelayMs;
+    earlyLevel = newParameters.earlyLevel;
+    wetLevel = newParameters.wetLevel;
+    width = newParameters.width;
+    parametersChanged = true;
+}
+
+FDNReverb::Parameters FDNReverb::getParameters() const
+{
+    Parameters result;
+    result.decaySeconds = decaySeconds.load();
+    result.damping = damping.load();
+    result.preDelayMs = preDelayMs.load();
+    result.earlyLevel = earlyLevel.load();
+    result.wetLevel = wetLevel.load();
+    result.width = width.load();
+    return result;
+}
+
+void FDNReverb::updateCoefficients()
+{
+    // Each line loses 60 dB over the decay time, scaled by its own length
+    const double rt60 = juce::jmax(0.05, (double)decaySeconds.load());
+    for (int i = 0; i < numLines; ++i)
+        decayGains[i] = (float)std::pow(10.0, -3.0 * lineLengths[(size_t)i] / (rt60 * sampleRate));
+
+    // Damping sweeps the in-loop lowpass from 20 kHz down to 1.5 kHz
+    const double cutoff = juce::jmin(0.45 * sampleRate,
+                                     20000.0 * std::pow(1500.0 / 20000.0, (double)juce::jlimit(0.0f, 1.0f, damping.load())));
+    dampingCoefficient = (float)(1.0 - std::exp(-juce::MathConstants<double>::twoPi * cutoff / sampleRate));
+
+    preDelaySamples = juce::jlimit(0, juce::roundToInt(maxPreDelayMs * 0.001 * sampleRate),
+                                   juce::roundToInt(preDelayMs.load() * 0.001 * sampleRate));
+}
+
+void FDNReverb::mixFeedback(float* values, float* state, const float* gains, float coefficient)
+{
+   #if GROOVDECK_FDN_SSE
+    const __m128 c = _mm_set1_ps(coefficient);
+    const __m128 scale = _mm_set1_ps(hadamardScale);
+
+    __m128 s0 = _mm_load_ps(state);
+    __m128 s1 = _mm_load_ps(state + 4);
+    s0 = _mm_add_ps(s0, _mm_mul_ps(c, _mm_sub_ps(_mm_load_ps(values), s0)));
+    s1 = _mm_add_ps(s1, _mm_mul_ps(c, _mm_sub_ps(_mm_load_ps(values + 4), s1)));
+    _mm_store_ps(state, s0);
+    _mm_store_ps(state + 4, s1);
+
+    const __m128 a = _mm_mul_ps(s0, _mm_load_ps(gains));
+    const __m128 b = _mm_mul_ps(s1, _mm_load_ps(gains + 4));
+
+    // H8 = [H4 H4; H4 -H4]
+    _mm_store_ps(values, _mm_mul_ps(butterflyNeighbours(butterflyPairs(_mm_add_ps(a, b))), scale));
+    _mm_store_ps(values + 4, _mm_mul_ps(butterflyNeighbours(butterflyPairs(_mm_sub_ps(a, b))), scale));
+   #elif GROOVDECK_FDN_NEON
+    const float32x4_t c = vdupq_n_f32(coefficient);
+
+    float32x4_t s0 = vld1q_f32(state);
+    float32x4_t s1 = vld1q_f32(state + 4);
+    s0 = vmlaq_f32(s0, c, vsubq_f32(vld1q_f32(values), s0));
+    s1 = vmlaq_f32(s1, c, vsubq_f32(vld1q_f32(values + 4), s1));
+    vst1q_f32(state, s0);
+    vst1q_f32(state + 4, s1);
+
+    const float32x4_t a = vmulq_f32(s0, vld1q_f32(gains));
+    const float32x4_t b = vmulq_f32(s1, vld1q_f32(gains + 4));
+
+    // H8 = [H4 H4; H4 -H4]
+    vst1q_f32(values, vmulq_n_f32(butterflyNeighbours(butterflyPairs(vaddq_f32(a, b))), hadamardScale));
+    vst1q_f32(values + 4, vmulq_n_f32(butterflyNeighbours(butterflyPairs(vsubq_f32(a, b))), hadamardScale));
+   #else
+    for (int i = 0; i < numLines; ++i)
+    {
+        state[i] += coefficient * (values[i] - state[i]);
+        values[i] = state[i] * gains[i];
+    }
+
+    // In-place fast Walsh-Hadamard transform
+    for (int span = 1; span < numLines; span *= 2)
+    {
+        for (int i = 0; i < numLines; i += span * 2)
+        {
+            for (int j = i; j < i + span; ++j)
+            {
+                const float x = values[j];
+                const float y = values[j + span];
+                values[j] = x + y;
+                values[j + span] = x - y;
+            }
+        }
+    }
+
+    for (int i = 0; i < numLines; ++i)
+        values[i] *= hadamardScale;
+   #endif
+}
+
+float FDNReverb::readLine(int line, float delay) const
+{
+    const float position = (float)writePosition - delay;
+    const int whole = (int)std::floor(position);
+    const float fraction = position - (float)whole;
+
+    const float* data = lines + line * lineSize;
+    const float a = data[whole & lineMask];
+    const float b = data[(whole + 1) & lineMask];
+    return a + (b - a) * fraction;
+}
+
+void FDNReverb::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    const auto numChannels = block.getNumChannels();
+    const auto numSamples = block.getNumSamples();
+
+    if (numChannels == 0 || lines == nullptr)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    if (parametersChanged.exchange(false))
+        updateCoefficients();
+
+    const auto currentQuality = (Quality)quality.load();
+    const int numTaps = currentQuality == Quality::eco ? 0
+                      : currentQuality == Quality::standard ? numTapsStandard : numTapsHigh;
+    const bool modulate = currentQuality == Quality::high;
+
+    const float early = earlyLevel.load();
+    const float wet = wetLevel.load();
+    const float stereoWidth = width.load();
+
+    auto* left = block.getChannelPointer(0);
+    auto* right = numChannels > 1 ? block.getChannelPointer(1) : nullptr;
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        const float input = right != nullptr ? (left[i] + right[i]) * 0.5f : left[i];
+
+        preDelayLine[(size_t)preDelayWritePosition] = input;
+        const int reflectionStart = preDelayWritePosition - preDelaySamples;
+        const float networkInput = preDelayLine[(size_t)(reflectionStart & preDelayMask)];
+
+        float earlyLeft = 0.0f;
+        float earlyRight = 0.0f;
+        for (int t = 0; t < numTaps; ++t)
+        {
+            const float tap = preDelayLine[(size_t)((reflectionStart - tapDelays[(size_t)t]) & preDelayMask)];
+            earlyLeft += tap * earlyTaps[t].left;
+            earlyRight += tap * earlyTaps[t].right;
+        }
+
+        if (modulate)
+        {
+            // Rotate the quadrature LFO; the first four lines wobble against each other
+            const float nextSin = lfoSin * lfoRotateCos + lfoCos * lfoRotateSin;
+            lfoCos = lfoCos * lfoRotateCos - lfoSin * lfoRotateSin;
+            lfoSin = nextSin;
+
+            const float offsetA = modulationDepth * (0.5f + 0.5f * lfoSin);
+            const float offsetB = modulationDepth * (0.5f + 0.5f * lfoCos);
+
+            lineOutputs[0] = readLine(0, (float)lineLengths[0] + offsetA);
+            lineOutputs[1] = readLine(1, (float)lineLengths[1] + offsetB);
+            lineOutputs[2] = readLine(2, (float)lineLengths[2] + modulationDepth - offsetA);
+            lineOutputs[3] = readLine(3, (float)lineLengths[3] + modulationDepth - offsetB);
+
+            for (int l = 4; l < numLines; ++l)
+                lineOutputs[l] = lines[(size_t)(l * lineSize + ((writePosition - lineLengths[(size_t)l]) & lineMask))];
+        }
+        else
+        {
+            for (int l = 0; l < numLines; ++l)
+                lineOutputs[l] = lines[(size_t)(l * lineSize + ((writePosition - lineLengths[(size_t)l]) & lineMask))];
+        }
+
+        const float wetLeft = 0.5f * (lineOutputs[0] - lineOutputs[2] + lineOutputs[4] - lineOutputs[6]);
+        const float wetRight = 0.5f * (lineOutputs[1] - lineOutputs[3] + lineOutputs[5] - lineOutputs[7]);
+
+        mixFeedback(lineOutputs, dampingState, decayGains, dampingCoefficient);
+
+        for (int l = 0; l < numLines; ++l)
+            lines[(size_t)(l * lineSize + writePosition)] = lineOutputs[l] + networkInput * inputGains[l];
+
+        writePosition = (writePosition + 1) & lineMask;
+        preDelayWritePosition = (preDelayWritePosition + 1) & preDelayMask;
+
+        const float mid = 0.5f * (wetLeft + wetRight);
+        const float side = 0.5f * (wetLeft - wetRight) * stereoWidth;
+
+        left[i] = (mid + side) * wet + earlyLeft * early;
+        if (right != nullptr)
+            right[i] = (mid - side) * wet + earlyRight * early;
+    }
+
+    if (modulate)
+    {
+        // Keep the rotating phasor on the unit circle
+        const float magnitude = std::sqrt(lfoSin * lfoSin + lfoCos * lfoCos);
+        lfoSin /= magnitude;
+        lfoCos /= magnitude;
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioArena.h"
+
+// Feedback-delay-network reverb: eight delay lines mixed through a normalised
+// 8x8 Hadamard matrix (SSE or NEON where available), with per-line damping,
+// a pre-delay and a multi-tap early-reflections stage. Output is wet only.
+//
+// Quality trades features for CPU:
+//   eco       FDN only
+//   standard  FDN + 6 early reflections
+//   high      FDN + 12 early reflections + modulated delay lines
+//
+// Parameters can be set from any thread; coefficients are recalculated on
+// the audio thread at the start of the next block.
+//
+// Its CPU cost against juce::dsp::Reverb has not been measured yet;
+// bench/ReverbBenchmark.cpp compares the two on the target machine.
+class FDNReverb
+{
+public:
+    enum class Quality
+    {
+        eco,
+        standard,
+        high
+    };
+
+    struct Parameters
+    {
+        float decaySeconds = 1.6f;  // RT60
+        float damping = 0.5f;       // 0 = bright, 1 = dark
+        float preDelayMs = 20.0f;
+        float earlyLevel = 0.5f;
+        float wetLevel = 1.0f;
+        float width = 1.0f;
+    };
+
+    static constexpr int numLines = 8;
+    static constexpr float maxPreDelayMs = 250.0f;
+
+    FDNReverb();
+
+    // Where the delay lines are kept; the heap if never set. Called before prepare.
+    void setArena(AudioArena* newArena) { audioArena = newArena; }
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setParameters(const Parameters& newParameters);
+    Parameters getParameters() const;
+
+    void setQuality(Quality newQuality) { quality = (int)newQuality; }
+    Quality getQuality() const { return (Quality)quality.load(); }
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    // After prepare: how long the output has to stay silent before nothing is
+    // left to come out, i.e. the whole pre-delay line and the longest line
+    int getTailSamples() const { return preDelayMask + 1 + lineSize; }
+
+private:
+    double sampleRate;
+
+    AudioArena* audioArena = nullptr;
+    AudioArena::Block memory;       // Delay lines, then the pre-delay line
+
+    // Delay lines share one buffer, each lineSize long (a power of two)
+    float* lines = nullptr;
+    int lineSize;
+    int lineMask;
+    int writePosition;
+    std::array<int, numLines> lineLengths;
+
+    alignas(16) float lineOutputs[numLines];
+    alignas(16) float dampingState[numLines];
+    alignas(16) float decayGains[numLines];
+    float dampingCoefficient;
+
+    // Pre-delay and early reflections read from one mono buffer
+    float* preDelayLine = nullptr;
+    int preDelayMask;
+    int preDelayWritePosition;
+    int preDelaySamples;
+    std::array<int, 12> tapDelays;
+
+    // Quadrature LFO for the modulated lines in high quality
+    float lfoSin;
+    float lfoCos;
+    float lfoRotateSin;
+    float lfoRotateCos;
+    float modulationDepth;
+
+    // Shared with the control thread
+    std::atomic<float> decaySeconds;
+    std::atomic<float> damping;
+    std::atomic<float> preDelayMs;
+    std::atomic<float> earlyLevel;
+    std::atomic<float> wetLevel;
+    std::atomic<float> width;
+    std::atomic<int> quality;
+    std::atomic<bool> parametersChanged;
+
+    void updateCoefficients();
+    float readLine(int line, float delay) const;
+
+    static void mixFeedback(float* values, float* state, const float* gains, float coefficient);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FDNReverb)
+};
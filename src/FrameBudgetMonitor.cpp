@@ -0,0 +1,88 @@
+#include "FrameBudgetMonitor.h"
+
+namespace
+{
+    // A frame is late once it misses the next refresh by half a period
+    constexpr double lateFactor = 1.5;
+
+    constexpr int maxRefreshDivider = 4;
+
+    // About half a second at 60 Hz between throttling decisions
+    constexpr int framesPerDecision = 30;
+}
+
+FrameBudgetMonitor::FrameBudgetMonitor(double budget)
+    : budgetMs(budget), ticksToMs(1000.0 / (double)juce::Time::getHighResolutionTicksPerSecond())
+{
+}
+
+bool FrameBudgetMonitor::beginFrame()
+{
+    ++refreshesSincePaint;
+    if (++frameCounter % refreshDivider != 0)
+        return false;
+
+    const auto now = juce::Time::getHighResolutionTicks();
+
+    if (previousTicks != 0)
+    {
+        // Only painted frames are timed, per refresh since the last one, so
+        // skipped refreshes neither count as fast frames nor make the frame
+        // after them look slow
+        const double frameMs = (double)(now - previousTicks) * ticksToMs / refreshesSincePaint;
+
+        // A long pause, e.g. while the window was hidden, is not a slow frame
+        if (frameMs < budgetMs * 20.0)
+        {
+            totalMs += frameMs;
+            worstMs = juce::jmax(worstMs, frameMs);
+            ++numFrames;
+
+            if (frameMs > budgetMs * lateFactor)
+                ++numLate;
+
+            smoothedMs += 0.1 * (frameMs - smoothedMs);
+            adjustDivider();
+        }
+    }
+
+    previousTicks = now;
+    refreshesSincePaint = 0;
+    return true;
+}
+
+void FrameBudgetMonitor::adjustDivider()
+{
+    if (++framesSinceChange < framesPerDecision)
+        return;
+
+    if (smoothedMs > budgetMs * lateFactor && refreshDivider < maxRefreshDivider)
+    {
+        refreshDivider *= 2;
+        framesSinceChange = 0;
+    }
+    else if (smoothedMs < budgetMs * 1.1 && refreshDivider > 1)
+    {
+        refreshDivider /= 2;
+        framesSinceChange = 0;
+    }
+}
+
+FrameBudgetMonitor::Stats FrameBudgetMonitor::getStats() const
+{
+    Stats stats;
+    stats.averageMs = numFrames > 0 ? totalMs / numFrames : 0.0;
+    stats.worstMs = worstMs;
+    stats.numFrames = numFrames;
+    stats.numLate = numLate;
+    stats.refreshDivider = refreshDivider;
+    return stats;
+}
+
+void FrameBudgetMonitor::resetStats()
+{
+    totalMs = 0.0;
+    worstMs = 0.0;
+    numFrames = 0;
+    numLate = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Times UI frames on the message thread from one display refresh to the
+// next. A frame that arrives well after the refresh period means painting
+// and event handling overran, so while that keeps happening the monitor
+// asks for fewer refreshes, handing the CPU back rather than letting the
+// UI crowd the audio thread.
+class FrameBudgetMonitor
+{
+public:
+    struct Stats
+    {
+        double averageMs = 0.0;
+        double worstMs = 0.0;
+        int numFrames = 0;
+        int numLate = 0;            // Frames over the budget
+        int refreshDivider = 1;     // Showing every n-th refresh
+    };
+
+    explicit FrameBudgetMonitor(double budgetMs = 1000.0 / 60.0);
+
+    void setBudget(double milliseconds) { budgetMs = milliseconds; }
+    double getBudget() const { return budgetMs; }
+
+    // Message thread, at every display refresh. Returns false for refreshes
+    // that should be skipped to stay within budget; only the others are
+    // timed.
+    bool beginFrame();
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    double budgetMs;
+    double ticksToMs;
+    juce::int64 previousTicks = 0;
+    juce::int64 frameCounter = 0;
+    int refreshesSincePaint = 0;
+
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+    int numFrames = 0;
+    int numLate = 0;
+
+    // Throttling looks at the recent past only
+    double smoothedMs = 0.0;
+    int refreshDivider = 1;
+    int framesSinceChange = 0;
+
+    void adjustDivider();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FrameBudgetMonitor)
+};
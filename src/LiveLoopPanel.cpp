@@ -1,191 +1,221 @@
 #include "LiveLoopPanel.h"
 
+namespace
+{
+    // Length factors offered per track, with their combo box ids
+    const double lengthFactors[] = { 0.25, 0.5, 1.0, 2.0, 4.0 };
+    const char* lengthNames[] = { "1/4", "1/2", "x1", "x2", "x4" };
+
+    using TrackState = LiveLooper::TrackState;
+
+    bool isRecordingState(TrackState state)
+    {
+        return state == TrackState::recording || state == TrackState::overdubbing;
+    }
+
+    bool isPlayingState(TrackState state)
+    {
+        return state == TrackState::playing || state == TrackState::overdubbing;
+    }
+}
+
 LiveLoopPanel::LiveLoopPanel(LiveLooper& looper)
     : liveLooper(looper)
 {
-    // Setup buttons
-    recordButton.setButtonText("Record");
-    playButton.setButtonText("Play");
-    stopButton.setButtonText("Stop");
-    clearButton.setButtonText("Clear");
-    reverseButton.setButtonText("Reverse");
-    
-    // Setup sliders
-    setupSlider(loopLengthSlider, loopLengthLabel, "Loop Length", 1.0, 30.0, 0.1, 4.0);
-    setupSlider(loopGainSlider, loopGainLabel, "Loop Gain", 0.0, 2.0, 0.01, 1.0);
-    setupSlider(loopStartSlider, loopStartLabel, "Loop Start", 0.0, 30.0, 0.1, 0.0);
-    setupSlider(loopEndSlider, loopEndLabel, "Loop End", 0.0, 30.0, 0.1, 4.0);
-    
-    // Setup status label
-    statusLabel.setText("Ready", juce::dontSendNotification);
-    statusLabel.setJustificationType(juce::Justification::centred);
-    
-    // Add components
-    addAndMakeVisible(recordButton);
-    addAndMakeVisible(playButton);
-    addAndMakeVisible(stopButton);
-    addAndMakeVisible(clearButton);
-    addAndMakeVisible(reverseButton);
-    
-    addAndMakeVisible(loopLengthSlider);
-    addAndMakeVisible(loopGainSlider);
-    addAndMakeVisible(loopStartSlider);
-    addAndMakeVisible(loopEndSlider);
-    
-    addAndMakeVisible(loopLengthLabel);
-    addAndMakeVisible(loopGainLabel);
-    addAndMakeVisible(loopStartLabel);
-    addAndMakeVisible(loopEndLabel);
-    addAndMakeVisible(statusLabel);
-    
-    // Add listeners
-    recordButton.addListener(this);
-    playButton.addListener(this);
-    stopButton.addListener(this);
-    clearButton.addListener(this);
-    reverseButton.addListener(this);
-    
-    loopLengthSlider.addListener(this);
-    loopGainSlider.addListener(this);
-    loopStartSlider.addListener(this);
-    loopEndSlider.addListener(this);
-    
-    updateButtonStates();
+    for (int i = 0; i < numTracks; ++i)
+        setupRow(i);
+
+    clearAllButton.setButtonText("Clear All");
+    clearAllButton.onClick = [this] { liveLooper.clearAll(); };
+    addAndMakeVisible(clearAllButton);
+
+    masterLabel.setText("Master: free", juce::dontSendNotification);
+    addAndMakeVisible(masterLabel);
 }
 
 LiveLoopPanel::~LiveLoopPanel()
 {
-    // Remove listeners
-    recordButton.removeListener(this);
-    playButton.removeListener(this);
-    stopButton.removeListener(this);
-    clearButton.removeListener(this);
-    reverseButton.removeListener(this);
-    
-    loopLengthSlider.removeListener(this);
-    loopGainSlider.removeListener(this);
-    loopStartSlider.removeListener(this);
-    loopEndSlider.removeListener(this);
 }
 
-void LiveLoopPanel::paint(juce::Graphics& g)
+void LiveLoopPanel::setupRow(int track)
 {
-    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
-}
+    auto& row = rows[(size_t)track];
 
-void LiveLoopPanel::resized()
-{
-    auto area = getLocalBounds();
-    auto buttonHeight = 40;
-    auto margin = 10;
-    
-    // Control buttons
-    auto buttonArea = area.removeFromTop(buttonHeight * 2).reduced(margin);
-    recordButton.setBounds(buttonArea.removeFromTop(buttonHeight).reduced(5));
-    playButton.setBounds(buttonArea.removeFromLeft(buttonArea.getWidth() / 4).reduced(5));
-    stopButton.setBounds(buttonArea.removeFromLeft(buttonArea.getWidth() / 3).reduced(5));
-    clearButton.setBounds(buttonArea.removeFromLeft(buttonArea.getWidth() / 2).reduced(5));
-    reverseButton.setBounds(buttonArea.reduced(5));
-    
-    // Status display
-    statusLabel.setBounds(area.removeFromTop(30).reduced(margin));
-    
-    // Parameter sliders
-    auto sliderArea = area.removeFromTop(120).reduced(margin);
-    loopLengthSlider.setBounds(sliderArea.removeFromTop(30).reduced(5));
-    loopGainSlider.setBounds(sliderArea.removeFromTop(30).reduced(5));
-    loopStartSlider.setBounds(sliderArea.removeFromTop(30).reduced(5));
-    loopEndSlider.setBounds(sliderArea.removeFromTop(30).reduced(5));
+    row.numberLabel.setText(juce::String(track + 1), juce::dontSendNotification);
+    row.numberLabel.setJustificationType(juce::Justification::centred);
+
+    row.recordButton.onClick = [this, track]
+    {
+        if (isRecordingState(liveLooper.getTrackState(track)))
+            liveLooper.stopRecording(track);
+        else
+            liveLooper.startRecording(track);
+    };
+
+    row.playButton.onClick = [this, track]
+    {
+        if (isPlayingState(liveLooper.getTrackState(track)))
+            liveLooper.stopPlayback(track);
+        else
+            liveLooper.startPlayback(track);
+    };
+
+    row.clearButton.setButtonText("Clear");
+    row.clearButton.onClick = [this, track] { liveLooper.clearTrack(track); };
+
+    row.muteButton.setButtonText("Mute");
+    row.muteButton.onClick = [this, track] { liveLooper.setTrackMuted(track, rows[(size_t)track].muteButton.getToggleState()); };
+
+    row.reverseButton.setButtonText("Rev");
+    row.reverseButton.onClick = [this, track] { liveLooper.setTrackReversed(track, rows[(size_t)track].reverseButton.getToggleState()); };
+
+    for (int i = 0; i < (int)std::size(lengthFactors); ++i)
+        row.lengthBox.addItem(lengthNames[i], i + 1);
+    row.lengthBox.setSelectedId(3, juce::dontSendNotification);
+    row.lengthBox.onChange = [this, track]
+    {
+        const int index = rows[(size_t)track].lengthBox.getSelectedId() - 1;
+        if (juce::isPositiveAndBelow(index, (int)std::size(lengthFactors)))
+            liveLooper.setLengthFactor(track, lengthFactors[index]);
+    };
+
+    row.gainSlider.setRange(0.0, 2.0, 0.01);
+    row.gainSlider.setValue(liveLooper.getTrackGain(track), juce::dontSendNotification);
+    row.gainSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    row.gainSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    row.gainSlider.onValueChange = [this, track] { liveLooper.setTrackGain(track, (float)rows[(size_t)track].gainSlider.getValue()); };
+
+    for (auto* component : std::initializer_list<juce::Component*> { &row.numberLabel, &row.recordButton, &row.playButton,
+                                                                      &row.muteButton, &row.reverseButton, &row.clearButton,
+                                                                      &row.lengthBox, &row.gainSlider })
+        addAndMakeVisible(component);
+
+    updateRow(track, TrackState::empty);
 }
 
-void LiveLoopPanel::buttonClicked(juce::Button* button)
+void LiveLoopPanel::paint(juce::Graphics& g)
 {
-    if (button == &recordButton)
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+
+    // Each track's loop across its strip, with the playhead on top
+    for (int i = 0; i < numTracks; ++i)
     {
-        if (liveLooper.isRecording())
+        const auto& area = rows[(size_t)i].playheadArea;
+        const auto state = (TrackState)shown.looperStates[(size_t)i];
+
+        g.setColour(juce::Colours::darkgrey);
+        g.fillRect(area);
+
+        if (state == TrackState::empty)
+            continue;
+
+        switch (state)
         {
-            liveLooper.stopRecording();
+            case TrackState::recording:   g.setColour(juce::Colours::red.withAlpha(0.4f)); break;
+            case TrackState::overdubbing: g.setColour(juce::Colours::orange.withAlpha(0.4f)); break;
+            case TrackState::playing:     g.setColour(juce::Colours::green.withAlpha(0.4f)); break;
+            case TrackState::stopped:
+            case TrackState::empty:       g.setColour(juce::Colours::grey.withAlpha(0.4f)); break;
         }
-        else
+        g.fillRect(area.reduced(0, 2));
+
+        if (isPlayingState(state) || state == TrackState::recording)
         {
-            liveLooper.startRecording();
+            g.setColour(juce::Colours::white);
+            g.fillRect(getPlayheadX(i, shown), area.getY(), 2, area.getHeight());
         }
     }
-    else if (button == &playButton)
-    {
-        liveLooper.startPlayback();
-    }
-    else if (button == &stopButton)
-    {
-        liveLooper.stopPlayback();
-    }
-    else if (button == &clearButton)
-    {
-        liveLooper.clearLoop();
-    }
-    else if (button == &reverseButton)
-    {
-        liveLooper.reverseLoop();
-    }
-    
-    updateButtonStates();
-    updateStatus();
 }
 
-void LiveLoopPanel::sliderValueChanged(juce::Slider* slider)
+void LiveLoopPanel::resized()
 {
-    if (slider == &loopLengthSlider)
-    {
-        liveLooper.setLoopLength(loopLengthSlider.getValue());
-    }
-    else if (slider == &loopGainSlider)
+    auto area = getLocalBounds().reduced(4);
+
+    auto topArea = area.removeFromTop(36);
+    clearAllButton.setBounds(topArea.removeFromRight(100).reduced(2));
+    masterLabel.setBounds(topArea.reduced(2));
+
+    const int rowHeight = area.getHeight() / numTracks;
+    for (auto& row : rows)
     {
-        liveLooper.setLoopGain(static_cast<float>(loopGainSlider.getValue()));
+        auto rowArea = area.removeFromTop(rowHeight);
+        row.numberLabel.setBounds(rowArea.removeFromLeft(24));
+        row.recordButton.setBounds(rowArea.removeFromLeft(64).reduced(2));
+        row.playButton.setBounds(rowArea.removeFromLeft(56).reduced(2));
+        row.muteButton.setBounds(rowArea.removeFromLeft(64).reduced(2));
+        row.reverseButton.setBounds(rowArea.removeFromLeft(56).reduced(2));
+        row.clearButton.setBounds(rowArea.removeFromLeft(56).reduced(2));
+        row.lengthBox.setBounds(rowArea.removeFromLeft(64).reduced(2));
+        row.gainSlider.setBounds(rowArea.removeFromLeft(juce::jmin(110, rowArea.getWidth() / 3)).reduced(2));
+        row.playheadArea = rowArea.reduced(4, juce::jmax(2, rowArea.getHeight() / 4));
     }
-    else if (slider == &loopStartSlider)
+}
+
+void LiveLoopPanel::showSnapshot(const EngineSnapshot& snapshot)
+{
+    if (snapshot.looperMasterLength != shown.looperMasterLength)
     {
-        liveLooper.setLoopStart(loopStartSlider.getValue());
+        masterLabel.setText(snapshot.looperMasterLength > 0.0 ? "Master: " + juce::String(snapshot.looperMasterLength, 2) + " s"
+                                                              : "Master: free",
+                            juce::dontSendNotification);
     }
-    else if (slider == &loopEndSlider)
+
+    const auto previous = shown;
+    shown = snapshot;
+
+    for (int i = 0; i < numTracks; ++i)
     {
-        liveLooper.setLoopEnd(loopEndSlider.getValue());
+        const auto& area = rows[(size_t)i].playheadArea;
+        const auto state = (TrackState)snapshot.looperStates[(size_t)i];
+
+        if (snapshot.looperStates[(size_t)i] != previous.looperStates[(size_t)i])
+        {
+            // Also catches changes made elsewhere, e.g. by MIDI or loading a project
+            updateRow(i, state);
+            repaint(area);
+            continue;
+        }
+
+        const int previousX = getPlayheadX(i, previous);
+        const int x = getPlayheadX(i, shown);
+        if (x != previousX && state != TrackState::empty && state != TrackState::stopped)
+        {
+            repaint(previousX, area.getY(), 2, area.getHeight());
+            repaint(x, area.getY(), 2, area.getHeight());
+        }
     }
 }
 
-void LiveLoopPanel::updateButtonStates()
+int LiveLoopPanel::getPlayheadX(int track, const EngineSnapshot& snapshot) const
 {
-    recordButton.setEnabled(!liveLooper.isPlaying());
-    playButton.setEnabled(liveLooper.hasLoop() && !liveLooper.isRecording());
-    stopButton.setEnabled(liveLooper.isPlaying() || liveLooper.isRecording());
-    clearButton.setEnabled(liveLooper.hasLoop() || liveLooper.isRecording());
-    reverseButton.setEnabled(liveLooper.hasLoop());
+    const auto& area = rows[(size_t)track].playheadArea;
+    const float fraction = juce::jlimit(0.0f, 1.0f, snapshot.looperPositions[(size_t)track]);
+    return area.getX() + juce::roundToInt(fraction * (float)(area.getWidth() - 2));
 }
 
-void LiveLoopPanel::updateStatus()
+void LiveLoopPanel::updateRow(int track, LiveLooper::TrackState state)
 {
-    if (liveLooper.isRecording())
-    {
-        statusLabel.setText("Recording...", juce::dontSendNotification);
-    }
-    else if (liveLooper.isPlaying())
-    {
-        statusLabel.setText("Playing Loop", juce::dontSendNotification);
-    }
-    else if (liveLooper.hasLoop())
-    {
-        statusLabel.setText("Loop Ready", juce::dontSendNotification);
-    }
-    else
+    auto& row = rows[(size_t)track];
+
+    switch (state)
     {
-        statusLabel.setText("Ready", juce::dontSendNotification);
+        case TrackState::empty:       row.recordButton.setButtonText("Rec"); break;
+        case TrackState::recording:   row.recordButton.setButtonText("Finish"); break;
+        case TrackState::overdubbing: row.recordButton.setButtonText("End Dub"); break;
+        case TrackState::playing:
+        case TrackState::stopped:     row.recordButton.setButtonText("Dub"); break;
     }
-}
 
-void LiveLoopPanel::setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& name,
-                               double min, double max, double interval, double defaultValue)
-{
-    slider.setRange(min, max, interval);
-    slider.setValue(defaultValue);
-    slider.setSliderStyle(juce::Slider::LinearHorizontal);
-    label.setText(name, juce::dontSendNotification);
-} 
\ No newline at end of file
+    row.playButton.setButtonText(isPlayingState(state) ? "Stop" : "Play");
+    row.playButton.setEnabled(state != TrackState::empty && state != TrackState::recording);
+    row.clearButton.setEnabled(state != TrackState::empty);
+    row.recordButton.setColour(juce::TextButton::buttonColourId,
+                               isRecordingState(state) ? juce::Colours::red.darker()
+                                                       : getLookAndFeel().findColour(juce::TextButton::buttonColourId));
+
+    // The length of a recorded loop is fixed until it is cleared
+    row.lengthBox.setEnabled(state == TrackState::empty);
+    for (int i = 0; i < (int)std::size(lengthFactors); ++i)
+        if (lengthFactors[i] == liveLooper.getLengthFactor(track))
+            row.lengthBox.setSelectedId(i + 1, juce::dontSendNotification);
+}
@@ -2,10 +2,11 @@
 
 #include <JuceHeader.h>
 #include "LiveLooper.h"
+#include "EngineSnapshot.h"
 
-class LiveLoopPanel : public juce::Component,
-                     public juce::Button::Listener,
-                     public juce::Slider::Listener
+// One row per looper track: record/overdub, play/stop, mute, reverse, clear,
+// length relative to the master loop, gain, and a strip with the playhead.
+class LiveLoopPanel : public juce::Component
 {
 public:
     LiveLoopPanel(LiveLooper& looper);
@@ -13,38 +14,37 @@ public:
 
     void paint(juce::Graphics&) override;
     void resized() override;
-    void buttonClicked(juce::Button* button) override;
-    void sliderValueChanged(juce::Slider* slider) override;
+
+    // Moves the playheads, repainting only where they were and where they
+    // are now; rows whose state changed are refreshed whole
+    void showSnapshot(const EngineSnapshot& snapshot);
 
 private:
+    static constexpr int numTracks = LiveLooper::numTracks;
+
+    struct TrackRow
+    {
+        juce::Label numberLabel;
+        juce::TextButton recordButton;
+        juce::TextButton playButton;
+        juce::TextButton clearButton;
+        juce::ToggleButton muteButton;
+        juce::ToggleButton reverseButton;
+        juce::ComboBox lengthBox;
+        juce::Slider gainSlider;
+        juce::Rectangle<int> playheadArea;
+    };
+
     LiveLooper& liveLooper;
-    
-    // Loop control buttons
-    juce::TextButton recordButton;
-    juce::TextButton playButton;
-    juce::TextButton stopButton;
-    juce::TextButton clearButton;
-    juce::TextButton reverseButton;
-    
-    // Loop parameters
-    juce::Slider loopLengthSlider;
-    juce::Slider loopGainSlider;
-    juce::Slider loopStartSlider;
-    juce::Slider loopEndSlider;
-    
-    // Labels
-    juce::Label loopLengthLabel;
-    juce::Label loopGainLabel;
-    juce::Label loopStartLabel;
-    juce::Label loopEndLabel;
-    
-    // Status display
-    juce::Label statusLabel;
-    
-    void updateButtonStates();
-    void updateStatus();
-    void setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& name,
-                    double min, double max, double interval, double defaultValue);
+
+    std::array<TrackRow, numTracks> rows;
+    juce::TextButton clearAllButton;
+    juce::Label masterLabel;
+    EngineSnapshot shown;
+
+    void setupRow(int track);
+    void updateRow(int track, LiveLooper::TrackState state);
+    int getPlayheadX(int track, const EngineSnapshot& snapshot) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LiveLoopPanel)
-}; 
\ No newline at end of file
+};
@@ -1,8 +1,47 @@
 #include "LiveLooper.h"
 
+namespace
+{
+    // Regions start on 64-byte boundaries
+    int roundUpToAlignment(int numSamples)
+    {
+        return (numSamples + 15) & ~15;
+    }
+
+    // Calls fn(bufferOffset, position, numSamples) for each run of a loop
+    // that plays without wrapping, starting at time
+    template <typename Fn>
+    void forEachSegment(juce::int64 time, int cycleLength, int length, int numSamples, Fn&& fn)
+    {
+        int done = 0;
+        while (done < numSamples)
+        {
+            const int cyclePosition = (int)((time + done) % cycleLength);
+            const int position = cyclePosition % length;
+            const int run = juce::jmin(numSamples - done, length - position, cycleLength - cyclePosition);
+
+            fn(done, position, run);
+            done += run;
+        }
+    }
+
+    // speedRatio is the source rate over the target rate
+    juce::AudioBuffer<float> resample(const juce::AudioBuffer<float>& audio, double speedRatio)
+    {
+        juce::AudioBuffer<float> result(audio.getNumChannels(), (int)(audio.getNumSamples() / speedRatio));
+
+        for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+        {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(speedRatio, audio.getReadPointer(ch), result.getWritePointer(ch),
+                                 result.getNumSamples(), audio.getNumSamples(), 0);
+        }
+
+        return result;
+    }
+}
+
 LiveLooper::LiveLooper()
-    : sampleRate(44100.0), loopLength(4.0), currentPosition(0.0),
-      loopStartSample(0), loopEndSample(0), recording(false), playing(false), loopGain(1.0f)
 {
 }
 
@@ -12,147 +51,678 @@ LiveLooper::~LiveLooper()
 
 void LiveLooper::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
 {
-    sampleRate = newSampleRate;
-    loopLength = 4.0; // Default 4 second loop
-    updateLoopBounds();
-    
-    // Prepare buffers
-    int maxSamples = static_cast<int>(sampleRate * 30.0); // 30 second max
-    loopBuffer.setSize(2, maxSamples);
-    recordingBuffer.setSize(2, maxSamples);
-    loopBuffer.clear();
-    recordingBuffer.clear();
+    juce::ignoreUnused(samplesPerBlockExpected);
+
+    const juce::SpinLock::ScopedLockType sl(layoutLock);
+    ensureArena(newSampleRate);
 }
 
-void LiveLooper::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+void LiveLooper::ensureArena(double newSampleRate)
 {
-    if (!playing || !hasLoop())
+    const auto newSize = (size_t)juce::jmin((double)std::numeric_limits<int>::max(),
+                                            std::ceil(memoryBudget * newSampleRate) * 2.0);
+
+    if (arena != nullptr && newSize == arenaSize)
+    {
+        sampleRate = newSampleRate;
         return;
+    }
 
-    auto numSamples = bufferToFill.numSamples;
-    auto* leftChannel = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
-    auto* rightChannel = bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample);
+    // With nothing to keep, the old block goes back first so the arena never
+    // has to hold both
+    if (allTracksEmpty())
+    {
+        tracks.fill({});
+        arenaBlock.release();
+        arena = nullptr;
+    }
 
-    for (int i = 0; i < numSamples; ++i)
+    // Move the loops over, packed from the start, dropping any that no longer fit
+    auto newBlock = AudioArena::allocateFrom(audioArena, AudioArena::Subsystem::looper, newSize * sizeof(float));
+    auto* newArena = newBlock.getData<float>();
+    int used = 0;
+
+    for (int i = 0; i < numTracks; ++i)
     {
-        int sampleIndex = static_cast<int>(currentPosition * sampleRate);
-        
-        if (sampleIndex >= loopEndSample)
+        auto& track = tracks[(size_t)i];
+        if (track.capacity == 0)
+            continue;
+
+        if (track.state == TrackState::empty || track.length == 0 || used + track.capacity * 2 > (int)newSize)
         {
-            sampleIndex = loopStartSample;
-            currentPosition = loopStartSample / sampleRate;
+            track = {};
+            continue;
         }
 
-        if (sampleIndex < loopBuffer.getNumSamples())
+        for (int ch = 0; ch < 2; ++ch)
         {
-            leftChannel[i] = loopBuffer.getSample(0, sampleIndex) * loopGain;
-            rightChannel[i] = loopBuffer.getSample(1, sampleIndex) * loopGain;
+            juce::FloatVectorOperations::copy(newArena + used, arena + track.offsets[(size_t)ch], track.length);
+            track.offsets[(size_t)ch] = used;
+            used += track.capacity;
         }
+    }
+
+    arenaBlock = std::move(newBlock);
+    arena = newArena;
+    arenaSize = newSize;
+    sampleRate = newSampleRate;
 
-        currentPosition += 1.0 / sampleRate;
+    if (allTracksEmpty())
+        masterLength = 0;
+
+    publishState();
+}
+
+void LiveLooper::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    renderNextBlock(bufferToFill, juce::AudioBuffer<float>());
+}
+
+void LiveLooper::renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill, const juce::AudioBuffer<float>& input)
+{
+    const int numSamples = bufferToFill.numSamples;
+
+    const juce::SpinLock::ScopedTryLockType sl(layoutLock);
+    if (!sl.isLocked() || arena == nullptr)
+    {
+        clock += numSamples;
+        return;
+    }
+
+    handleCommands();
+
+    // Play before recording, so an overdub is heard over what was there
+    for (int i = 0; i < numTracks; ++i)
+        renderTrack(tracks[(size_t)i], trackControls[(size_t)i], bufferToFill);
+
+    if (input.getNumChannels() > 0)
+    {
+        for (int i = 0; i < numTracks; ++i)
+            recordTrack(i, input, juce::jmin(numSamples, input.getNumSamples()));
     }
+
+    clock += numSamples;
+    publishState();
 }
 
 void LiveLooper::releaseResources()
 {
-    loopBuffer.clear();
-    recordingBuffer.clear();
 }
 
-void LiveLooper::startRecording()
+void LiveLooper::renderTrack(Track& track, const TrackControls& controls, const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    if (!recording)
+    if ((track.state != TrackState::playing && track.state != TrackState::overdubbing) || track.length == 0)
     {
-        recording = true;
-        currentPosition = 0.0;
-        recordingBuffer.clear();
+        track.lastGain = 0.0f;
+        return;
     }
+
+    const float targetGain = controls.muted.load() ? 0.0f : controls.gain.load();
+    const float startGain = track.lastGain;
+    track.lastGain = targetGain;
+
+    if (startGain == 0.0f && targetGain == 0.0f)
+        return;
+
+    const bool reversed = controls.reversed.load();
+    const int numSamples = bufferToFill.numSamples;
+    const int numChannels = juce::jmin(2, bufferToFill.buffer->getNumChannels());
+    const int length = track.length;
+
+    forEachSegment(clock, getCycleLength(length), length, numSamples, [&](int offset, int position, int run)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* source = arena + track.offsets[(size_t)ch];
+            float* out = bufferToFill.buffer->getWritePointer(ch, bufferToFill.startSample + offset);
+
+            if (!reversed && startGain == targetGain)
+            {
+                juce::FloatVectorOperations::addWithMultiply(out, source + position, targetGain, run);
+                continue;
+            }
+
+            // Gain changes ramp across the block
+            const float gainStep = (targetGain - startGain) / (float)numSamples;
+            for (int i = 0; i < run; ++i)
+            {
+                const int index = reversed ? length - 1 - (position + i) : position + i;
+                out[i] += source[index] * (startGain + gainStep * (float)(offset + i));
+            }
+        }
+    });
 }
 
-void LiveLooper::stopRecording()
+void LiveLooper::recordTrack(int trackIndex, const juce::AudioBuffer<float>& input, int numSamples)
 {
-    if (recording)
+    auto& track = tracks[(size_t)trackIndex];
+    if (track.state != TrackState::recording && track.state != TrackState::overdubbing)
+        return;
+
+    auto inputChannel = [&input](int ch) { return input.getReadPointer(juce::jmin(ch, input.getNumChannels() - 1)); };
+    track.changed = true;
+
+    // The first loop runs free until stopped or out of room
+    if (track.state == TrackState::recording && masterLength.load() == 0)
+    {
+        const int count = juce::jmin(numSamples, track.capacity - track.recorded);
+        for (int ch = 0; ch < 2; ++ch)
+            juce::FloatVectorOperations::copy(arena + track.offsets[(size_t)ch] + track.recorded, inputChannel(ch), count);
+
+        track.recorded += count;
+        if (track.recorded >= track.capacity)
+            finishRecording(trackIndex, count);
+        return;
+    }
+
+    // Synced loops write their first pass, then add to it
+    const bool reversed = trackControls[(size_t)trackIndex].reversed.load();
+    const int length = track.length;
+
+    forEachSegment(clock, getCycleLength(length), length, numSamples, [&](int offset, int position, int run)
     {
-        recording = false;
-        // Copy recorded audio to loop buffer
-        int recordedSamples = static_cast<int>(currentPosition * sampleRate);
-        if (recordedSamples > 0)
+        const bool firstPass = track.state == TrackState::recording && track.recorded < length;
+        const int numToCopy = firstPass ? juce::jmin(run, length - track.recorded) : 0;
+
+        for (int ch = 0; ch < 2; ++ch)
         {
-            loopBuffer.clear();
-            loopBuffer.setSize(2, recordedSamples);
-            for (int ch = 0; ch < 2; ++ch)
+            float* loop = arena + track.offsets[(size_t)ch];
+            const float* in = inputChannel(ch) + offset;
+
+            if (reversed)
+            {
+                for (int i = 0; i < run; ++i)
+                {
+                    float& sample = loop[length - 1 - (position + i)];
+                    sample = i < numToCopy ? in[i] : sample + in[i];
+                }
+            }
+            else
             {
-                loopBuffer.copyFrom(ch, 0, recordingBuffer, ch, 0, recordedSamples);
+                juce::FloatVectorOperations::copy(loop + position, in, numToCopy);
+                juce::FloatVectorOperations::add(loop + position + numToCopy, in + numToCopy, run - numToCopy);
             }
-            loopLength = currentPosition;
-            updateLoopBounds();
         }
+
+        if (firstPass)
+        {
+            track.recorded += numToCopy;
+            if (track.recorded >= length)
+                track.state = track.stopAfterPass ? TrackState::playing : TrackState::overdubbing;
+        }
+    });
+}
+
+void LiveLooper::pushCommand(CommandType type, int track)
+{
+    if (!juce::isPositiveAndBelow(track, numTracks))
+        return;
+
+    // Several UI or MIDI threads may ask at once
+    const juce::SpinLock::ScopedLockType sl(commandLock);
+    const auto scope = commandFifo.write(1);
+    if (scope.blockSize1 > 0)
+        commands[(size_t)scope.startIndex1] = { type, track };
+    else if (scope.blockSize2 > 0)
+        commands[(size_t)scope.startIndex2] = { type, track };
+}
+
+void LiveLooper::handleCommands()
+{
+    auto handle = [this](const Command& command)
+    {
+        auto& track = tracks[(size_t)command.track];
+
+        switch (command.type)
+        {
+            case CommandType::record:
+                record(command.track);
+                break;
+
+            case CommandType::stopRecording:
+                finishRecording(command.track, 0);
+                break;
+
+            case CommandType::play:
+                if (track.state == TrackState::stopped)
+                    track.state = TrackState::playing;
+                break;
+
+            case CommandType::stop:
+                finishRecording(command.track, 0);
+                if (track.state == TrackState::playing || track.state == TrackState::overdubbing)
+                    track.state = TrackState::stopped;
+                break;
+
+            case CommandType::clear:
+                clear(command.track);
+                break;
+        }
+    };
+
+    const auto scope = commandFifo.read(commandFifo.getNumReady());
+    for (int i = 0; i < scope.blockSize1; ++i)
+        handle(commands[(size_t)(scope.startIndex1 + i)]);
+    for (int i = 0; i < scope.blockSize2; ++i)
+        handle(commands[(size_t)(scope.startIndex2 + i)]);
+}
+
+void LiveLooper::record(int trackIndex)
+{
+    auto& track = tracks[(size_t)trackIndex];
+
+    switch (track.state)
+    {
+        case TrackState::recording:
+        case TrackState::overdubbing:
+            return;
+
+        case TrackState::playing:
+        case TrackState::stopped:
+            track.state = TrackState::overdubbing;
+            return;
+
+        case TrackState::empty:
+            break;
     }
+
+    if (masterLength.load() == 0)
+    {
+        // Only one loop can set the master length
+        for (const auto& other : tracks)
+            if (other.state == TrackState::recording)
+                return;
+
+        // As much room as a master loop may take, less if the arena is short
+        int capacity = (int)(maxMasterLength * sampleRate);
+        while (!allocate(track, capacity))
+        {
+            capacity /= 2;
+            if (capacity < (int)sampleRate)
+                return;
+        }
+
+        track.length = 0;
+    }
+    else
+    {
+        const int length = getTrackLengthFor(trackIndex);
+        if (!allocate(track, length))
+            return;
+
+        track.length = length;
+    }
+
+    track.recorded = 0;
+    track.stopAfterPass = false;
+    track.state = TrackState::recording;
 }
 
-void LiveLooper::startPlayback()
+void LiveLooper::finishRecording(int trackIndex, int blockOffset)
+{
+    auto& track = tracks[(size_t)trackIndex];
+
+    if (track.state == TrackState::overdubbing)
+    {
+        track.state = TrackState::playing;
+        return;
+    }
+
+    if (track.state != TrackState::recording)
+        return;
+
+    if (masterLength.load() != 0)
+    {
+        track.stopAfterPass = true;
+        return;
+    }
+
+    if (track.recorded == 0)
+    {
+        clear(trackIndex);
+        return;
+    }
+
+    // This loop sets the master length; give back the room it did not use
+    // and start the clock so the loop plays from its beginning next sample
+    track.length = track.recorded;
+    track.capacity = roundUpToAlignment(track.recorded);
+    track.state = TrackState::playing;
+    masterLength = track.length;
+    clock = -blockOffset;
+}
+
+void LiveLooper::clear(int trackIndex)
+{
+    auto& track = tracks[(size_t)trackIndex];
+    track = {};
+    track.changed = true;
+
+    // With every track empty, the next loop sets a new master length
+    if (allTracksEmpty())
+        masterLength = 0;
+}
+
+bool LiveLooper::allTracksEmpty() const
+{
+    for (const auto& track : tracks)
+        if (track.state != TrackState::empty)
+            return false;
+
+    return true;
+}
+
+void LiveLooper::publishState()
 {
-    if (hasLoop())
+    for (int i = 0; i < numTracks; ++i)
     {
-        playing = true;
-        currentPosition = loopStartSample / sampleRate;
+        auto& track = tracks[(size_t)i];
+        auto& controls = trackControls[(size_t)i];
+
+        controls.state = (int)track.state;
+        controls.length = track.length;
+        controls.position = track.length > 0 ? getPosition(track.length, clock) : 0;
+        controls.capacity = track.capacity;
+        controls.offsets[0] = track.offsets[0];
+        controls.offsets[1] = track.offsets[1];
+
+        if (track.changed)
+        {
+            ++controls.generation;
+            track.changed = false;
+        }
     }
 }
 
+int LiveLooper::getTrackLengthFor(int trackIndex) const
+{
+    const int master = masterLength.load();
+    const double factor = getLengthFactor(trackIndex);
+
+    if (factor >= 1.0)
+        return master * juce::roundToInt(factor);
+
+    return juce::jmax(1, master / juce::roundToInt(1.0 / factor));
+}
+
+int LiveLooper::getCycleLength(int length) const
+{
+    // Divisions restart with every master cycle, so rounding never drifts
+    return juce::jmax(length, masterLength.load());
+}
+
+int LiveLooper::getPosition(int length, juce::int64 time) const
+{
+    if (length <= 0 || time < 0)
+        return 0;
+
+    return (int)(time % getCycleLength(length)) % length;
+}
+
+bool LiveLooper::allocate(Track& track, int samples)
+{
+    if (samples <= 0)
+        return false;
+
+    // One region per channel; the first is marked taken while finding the second
+    const int capacity = roundUpToAlignment(samples);
+    track.capacity = 0;
+
+    const int left = findFreeRegion(capacity);
+    if (left < 0)
+        return false;
+
+    track.offsets = { left, left };
+    track.capacity = capacity;
+
+    const int right = findFreeRegion(capacity);
+    if (right < 0)
+    {
+        track.capacity = 0;
+        return false;
+    }
+
+    track.offsets[1] = right;
+    track.changed = true;
+    return true;
+}
+
+int LiveLooper::findFreeRegion(int numFloats) const
+{
+    // First fit between the regions in use, at most two per track
+    std::array<juce::Range<int>, numTracks * 2> used;
+    int numUsed = 0;
+
+    for (const auto& track : tracks)
+        if (track.capacity > 0)
+            for (auto offset : track.offsets)
+                used[(size_t)numUsed++] = { offset, offset + track.capacity };
+
+    std::sort(used.begin(), used.begin() + numUsed,
+              [](juce::Range<int> a, juce::Range<int> b) { return a.getStart() < b.getStart(); });
+
+    int start = 0;
+    for (int i = 0; i < numUsed; ++i)
+    {
+        if (used[(size_t)i].getStart() - start >= numFloats)
+            return start;
+
+        start = juce::jmax(start, used[(size_t)i].getEnd());
+    }
+
+    return (int)arenaSize - start >= numFloats ? start : -1;
+}
+
+void LiveLooper::startRecording(int track)  { pushCommand(CommandType::record, track); }
+void LiveLooper::stopRecording(int track)   { pushCommand(CommandType::stopRecording, track); }
+void LiveLooper::startPlayback(int track)   { pushCommand(CommandType::play, track); }
+void LiveLooper::stopPlayback(int track)    { pushCommand(CommandType::stop, track); }
+void LiveLooper::clearTrack(int track)      { pushCommand(CommandType::clear, track); }
+
+void LiveLooper::startPlayback()
+{
+    for (int i = 0; i < numTracks; ++i)
+        if (hasLoop(i))
+            startPlayback(i);
+}
+
 void LiveLooper::stopPlayback()
 {
-    playing = false;
+    for (int i = 0; i < numTracks; ++i)
+        stopPlayback(i);
 }
 
-void LiveLooper::clearLoop()
+void LiveLooper::clearAll()
 {
-    playing = false;
-    recording = false;
-    loopBuffer.clear();
-    currentPosition = 0.0;
+    const juce::SpinLock::ScopedLockType sl(layoutLock);
+
+    for (auto& track : tracks)
+    {
+        track = {};
+        track.changed = true;
+    }
+
+    masterLength = 0;
+    publishState();
 }
 
-void LiveLooper::setLoopLength(double lengthInSeconds)
+void LiveLooper::setLengthFactor(int track, double factor)
 {
-    loopLength = lengthInSeconds;
-    updateLoopBounds();
+    if (juce::isPositiveAndBelow(track, numTracks))
+        trackControls[(size_t)track].lengthFactor = juce::jlimit(0.25, 4.0, factor);
 }
 
-void LiveLooper::setLoopStart(double startTime)
+bool LiveLooper::hasLoop(int track) const
 {
-    loopStartSample = static_cast<int>(startTime * sampleRate);
-    updateLoopBounds();
+    const auto state = getTrackState(track);
+    return state == TrackState::playing || state == TrackState::overdubbing || state == TrackState::stopped;
 }
 
-void LiveLooper::setLoopEnd(double endTime)
+bool LiveLooper::hasLoop() const
 {
-    loopEndSample = static_cast<int>(endTime * sampleRate);
-    updateLoopBounds();
+    for (int i = 0; i < numTracks; ++i)
+        if (hasLoop(i))
+            return true;
+
+    return false;
 }
 
-void LiveLooper::reverseLoop()
+bool LiveLooper::isRecording() const
 {
-    if (hasLoop())
+    for (int i = 0; i < numTracks; ++i)
+    {
+        const auto state = getTrackState(i);
+        if (state == TrackState::recording || state == TrackState::overdubbing)
+            return true;
+    }
+
+    return false;
+}
+
+double LiveLooper::getTrackPosition(int track) const
+{
+    return trackControls[(size_t)track].position.load() / sampleRate;
+}
+
+size_t LiveLooper::getUsedBytes() const
+{
+    size_t floats = 0;
+    for (const auto& controls : trackControls)
+        floats += (size_t)controls.capacity.load() * 2;
+
+    return floats * sizeof(float);
+}
+
+void LiveLooper::readLoop(int trackIndex, juce::AudioBuffer<float>& destination, int numSamples, float gain, bool reversed)
+{
+    // Read through the published layout, so the audio thread never waits;
+    // a track cleared while this runs only garbles this copy
+    const auto& controls = trackControls[(size_t)trackIndex];
+    const int length = controls.length.load();
+
+    if (length == 0 || arena == nullptr)
+        return;
+
+    forEachSegment(0, getCycleLength(length), length, numSamples, [&](int offset, int position, int run)
     {
-        juce::AudioBuffer<float> reversedBuffer(2, loopBuffer.getNumSamples());
         for (int ch = 0; ch < 2; ++ch)
         {
-            for (int i = 0; i < loopBuffer.getNumSamples(); ++i)
-            {
-                reversedBuffer.setSample(ch, i, loopBuffer.getSample(ch, loopBuffer.getNumSamples() - 1 - i));
-            }
+            const float* source = arena + controls.offsets[(size_t)ch].load();
+            float* out = destination.getWritePointer(ch, offset);
+
+            for (int i = 0; i < run; ++i)
+                out[i] += gain * source[reversed ? length - 1 - (position + i) : position + i];
         }
-        loopBuffer = std::move(reversedBuffer);
+    });
+}
+
+std::shared_ptr<const juce::AudioBuffer<float>> LiveLooper::getLoopSnapshot(int track)
+{
+    if (!hasLoop(track))
+        return nullptr;
+
+    auto& snapshot = snapshots[(size_t)track];
+    const auto& controls = trackControls[(size_t)track];
+    const auto generation = controls.generation.load();
+
+    if (snapshot.buffer == nullptr || snapshot.generation != generation)
+    {
+        const int length = controls.length.load();
+        auto buffer = std::make_shared<juce::AudioBuffer<float>>(2, length);
+        buffer->clear();
+        readLoop(track, *buffer, length, 1.0f, false);
+
+        snapshot = { generation, std::move(buffer) };
     }
+
+    return snapshot.buffer;
 }
 
-void LiveLooper::setLoopGain(float gain)
+std::shared_ptr<const juce::AudioBuffer<float>> LiveLooper::getMixSnapshot()
 {
-    loopGain = gain;
+    int length = 0;
+    for (int i = 0; i < numTracks; ++i)
+        if (hasLoop(i) && !isTrackMuted(i))
+            length = juce::jmax(length, getCycleLength(trackControls[(size_t)i].length.load()));
+
+    if (length == 0)
+        return nullptr;
+
+    auto buffer = std::make_shared<juce::AudioBuffer<float>>(2, length);
+    buffer->clear();
+
+    for (int i = 0; i < numTracks; ++i)
+        if (hasLoop(i) && !isTrackMuted(i))
+            readLoop(i, *buffer, length, getTrackGain(i), isTrackReversed(i));
+
+    return buffer;
 }
 
-void LiveLooper::updateLoopBounds()
+void LiveLooper::loadLoop(int trackIndex, const juce::AudioBuffer<float>& audio, double audioSampleRate)
 {
-    loopStartSample = 0;
-    loopEndSample = static_cast<int>(loopLength * sampleRate);
-} 
\ No newline at end of file
+    if (!juce::isPositiveAndBelow(trackIndex, numTracks))
+        return;
+
+    // Loops play sample for sample against the master, so they are converted
+    // up front, before the audio thread is held off
+    if (audioSampleRate > 0.0 && audioSampleRate != sampleRate)
+    {
+        loadLoop(trackIndex, resample(audio, audioSampleRate / sampleRate));
+        return;
+    }
+
+    const juce::SpinLock::ScopedLockType sl(layoutLock);
+    ensureArena(sampleRate);
+
+    auto& track = tracks[(size_t)trackIndex];
+    track = {};
+    track.changed = true;
+
+    bool otherLoops = false;
+    for (const auto& other : tracks)
+        otherLoops = otherLoops || other.length > 0;
+
+    const int numSamples = audio.getNumSamples();
+    int length = 0;
+
+    if (numSamples > 0 && audio.getNumChannels() > 0)
+    {
+        if (!otherLoops)
+        {
+            masterLength = juce::jmin(numSamples, (int)(maxMasterLength * sampleRate));
+            trackControls[(size_t)trackIndex].lengthFactor = 1.0;
+            clock = 0;
+        }
+        else
+        {
+            // The nearest of the allowed multiples and divisions
+            const double ratio = (double)numSamples / juce::jmax(1, masterLength.load());
+            const double factor = std::pow(2.0, juce::jlimit(-2.0, 2.0, std::round(std::log2(ratio))));
+            trackControls[(size_t)trackIndex].lengthFactor = factor;
+        }
+
+        length = getTrackLengthFor(trackIndex);
+    }
+
+    if (length > 0 && allocate(track, length))
+    {
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            float* loop = arena + track.offsets[(size_t)ch];
+            const int numToCopy = juce::jmin(length, numSamples);
+
+            juce::FloatVectorOperations::copy(loop, audio.getReadPointer(juce::jmin(ch, audio.getNumChannels() - 1)), numToCopy);
+            juce::FloatVectorOperations::clear(loop + numToCopy, length - numToCopy);
+        }
+
+        track.length = length;
+        track.recorded = length;
+        track.state = TrackState::stopped;
+    }
+    else if (!otherLoops)
+    {
+        masterLength = 0;
+    }
+
+    publishState();
+}
@@ -1,52 +1,196 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AudioArena.h"
 
+// Layered live looping on numTracks tracks recording from the engine's input.
+// The first loop recorded sets the master length; every other track is a
+// multiple or division of it and plays in phase with it, so layers line up
+// however late they were started.
+//
+// All loop audio lives in one arena block, taken from the engine's
+// AudioArena in prepareToPlay and sized by a memory budget, and tracks take
+// regions of it as they record. Recording, overdubs
+// and clearing never allocate, and all tracks are mixed in one pass of
+// vector operations per block.
 class LiveLooper : public juce::AudioSource
 {
 public:
+    static constexpr int numTracks = 8;
+    static constexpr double maxMasterLength = 30.0;     // Seconds
+
+    enum class TrackState
+    {
+        empty,
+        recording,      // First pass of a new loop
+        overdubbing,
+        playing,
+        stopped
+    };
+
     LiveLooper();
     ~LiveLooper() override;
 
-    // AudioSource methods
+    // Where the loop memory comes from; the heap if never set. Set before
+    // prepareToPlay.
+    void setArena(AudioArena* newArena) { audioArena = newArena; }
+
+    // Seconds of stereo audio for all tracks together. Takes effect at the
+    // next prepareToPlay; loops that still fit are kept.
+    void setMemoryBudget(double seconds) { memoryBudget = juce::jmax(maxMasterLength, seconds); }
+    double getMemoryBudget() const { return memoryBudget; }
+    size_t getArenaBytes() const { return arenaSize * sizeof(float); }
+    size_t getUsedBytes() const;
+
+    // AudioSource methods; getNextAudioBlock plays without recording
     void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
     void releaseResources() override;
 
-    // Loop control
-    void startRecording();
-    void stopRecording();
-    void startPlayback();
+    // Audio thread: adds every playing track to the buffer and records the
+    // input, numSamples long, into the tracks that are recording
+    void renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill, const juce::AudioBuffer<float>& input);
+
+    // Track control. Any thread; takes effect at the start of the next block.
+    // Recording an empty track starts a loop, recording a full one overdubs
+    // it. Stopping a new synced loop before one full pass lets it finish the
+    // pass first, so it never plays audio it did not record.
+    void startRecording(int track);
+    void stopRecording(int track);
+    void startPlayback(int track);
+    void stopPlayback(int track);
+    void clearTrack(int track);
+    void startPlayback();       // Every track with a loop
     void stopPlayback();
-    void clearLoop();
-    void setLoopLength(double lengthInSeconds);
-    
-    // Loop state
-    bool isRecording() const { return recording; }
-    bool isPlaying() const { return playing; }
-    bool hasLoop() const { return loopBuffer.getNumSamples() > 0; }
-    double getCurrentPosition() const { return currentPosition; }
-    double getLoopLength() const { return loopLength; }
-
-    // Loop manipulation
-    void setLoopStart(double startTime);
-    void setLoopEnd(double endTime);
-    void reverseLoop();
-    void setLoopGain(float gain);
+
+    // Message thread: empties every track at once, e.g. before loading a project
+    void clearAll();
+
+    // Loop length of a track relative to the master, used when it records
+    // next: 2 and 4 are multiples, 0.5 and 0.25 divisions
+    void setLengthFactor(int track, double factor);
+    double getLengthFactor(int track) const { return trackControls[(size_t)track].lengthFactor.load(); }
+
+    void setTrackMuted(int track, bool muted) { trackControls[(size_t)track].muted = muted; }
+    bool isTrackMuted(int track) const { return trackControls[(size_t)track].muted.load(); }
+    void setTrackGain(int track, float gain) { trackControls[(size_t)track].gain = gain; }
+    float getTrackGain(int track) const { return trackControls[(size_t)track].gain.load(); }
+    void setTrackReversed(int track, bool reversed) { trackControls[(size_t)track].reversed = reversed; }
+    bool isTrackReversed(int track) const { return trackControls[(size_t)track].reversed.load(); }
+
+    // State, as of the last block
+    TrackState getTrackState(int track) const { return (TrackState)trackControls[(size_t)track].state.load(); }
+    bool hasLoop(int track) const;
+    bool hasLoop() const;       // On any track
+    bool isRecording() const;   // Any track
+    double getMasterLength() const { return masterLength.load() / sampleRate; }   // 0 before the first loop
+    double getTrackLength(int track) const { return trackControls[(size_t)track].length.load() / sampleRate; }
+    double getTrackPosition(int track) const;   // Seconds into the track's loop
+    double getSampleRate() const { return sampleRate; }
+
+    // Project state. Snapshots are immutable copies: the loop of one track
+    // as recorded, its gain, mute and reverse being settings of their own,
+    // or every unmuted track mixed over the longest loop, as heard. A loaded
+    // loop with no master yet becomes the master; otherwise its length is
+    // rounded to the nearest multiple or division. Audio at another rate
+    // than the looper's is converted first; an audioSampleRate of 0 means it
+    // already matches. Message thread.
+    std::shared_ptr<const juce::AudioBuffer<float>> getLoopSnapshot(int track);
+    std::shared_ptr<const juce::AudioBuffer<float>> getMixSnapshot();
+    void loadLoop(int track, const juce::AudioBuffer<float>& audio, double audioSampleRate = 0.0);
 
 private:
-    juce::AudioBuffer<float> loopBuffer;
-    juce::AudioBuffer<float> recordingBuffer;
-    double sampleRate;
-    double loopLength;
-    double currentPosition;
-    int loopStartSample;
-    int loopEndSample;
-    bool recording;
-    bool playing;
-    float loopGain;
-
-    void updateLoopBounds();
+    // Any thread
+    struct TrackControls
+    {
+        std::atomic<double> lengthFactor { 1.0 };
+        std::atomic<bool> muted { false };
+        std::atomic<bool> reversed { false };
+        std::atomic<float> gain { 1.0f };
+
+        // Written on the audio thread for everyone else. The generation
+        // counts changes to the audio, for snapshots.
+        std::atomic<int> state { (int)TrackState::empty };
+        std::atomic<int> length { 0 };
+        std::atomic<int> position { 0 };
+        std::atomic<int> capacity { 0 };
+        std::array<std::atomic<int>, 2> offsets {};
+        std::atomic<juce::uint32> generation { 0 };
+    };
+
+    struct Snapshot
+    {
+        juce::uint32 generation = 0;
+        std::shared_ptr<const juce::AudioBuffer<float>> buffer;
+    };
+
+    // Audio thread, or any thread holding layoutLock
+    struct Track
+    {
+        TrackState state = TrackState::empty;
+        std::array<int, 2> offsets {};  // Regions in the arena, one per channel
+        int capacity = 0;               // Samples per channel, 0 when there are no regions
+        int length = 0;                 // Loop length in samples
+        int recorded = 0;               // Samples of the first pass written so far
+        bool stopAfterPass = false;
+        bool changed = false;
+        float lastGain = 0.0f;
+    };
+
+    enum class CommandType
+    {
+        record,
+        stopRecording,
+        play,
+        stop,
+        clear
+    };
+
+    struct Command
+    {
+        CommandType type;
+        int track;
+    };
+
+    AudioArena* audioArena = nullptr;
+    AudioArena::Block arenaBlock;
+    float* arena = nullptr;         // arenaBlock's data
+    size_t arenaSize = 0;           // Floats
+    double memoryBudget = numTracks * maxMasterLength;
+    double sampleRate = 44100.0;
+
+    std::array<Track, numTracks> tracks;
+    std::array<TrackControls, numTracks> trackControls;
+    std::array<Snapshot, numTracks> snapshots;      // Message thread
+    std::atomic<int> masterLength { 0 };
+    juce::int64 clock = 0;          // Samples since the master loop started
+
+    // Held by the message thread to load loops or move the arena; the audio
+    // thread skips its work for a block rather than wait for it
+    juce::SpinLock layoutLock;
+
+    juce::AbstractFifo commandFifo { 64 };
+    std::array<Command, 64> commands;
+    juce::SpinLock commandLock;
+
+    void pushCommand(CommandType type, int track);
+    void handleCommands();
+    void record(int trackIndex);
+    void finishRecording(int trackIndex, int blockOffset);
+    void clear(int trackIndex);
+    void publishState();
+
+    int getTrackLengthFor(int trackIndex) const;
+    int getCycleLength(int length) const;
+    int getPosition(int length, juce::int64 time) const;
+    bool allocate(Track& track, int samples);
+    int findFreeRegion(int numFloats) const;
+    bool allTracksEmpty() const;
+    void ensureArena(double newSampleRate);
+
+    void renderTrack(Track& track, const TrackControls& controls, const juce::AudioSourceChannelInfo& bufferToFill);
+    void recordTrack(int trackIndex, const juce::AudioBuffer<float>& input, int numSamples);
+    void readLoop(int trackIndex, juce::AudioBuffer<float>& destination, int numSamples, float gain, bool reversed);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LiveLooper)
-}; 
\ No newline at end of file
+};
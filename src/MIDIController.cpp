@@ -1,50 +1,180 @@
 #include "MIDIController.h"
 
 MIDIController::MIDIController()
-    : learnMode(false), clockTempo(120.0)
+    : outputsInUse(0), numOpenOutputs(0), deviceWatcher(*this), learnMode(false), clockTempo(120.0),
+      outputSender(*this), clockRunning(false), clockPhase(0.0),
+      sampleRate(44100.0), lastBlockTime(0.0), outputLatencySamples(0),
+      latencyCount(0), latencyMean(0.0), latencyM2(0.0), latencyMax(0.0),
+      latencyResetRequested(false), publishedAverageMs(0.0), publishedJitterMs(0.0),
+      publishedMaxMs(0.0), publishedNumEvents(0)
 {
-    scanForDevices();
+    pendingMidi.ensureSize(MIDIEventQueue::capacity * 3);
+    filteredMidi.ensureSize(MIDIEventQueue::capacity * 3);
 }
 
 MIDIController::~MIDIController()
 {
+    deviceWatcher.stopThread(2000);
+    outputSender.stopThread(2000);
     disconnectDevice();
-}
 
-void MIDIController::scanForDevices()
-{
-    // MIDI devices are automatically detected by JUCE
+    const juce::ScopedLock sl(deviceLock);
+    for (auto& slot : outputSlots)
+    {
+        closeOutputSlot(slot);
+        slot.name = {};
+    }
 }
 
-bool MIDIController::connectToDevice(const juce::String& deviceName)
+void MIDIController::scanForDevices()
 {
-    disconnectDevice();
+    const auto inputDevices = juce::MidiInput::getAvailableDevices();
+    const auto outputDevices = juce::MidiOutput::getAvailableDevices();
+    bool changed = false;
 
-    auto devices = juce::MidiInput::getAvailableDevices();
-    for (const auto& device : devices)
     {
-        if (device.name == deviceName)
+        const juce::ScopedLock sl(deviceLock);
+
+        for (auto& slot : inputSlots)
         {
-            midiInput = juce::MidiInput::openDevice(device.identifier, this);
-            if (midiInput != nullptr)
+            if (slot.name.isEmpty())
+                continue;
+
+            const bool present = std::any_of(inputDevices.begin(), inputDevices.end(),
+                                             [&slot](const juce::MidiDeviceInfo& info) { return info.name == slot.name; });
+
+            if (present && slot.device == nullptr)
+                changed |= openInputSlot(slot, inputDevices);
+            else if (!present && slot.device != nullptr)
             {
-                midiInput->start();
-                connectedDevice = deviceName;
-                return true;
+                closeInputSlot(slot);
+                changed = true;
+            }
+        }
+
+        for (auto& slot : outputSlots)
+        {
+            if (slot.name.isEmpty())
+                continue;
+
+            const bool present = std::any_of(outputDevices.begin(), outputDevices.end(),
+                                             [&slot](const juce::MidiDeviceInfo& info) { return info.name == slot.name; });
+
+            if (present && slot.device == nullptr)
+                changed |= openOutputSlot(slot, outputDevices);
+            else if (!present && slot.device != nullptr)
+            {
+                closeOutputSlot(slot);
+                changed = true;
             }
         }
     }
-    return false;
+
+    if (changed && juce::MessageManager::getInstanceWithoutCreating() != nullptr)
+    {
+        juce::MessageManager::callAsync([safeThis = juce::WeakReference<MIDIController>(this)]
+        {
+            if (safeThis != nullptr && safeThis->onDevicesChanged)
+                safeThis->onDevicesChanged();
+        });
+    }
+}
+
+bool MIDIController::openInputDevice(const juce::String& deviceName, const MIDIInputRouting& routing)
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    auto* slot = findInputSlot(deviceName);
+    if (slot == nullptr)
+        slot = findInputSlot({});
+    if (slot == nullptr)
+        return false;
+
+    slot->name = deviceName;
+    slot->channel = routing.channel;
+    slot->toInstruments = routing.toInstruments;
+    slot->toMappings = routing.toMappings;
+    startDeviceWatcher();
+
+    return slot->device != nullptr || openInputSlot(*slot, juce::MidiInput::getAvailableDevices());
+}
+
+void MIDIController::closeInputDevice(const juce::String& deviceName)
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    if (auto* slot = findInputSlot(deviceName))
+    {
+        closeInputSlot(*slot);
+        slot->name = {};
+    }
+}
+
+bool MIDIController::openOutputDevice(const juce::String& deviceName, const MIDIOutputRouting& routing)
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    auto* slot = findOutputSlot(deviceName);
+    if (slot == nullptr)
+        slot = findOutputSlot({});
+    if (slot == nullptr)
+        return false;
+
+    slot->name = deviceName;
+    slot->channel = routing.channel;
+    slot->sendNotes = routing.sendNotes;
+    slot->sendControllers = routing.sendControllers;
+    slot->sendClock = routing.sendClock;
+    startDeviceWatcher();
+
+    return slot->device != nullptr || openOutputSlot(*slot, juce::MidiOutput::getAvailableDevices());
+}
+
+void MIDIController::closeOutputDevice(const juce::String& deviceName)
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    if (auto* slot = findOutputSlot(deviceName))
+    {
+        closeOutputSlot(*slot);
+        slot->name = {};
+    }
+}
+
+void MIDIController::setInputRouting(const juce::String& deviceName, const MIDIInputRouting& routing)
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    if (auto* slot = findInputSlot(deviceName))
+    {
+        slot->channel = routing.channel;
+        slot->toInstruments = routing.toInstruments;
+        slot->toMappings = routing.toMappings;
+    }
+}
+
+void MIDIController::setOutputRouting(const juce::String& deviceName, const MIDIOutputRouting& routing)
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    if (auto* slot = findOutputSlot(deviceName))
+    {
+        slot->channel = routing.channel;
+        slot->sendNotes = routing.sendNotes;
+        slot->sendControllers = routing.sendControllers;
+        slot->sendClock = routing.sendClock;
+    }
 }
 
 void MIDIController::disconnectDevice()
 {
-    if (midiInput != nullptr)
+    const juce::ScopedLock sl(deviceLock);
+
+    for (auto& slot : inputSlots)
     {
-        midiInput->stop();
-        midiInput = nullptr;
+        closeInputSlot(slot);
+        slot.name = {};
     }
-    connectedDevice = "";
 }
 
 juce::StringArray MIDIController::getAvailableDevices() const
@@ -58,8 +188,177 @@ juce::StringArray MIDIController::getAvailableDevices() const
     return deviceNames;
 }
 
+juce::StringArray MIDIController::getAvailableOutputDevices() const
+{
+    juce::StringArray deviceNames;
+    auto devices = juce::MidiOutput::getAvailableDevices();
+    for (const auto& device : devices)
+    {
+        deviceNames.add(device.name);
+    }
+    return deviceNames;
+}
+
+juce::StringArray MIDIController::getOpenInputDevices() const
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    juce::StringArray deviceNames;
+    for (const auto& slot : inputSlots)
+    {
+        if (slot.device != nullptr)
+            deviceNames.add(slot.name);
+    }
+    return deviceNames;
+}
+
+juce::StringArray MIDIController::getOpenOutputDevices() const
+{
+    const juce::ScopedLock sl(deviceLock);
+
+    juce::StringArray deviceNames;
+    for (const auto& slot : outputSlots)
+    {
+        if (slot.device != nullptr)
+            deviceNames.add(slot.name);
+    }
+    return deviceNames;
+}
+
+bool MIDIController::isConnected() const
+{
+    return std::any_of(inputSlots.begin(), inputSlots.end(),
+                       [](const InputSlot& slot) { return slot.active.load() != nullptr; });
+}
+
+juce::String MIDIController::getConnectedDevice() const
+{
+    return getOpenInputDevices().joinIntoString(", ");
+}
+
+bool MIDIController::openInputSlot(InputSlot& slot, const juce::Array<juce::MidiDeviceInfo>& devices)
+{
+    for (const auto& device : devices)
+    {
+        if (device.name == slot.name)
+        {
+            slot.device = juce::MidiInput::openDevice(device.identifier, this);
+            if (slot.device != nullptr)
+            {
+                slot.active = slot.device.get();
+                slot.device->start();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool MIDIController::openOutputSlot(OutputSlot& slot, const juce::Array<juce::MidiDeviceInfo>& devices)
+{
+    for (const auto& device : devices)
+    {
+        if (device.name == slot.name)
+        {
+            slot.device = juce::MidiOutput::openDevice(device.identifier);
+            if (slot.device != nullptr)
+            {
+                // Needed for sendBlockOfMessages to deliver at the timestamps
+                slot.device->startBackgroundThread();
+                slot.active = slot.device.get();
+                ++numOpenOutputs;
+
+                if (!outputSender.isThreadRunning())
+                    outputSender.startThread();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void MIDIController::closeInputSlot(InputSlot& slot)
+{
+    slot.active = nullptr;
+
+    if (slot.device != nullptr)
+    {
+        slot.device->stop();
+        slot.device = nullptr;
+    }
+}
+
+void MIDIController::closeOutputSlot(OutputSlot& slot)
+{
+    slot.active = nullptr;
+
+    // The output thread may be halfway through a batch on this device
+    while (outputsInUse.load() > 0)
+        juce::Thread::yield();
+
+    if (slot.device != nullptr)
+    {
+        slot.device->stopBackgroundThread();
+        slot.device = nullptr;
+        --numOpenOutputs;
+    }
+}
+
+void MIDIController::startDeviceWatcher()
+{
+    // Only devices asked for by name are watched, so there is nothing to
+    // poll for until the first one is
+    if (!deviceWatcher.isThreadRunning())
+        deviceWatcher.startThread();
+}
+
+MIDIController::InputSlot* MIDIController::findInputSlot(const juce::String& deviceName)
+{
+    for (auto& slot : inputSlots)
+    {
+        if (slot.name == deviceName)
+            return &slot;
+    }
+    return nullptr;
+}
+
+MIDIController::OutputSlot* MIDIController::findOutputSlot(const juce::String& deviceName)
+{
+    for (auto& slot : outputSlots)
+    {
+        if (slot.name == deviceName)
+            return &slot;
+    }
+    return nullptr;
+}
+
 void MIDIController::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
 {
+    const InputSlot* slot = nullptr;
+    for (const auto& candidate : inputSlots)
+    {
+        if (candidate.active.load() == source)
+        {
+            slot = &candidate;
+            break;
+        }
+    }
+
+    if (slot == nullptr)
+        return;
+
+    const int channel = slot->channel.load();
+    if (channel != 0 && message.getChannel() != 0 && message.getChannel() != channel)
+        return;
+
+    // Queue the raw event with its timestamp; the audio thread places it at
+    // the right sample offset in the next block
+    if (slot->toInstruments.load())
+        inputQueue.push(message);
+
+    if (!slot->toMappings.load())
+        return;
+
     processMIDIMessage(message);
     
     if (onMIDIMessage)
@@ -68,6 +367,82 @@ void MIDIController::handleIncomingMidiMessage(juce::MidiInput* source, const ju
     }
 }
 
+void MIDIController::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    lastBlockTime = 0.0;
+    clockPhase = 0.0;
+    inputQueue.clear();
+}
+
+void MIDIController::removeNextBlockOfMessages(juce::MidiBuffer& destBuffer, int numSamples)
+{
+    const double now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+
+    if (lastBlockTime <= 0.0)
+        lastBlockTime = now - numSamples / sampleRate;
+
+    // Events that arrived between the previous callback and this one are laid
+    // out across this block at the same relative position. That trades one
+    // block of constant latency for zero jitter, which is what drummers notice.
+    const double elapsed = juce::jmax(1.0e-6, now - lastBlockTime);
+    const double blockStart = lastBlockTime;
+    const double outputLatency = outputLatencySamples.load() / sampleRate;
+
+    if (latencyResetRequested.exchange(false))
+    {
+        latencyCount = 0;
+        latencyMean = 0.0;
+        latencyM2 = 0.0;
+        latencyMax = 0.0;
+    }
+
+    const int numRead = inputQueue.popAll([&](const TimestampedMIDIEvent& event)
+    {
+        const double relative = (event.timestamp - blockStart) / elapsed;
+        const int offset = juce::jlimit(0, numSamples - 1, juce::roundToInt(relative * numSamples));
+
+        destBuffer.addEvent(event.data, event.size, offset);
+
+        if ((event.data[0] & 0xf0) == 0x90 && event.size == 3 && event.data[2] > 0)
+            addLatencyMeasurement(now + offset / sampleRate + outputLatency - event.timestamp);
+    });
+
+    if (numRead > 0)
+        publishLatencyStats();
+
+    lastBlockTime = now;
+}
+
+MIDILatencyStats MIDIController::getLatencyStats() const
+{
+    MIDILatencyStats stats;
+    stats.averageMs = publishedAverageMs.load();
+    stats.jitterMs = publishedJitterMs.load();
+    stats.maxMs = publishedMaxMs.load();
+    stats.numEvents = publishedNumEvents.load();
+    return stats;
+}
+
+void MIDIController::addLatencyMeasurement(double latencySeconds)
+{
+    // Welford's running mean/variance, no history needed
+    ++latencyCount;
+    const double delta = latencySeconds - latencyMean;
+    latencyMean += delta / latencyCount;
+    latencyM2 += delta * (latencySeconds - latencyMean);
+    latencyMax = juce::jmax(latencyMax, latencySeconds);
+}
+
+void MIDIController::publishLatencyStats()
+{
+    const double variance = latencyCount > 1 ? latencyM2 / (latencyCount - 1) : 0.0;
+    publishedAverageMs = latencyMean * 1000.0;
+    publishedJitterMs = std::sqrt(variance) * 1000.0;
+    publishedMaxMs = latencyMax * 1000.0;
+    publishedNumEvents = latencyCount;
+}
+
 void MIDIController::addNoteMapping(int channel, int note, const juce::String& function, float minVal, float maxVal)
 {
     MIDIMapping mapping;
@@ -110,52 +485,36 @@ void MIDIController::clearMappings()
 
 void MIDIController::sendNoteOn(int channel, int note, int velocity)
 {
-    if (midiOutput != nullptr)
-    {
-        midiOutput->sendMessageNow(juce::MidiMessage::noteOn(channel, note, (juce::uint8)velocity));
-    }
+    queueOutgoing(juce::MidiMessage::noteOn(channel, note, (juce::uint8)velocity));
 }
 
 void MIDIController::sendNoteOff(int channel, int note)
 {
-    if (midiOutput != nullptr)
-    {
-        midiOutput->sendMessageNow(juce::MidiMessage::noteOff(channel, note));
-    }
+    queueOutgoing(juce::MidiMessage::noteOff(channel, note));
 }
 
 void MIDIController::sendCC(int channel, int cc, int value)
 {
-    if (midiOutput != nullptr)
-    {
-        midiOutput->sendMessageNow(juce::MidiMessage::controllerEvent(channel, cc, value));
-    }
+    queueOutgoing(juce::MidiMessage::controllerEvent(channel, cc, value));
 }
 
 void MIDIController::sendProgramChange(int channel, int program)
 {
-    if (midiOutput != nullptr)
-    {
-        midiOutput->sendMessageNow(juce::MidiMessage::programChange(channel, program));
-    }
+    queueOutgoing(juce::MidiMessage::programChange(channel, program));
 }
 
 void MIDIController::startClock()
 {
-    // Start MIDI clock
-    if (midiOutput != nullptr)
-    {
-        midiOutput->sendMessageNow(juce::MidiMessage::midiClock());
-    }
+    // Start MIDI clock; the pulses themselves are generated per audio block
+    queueOutgoing(juce::MidiMessage::midiStart());
+    clockRunning = true;
 }
 
 void MIDIController::stopClock()
 {
     // Stop MIDI clock
-    if (midiOutput != nullptr)
-    {
-        midiOutput->sendMessageNow(juce::MidiMessage::midiStop());
-    }
+    clockRunning = false;
+    queueOutgoing(juce::MidiMessage::midiStop());
 }
 
 void MIDIController::setClockTempo(double bpm)
@@ -163,6 +522,116 @@ void MIDIController::setClockTempo(double bpm)
     clockTempo = bpm;
 }
 
+void MIDIController::sendNextBlockOfMessages(int numSamples)
+{
+    // The first sample of this block is heard after the device's output latency
+    const double blockStart = juce::Time::getMillisecondCounterHiRes() * 0.001
+                                  + outputLatencySamples.load() / sampleRate;
+
+    // With no output open the queue is still drained and the clock kept in
+    // phase, but nothing is handed on
+    const bool sending = numOpenOutputs.load() > 0;
+    bool anyQueued = false;
+
+    // Anything queued since the last block goes out at the start of this one
+    outputQueue.popAll([this, blockStart, sending, &anyQueued](const TimestampedMIDIEvent& event)
+    {
+        if (event.data[0] == 0xfa)
+            clockPhase = 0.0;
+
+        if (!sending)
+            return;
+
+        auto timed = event;
+        timed.timestamp = blockStart;
+        anyQueued |= sendQueue.push(timed);
+    });
+
+    // 24 pulses per quarter note, placed on their exact samples
+    if (clockRunning.load())
+    {
+        const double samplesPerPulse = sampleRate * 60.0 / (juce::jmax(1.0, clockTempo.load()) * 24.0);
+
+        TimestampedMIDIEvent clock {};
+        clock.data[0] = 0xf8;
+        clock.size = 1;
+
+        while (clockPhase < numSamples)
+        {
+            clock.timestamp = blockStart + (int)clockPhase / sampleRate;
+            if (sending)
+                anyQueued |= sendQueue.push(clock);
+            clockPhase += samplesPerPulse;
+        }
+        clockPhase -= numSamples;
+    }
+
+    // Wakes the output thread, which otherwise sleeps
+    if (anyQueued)
+        outputSender.notify();
+}
+
+void MIDIController::sendPendingMessages()
+{
+    // One batch of everything due, positioned in microseconds from its first event
+    pendingMidi.clear();
+    double batchStart = 0.0;
+
+    sendQueue.popAll([this, &batchStart](const TimestampedMIDIEvent& event)
+    {
+        if (pendingMidi.isEmpty())
+            batchStart = event.timestamp;
+
+        pendingMidi.addEvent(event.data, event.size, juce::jmax(0, juce::roundToInt((event.timestamp - batchStart) * 1.0e6)));
+    });
+
+    if (pendingMidi.isEmpty())
+        return;
+
+    ++outputsInUse;
+    for (auto& slot : outputSlots)
+    {
+        auto* device = slot.active.load();
+        if (device == nullptr)
+            continue;
+
+        filteredMidi.clear();
+        for (const auto metadata : pendingMidi)
+        {
+            const auto message = metadata.getMessage();
+            if (outputAccepts(slot, message))
+                filteredMidi.addEvent(message, metadata.samplePosition);
+        }
+
+        if (!filteredMidi.isEmpty())
+            device->sendBlockOfMessages(filteredMidi, batchStart * 1000.0, 1.0e6);
+    }
+    --outputsInUse;
+}
+
+void MIDIController::queueOutgoing(const juce::MidiMessage& message)
+{
+    outputQueue.push(message);
+}
+
+bool MIDIController::outputAccepts(const OutputSlot& slot, const juce::MidiMessage& message)
+{
+    if (message.isMidiClock() || message.isMidiStart() || message.isMidiStop() || message.isMidiContinue())
+        return slot.sendClock.load();
+
+    const int channel = slot.channel.load();
+    if (channel != 0 && message.getChannel() != channel)
+        return false;
+
+    if (message.isNoteOnOrOff())
+        return slot.sendNotes.load();
+
+    if (message.isController() || message.isProgramChange())
+        return slot.sendControllers.load();
+
+    return true;
+}
+
 void MIDIController::processMIDIMessage(const juce::MidiMessage& message)
 {
     if (learnMode && !learnFunction.isEmpty())
@@ -210,4 +679,34 @@ void MIDIController::processMIDIMessage(const juce::MidiMessage& message)
 float MIDIController::normalizeValue(int value, float minVal, float maxVal)
 {
     return minVal + (maxVal - minVal) * (value / 127.0f);
+}
+
+MIDIController::OutputSender::OutputSender(MIDIController& owner)
+    : juce::Thread("MIDI output"), controller(owner)
+{
+}
+
+void MIDIController::OutputSender::run()
+{
+    // Woken by the audio thread once per block with something to send; each
+    // batch is scheduled ahead by the output latency, which absorbs the wakeup
+    while (!threadShouldExit())
+    {
+        wait(-1);
+        controller.sendPendingMessages();
+    }
+}
+
+MIDIController::DeviceWatcher::DeviceWatcher(MIDIController& owner)
+    : juce::Thread("MIDI device watcher"), controller(owner)
+{
+}
+
+void MIDIController::DeviceWatcher::run()
+{
+    while (!threadShouldExit())
+    {
+        controller.scanForDevices();
+        wait(1000);
+    }
 } 
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "MIDIEventQueue.h"
 
 struct MIDIMapping
 {
@@ -14,28 +15,95 @@ struct MIDIMapping
     MIDIMapping() : channel(0), note(0), cc(0), function(""), minValue(0.0f), maxValue(1.0f) {}
 };
 
+// Pad-to-sound latency of incoming MIDI, measured from the message timestamp
+// to the moment its sample offset reaches the DAC.
+struct MIDILatencyStats
+{
+    double averageMs;
+    double jitterMs;    // Standard deviation of the latency
+    double maxMs;
+    int numEvents;
+
+    MIDILatencyStats() : averageMs(0.0), jitterMs(0.0), maxMs(0.0), numEvents(0) {}
+};
+
+// Where the messages of one input device go
+struct MIDIInputRouting
+{
+    int channel;            // 0 = omni, otherwise only this channel passes
+    bool toInstruments;     // Queued for sample-accurate playback on the audio thread
+    bool toMappings;        // Fed to MIDI learn, CC mappings and onMIDIMessage
+
+    MIDIInputRouting() : channel(0), toInstruments(true), toMappings(true) {}
+};
+
+// Which outgoing messages one output device receives
+struct MIDIOutputRouting
+{
+    int channel;            // 0 = all channels
+    bool sendNotes;
+    bool sendControllers;   // CCs and program changes
+    bool sendClock;         // Clock, start and stop
+
+    MIDIOutputRouting() : channel(0), sendNotes(true), sendControllers(true), sendClock(true) {}
+};
+
 class MIDIController : public juce::MidiInputCallback
 {
 public:
+    static constexpr int maxInputDevices = 8;
+    static constexpr int maxOutputDevices = 8;
+
     MIDIController();
     ~MIDIController() override;
 
-    // MIDI device management
+    // MIDI device management. Opened devices are remembered by name, and the
+    // hot-plug watcher reopens them whenever they reappear. The watcher starts
+    // with the first device opened; until then no thread touches MIDI.
     void scanForDevices();
-    bool connectToDevice(const juce::String& deviceName);
-    void disconnectDevice();
+    bool openInputDevice(const juce::String& deviceName, const MIDIInputRouting& routing = {});
+    void closeInputDevice(const juce::String& deviceName);
+    bool openOutputDevice(const juce::String& deviceName, const MIDIOutputRouting& routing = {});
+    void closeOutputDevice(const juce::String& deviceName);
+    void setInputRouting(const juce::String& deviceName, const MIDIInputRouting& routing);
+    void setOutputRouting(const juce::String& deviceName, const MIDIOutputRouting& routing);
     juce::StringArray getAvailableDevices() const;
+    juce::StringArray getAvailableOutputDevices() const;
+    juce::StringArray getOpenInputDevices() const;
+    juce::StringArray getOpenOutputDevices() const;
+
+    // Single-device helpers kept for existing callers
+    bool connectToDevice(const juce::String& deviceName) { return openInputDevice(deviceName); }
+    void disconnectDevice();
+
+    // Called on the message thread after the watcher saw devices come or go
+    std::function<void()> onDevicesChanged;
 
     // MIDI callback
     void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
 
+    // Audio thread: timestamped event rendering
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void setOutputLatency(int latencyInSamples) { outputLatencySamples = latencyInSamples; }
+    void removeNextBlockOfMessages(juce::MidiBuffer& destBuffer, int numSamples);
+    // Clock pulses and queued messages for this block, handed with their due
+    // times to the output thread, which sends them. The output thread starts
+    // with the first output opened and only wakes when this hands it work.
+    void sendNextBlockOfMessages(int numSamples);
+
+    // Latency measurement
+    MIDILatencyStats getLatencyStats() const;
+    void resetLatencyStats() { latencyResetRequested = true; }
+
     // MIDI mapping
     void addNoteMapping(int channel, int note, const juce::String& function, float minVal = 0.0f, float maxVal = 1.0f);
     void addCCMapping(int channel, int cc, const juce::String& function, float minVal = 0.0f, float maxVal = 1.0f);
     void removeMapping(int channel, int note, int cc);
     void clearMappings();
 
-    // MIDI output
+    // MIDI output. Messages are queued from any thread and timed by the audio
+    // block they fall in; an output thread sends them as timestamped batches
+    // to every output whose routing accepts them.
     void sendNoteOn(int channel, int note, int velocity);
     void sendNoteOff(int channel, int note);
     void sendCC(int channel, int cc, int value);
@@ -45,7 +113,7 @@ public:
     void startClock();
     void stopClock();
     void setClockTempo(double bpm);
-    double getClockTempo() const { return clockTempo; }
+    double getClockTempo() const { return clockTempo.load(); }
 
     // MIDI learn
     void enableLearnMode(bool enable) { learnMode = enable; }
@@ -53,24 +121,120 @@ public:
     void setLearnFunction(const juce::String& function) { learnFunction = function; }
 
     // MIDI state
-    bool isConnected() const { return midiInput != nullptr; }
-    juce::String getConnectedDevice() const { return connectedDevice; }
+    bool isConnected() const;
+    juce::String getConnectedDevice() const;
 
-    // MIDI message callback
+    // MIDI message callback. Called on the MIDI thread for control and UI use;
+    // anything that makes sound should go through removeNextBlockOfMessages.
     std::function<void(const juce::MidiMessage&)> onMIDIMessage;
 
 private:
-    std::unique_ptr<juce::MidiInput> midiInput;
-    std::unique_ptr<juce::MidiOutput> midiOutput;
-    juce::String connectedDevice;
+    // A device the user asked for. The slot outlives the device itself, so an
+    // unplugged controller keeps its routing until it comes back.
+    struct InputSlot
+    {
+        juce::String name;
+        std::unique_ptr<juce::MidiInput> device;
+        std::atomic<juce::MidiInput*> active { nullptr };
+        std::atomic<int> channel { 0 };
+        std::atomic<bool> toInstruments { true };
+        std::atomic<bool> toMappings { true };
+    };
+
+    struct OutputSlot
+    {
+        juce::String name;
+        std::unique_ptr<juce::MidiOutput> device;
+        std::atomic<juce::MidiOutput*> active { nullptr };
+        std::atomic<int> channel { 0 };
+        std::atomic<bool> sendNotes { true };
+        std::atomic<bool> sendControllers { true };
+        std::atomic<bool> sendClock { true };
+    };
+
+    // Polls the device lists off the message thread and reopens devices
+    class DeviceWatcher : public juce::Thread
+    {
+    public:
+        DeviceWatcher(MIDIController& owner);
+        void run() override;
+
+    private:
+        MIDIController& controller;
+    };
+
+    // Sends what the audio thread timed, so device calls, which lock and
+    // allocate, stay off the audio thread
+    class OutputSender : public juce::Thread
+    {
+    public:
+        OutputSender(MIDIController& owner);
+        void run() override;
+
+    private:
+        MIDIController& controller;
+    };
+
+    std::array<InputSlot, maxInputDevices> inputSlots;
+    std::array<OutputSlot, maxOutputDevices> outputSlots;
+    juce::CriticalSection deviceLock;
+    std::atomic<int> outputsInUse;
+    std::atomic<int> numOpenOutputs;
+    DeviceWatcher deviceWatcher;
     std::vector<MIDIMapping> mappings;
     bool learnMode;
     juce::String learnFunction;
-    double clockTempo;
+    std::atomic<double> clockTempo;
     juce::MidiMessageSequence clockSequence;
 
+    // Incoming events waiting for the next audio block
+    MIDIEventQueue inputQueue;
+
+    // Outgoing events waiting for the next audio block
+    MIDIEventQueue outputQueue;
+
+    // Timed events on their way from the audio thread to the output thread,
+    // and the output thread's batches
+    MIDIEventQueue sendQueue;
+    OutputSender outputSender;
+    juce::MidiBuffer pendingMidi;
+    juce::MidiBuffer filteredMidi;
+    std::atomic<bool> clockRunning;
+    double clockPhase;
+    double sampleRate;
+    double lastBlockTime;
+    std::atomic<int> outputLatencySamples;
+
+    // Latency accumulators, owned by the audio thread
+    int latencyCount;
+    double latencyMean;
+    double latencyM2;
+    double latencyMax;
+    std::atomic<bool> latencyResetRequested;
+
+    // Published latency figures
+    std::atomic<double> publishedAverageMs;
+    std::atomic<double> publishedJitterMs;
+    std::atomic<double> publishedMaxMs;
+    std::atomic<int> publishedNumEvents;
+
+    void addLatencyMeasurement(double latencySeconds);
+    void publishLatencyStats();
+
+    bool openInputSlot(InputSlot& slot, const juce::Array<juce::MidiDeviceInfo>& devices);
+    bool openOutputSlot(OutputSlot& slot, const juce::Array<juce::MidiDeviceInfo>& devices);
+    void closeInputSlot(InputSlot& slot);
+    void closeOutputSlot(OutputSlot& slot);
+    void startDeviceWatcher();
+    InputSlot* findInputSlot(const juce::String& deviceName);
+    OutputSlot* findOutputSlot(const juce::String& deviceName);
+    void queueOutgoing(const juce::MidiMessage& message);
+    void sendPendingMessages();
+    static bool outputAccepts(const OutputSlot& slot, const juce::MidiMessage& message);
+
     void processMIDIMessage(const juce::MidiMessage& message);
     float normalizeValue(int value, float minVal, float maxVal);
 
+    JUCE_DECLARE_WEAK_REFERENCEABLE(MIDIController)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MIDIController)
 }; 
\ No newline at end of file
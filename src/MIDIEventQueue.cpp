@@ -0,0 +1,45 @@
+#include "MIDIEventQueue.h"
+
+MIDIEventQueue::MIDIEventQueue()
+    : fifo(capacity), numDropped(0)
+{
+}
+
+MIDIEventQueue::~MIDIEventQueue()
+{
+}
+
+bool MIDIEventQueue::push(const juce::MidiMessage& message)
+{
+    const int size = message.getRawDataSize();
+    if (size <= 0 || size > 3)
+    {
+        ++numDropped;
+        return false;
+    }
+
+    TimestampedMIDIEvent event;
+    event.timestamp = message.getTimeStamp();
+    event.size = size;
+    std::memcpy(event.data, message.getRawData(), (size_t)size);
+    return push(event);
+}
+
+bool MIDIEventQueue::push(const TimestampedMIDIEvent& event)
+{
+    const juce::SpinLock::ScopedLockType lock(writeLock);
+    const auto scope = fifo.write(1);
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+    {
+        ++numDropped;
+        return false;
+    }
+
+    events[(size_t)(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = event;
+    return true;
+}
+
+void MIDIEventQueue::clear()
+{
+    fifo.reset();
+}
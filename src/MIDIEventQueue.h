@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// A short MIDI event captured on the MIDI thread, kept as plain data so it can
+// travel through the FIFO without touching the heap.
+struct TimestampedMIDIEvent
+{
+    double timestamp;       // Seconds, same timebase as Time::getMillisecondCounterHiRes() * 0.001
+    juce::uint8 data[3];
+    int size;
+};
+
+// Lock-free single-reader queue between the MIDI input thread(s) and the audio
+// thread, in the spirit of juce::MidiMessageCollector but without its lock.
+// Writers are serialised by a spin lock the reader never touches, so several
+// devices (or the UI and a device) may push at once.
+class MIDIEventQueue
+{
+public:
+    static constexpr int capacity = 1024;
+
+    MIDIEventQueue();
+    ~MIDIEventQueue();
+
+    // Writer side (MIDI thread). Returns false if the event was dropped
+    // because it is a sysex/meta message or the queue is full.
+    bool push(const juce::MidiMessage& message);
+    bool push(const TimestampedMIDIEvent& event);
+
+    // Reader side (audio thread). Calls callback(const TimestampedMIDIEvent&)
+    // for every queued event in arrival order and returns how many were read.
+    template <typename Callback>
+    int popAll(Callback&& callback)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            callback(events[(size_t)(scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            callback(events[(size_t)(scope.startIndex2 + i)]);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    void clear();
+    int getNumDropped() const { return numDropped.load(); }
+
+private:
+    juce::AbstractFifo fifo;
+    juce::SpinLock writeLock;
+    std::array<TimestampedMIDIEvent, capacity> events;
+    std::atomic<int> numDropped;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MIDIEventQueue)
+};
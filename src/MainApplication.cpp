@@ -1,8 +1,22 @@
 #include "MainApplication.h"
+#include "MainComponent.h"
 
 void MainApplication::initialise(const juce::String& commandLine)
 {
-    mainWindow.reset(new MainWindow(getApplicationName()));
+    // --realtime locks memory, keeps audio on a core of its own and raises
+    // its priority, before the audio device opens; --audio-core=N picks the
+    // core instead of an isolated or the last one
+    if (commandLine.contains("--realtime"))
+    {
+        RealtimeConfig::Options options;
+        if (commandLine.contains("--audio-core="))
+            options.audioCore = commandLine.fromFirstOccurrenceOf("--audio-core=", false, false).getIntValue();
+
+        realtimeConfig.applyToProcess(options);
+    }
+
+    // --no-ui-cache renders every repaint from scratch, for comparing frame times
+    mainWindow.reset(new MainWindow(getApplicationName(), !commandLine.contains("--no-ui-cache"), realtimeConfig));
 }
 
 void MainApplication::shutdown()
@@ -20,15 +34,28 @@ void MainApplication::anotherInstanceStarted(const juce::String& commandLine)
     // Handle another instance being launched
 }
 
-MainApplication::MainWindow::MainWindow(juce::String name)
+MainApplication::MainWindow::MainWindow(juce::String name, bool cachedRendering, RealtimeConfig& realtimeConfig)
     : DocumentWindow(name,
                     juce::Desktop::getInstance().getDefaultLookAndFeel()
                         .findColour(juce::ResizableWindow::backgroundColourId),
                     DocumentWindow::allButtons)
 {
     setUsingNativeTitleBar(true);
+
+    auto* content = new MainComponent();
+    content->setCachedRendering(cachedRendering);
+    if (realtimeConfig.isEnabled())
+        content->setRealtimeConfig(realtimeConfig);
+    setContentOwned(content, true);
     setResizable(true, true);
-    centreWithSize(800, 600);
+
+    // On the Pi's touchscreen the window is the whole screen
+    const auto* display = juce::Desktop::getInstance().getDisplays().getPrimaryDisplay();
+    if (display != nullptr && display->userArea.getWidth() <= 1024 && display->userArea.getHeight() <= 600)
+        setFullScreen(true);
+    else
+        centreWithSize(getWidth(), getHeight());
+
     setVisible(true);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "RealtimeConfig.h"
 
 class MainApplication : public juce::JUCEApplication
 {
@@ -20,7 +21,7 @@ public:
     class MainWindow : public juce::DocumentWindow
     {
     public:
-        MainWindow(juce::String name);
+        MainWindow(juce::String name, bool cachedRendering, RealtimeConfig& realtimeConfig);
         void closeButtonPressed() override;
 
     private:
@@ -28,6 +29,7 @@ public:
     };
 
 private:
+    RealtimeConfig realtimeConfig;      // Outlives the window and its audio
     std::unique_ptr<MainWindow> mainWindow;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainApplication)
 }; 
\ No newline at end of file
@@ -1,16 +1,20 @@
 #include "MainComponent.h"
 
 MainComponent::MainComponent()
-    : effectsPanel(audioEngine),
+    : deviceHost(audioEngine),
+      effectsPanel(audioEngine),
       liveLoopPanel(audioEngine.getLiveLooper()),
       sequencerPanel(audioEngine.getSequencer()),
-      sampleSlicerPanel(audioEngine.getSampleSlicer())
+      sampleSlicerPanel(audioEngine.getSampleSlicer()),
+      clipLauncherPanel(audioEngine),
+      dspLoadOverlay(audioEngine.getProfiler(), audioEngine.getXrunMonitor())
 {
     // Initialize buttons
     loadButton.setButtonText("Load Audio");
     playButton.setButtonText("Play");
     stopButton.setButtonText("Stop");
     loopButton.setButtonText("Loop");
+    dspLoadButton.setButtonText("DSP Load");
     
     // Initialize volume slider
     volumeSlider.setRange(0.0, 1.0, 0.01);
@@ -29,15 +33,38 @@ MainComponent::MainComponent()
     addAndMakeVisible(liveLoopPanel);
     addAndMakeVisible(sequencerPanel);
     addAndMakeVisible(sampleSlicerPanel);
+    addAndMakeVisible(clipLauncherPanel);
+    addAndMakeVisible(dspLoadButton);
+    addChildComponent(dspLoadOverlay); // Shown on top of the panels when toggled
+    dspLoadOverlay.setFrameMonitor(&frameMonitor);
+    dspLoadOverlay.setAudioArena(&audioEngine.getAudioArena());
+
+    const char* tabNames[] = { "Effects", "Looper", "Sequencer", "Slicer", "Session" };
+    for (size_t i = 0; i < panelTabs.size(); ++i)
+    {
+        panelTabs[i].setButtonText(tabNames[i]);
+        panelTabs[i].setRadioGroupId(1);
+        panelTabs[i].setClickingTogglesState(true);
+        panelTabs[i].onClick = [this, i] { showPanel((int)i); };
+        addChildComponent(panelTabs[i]);
+    }
+    panelTabs[0].setToggleState(true, juce::dontSendNotification);
+
+    // Panels paint their whole area, so nothing behind them needs drawing
+    for (auto* panel : getPanels())
+        panel->setOpaque(true);
+
+    setCachedRendering(true);
     
     // Add listeners
     loadButton.addListener(this);
     playButton.addListener(this);
     stopButton.addListener(this);
     loopButton.addListener(this);
+    dspLoadButton.addListener(this);
     volumeSlider.addListener(this);
     
-    setSize(1400, 1200); // Increased size to accommodate all panels
+    setSize(800, 480); // The Pi touchscreen; larger windows show all panels at once
 }
 
 MainComponent::~MainComponent()
@@ -47,6 +74,7 @@ MainComponent::~MainComponent()
     playButton.removeListener(this);
     stopButton.removeListener(this);
     loopButton.removeListener(this);
+    dspLoadButton.removeListener(this);
     volumeSlider.removeListener(this);
 }
 
@@ -58,32 +86,77 @@ void MainComponent::paint(juce::Graphics& g)
 void MainComponent::resized()
 {
     auto area = getLocalBounds();
-    auto buttonHeight = 40;
-    auto margin = 10;
-    
-    // Transport controls at the top
-    auto transportArea = area.removeFromTop(buttonHeight * 2).reduced(margin);
-    loadButton.setBounds(transportArea.removeFromTop(buttonHeight).reduced(5));
-    playButton.setBounds(transportArea.removeFromLeft(transportArea.getWidth() / 4).reduced(5));
-    stopButton.setBounds(transportArea.removeFromLeft(transportArea.getWidth() / 3).reduced(5));
-    loopButton.setBounds(transportArea.removeFromLeft(transportArea.getWidth() / 2).reduced(5));
-    
-    auto volumeArea = transportArea.removeFromTop(buttonHeight).reduced(5);
-    volumeLabel.setBounds(volumeArea.removeFromLeft(100));
-    volumeSlider.setBounds(volumeArea);
-    
-    // Split remaining area into panels (2x2 grid)
-    auto panelHeight = area.getHeight() / 2;
-    auto panelWidth = area.getWidth() / 2;
-    
-    // Top row: Effects and Live Loop
-    auto topRow = area.removeFromTop(panelHeight);
-    effectsPanel.setBounds(topRow.removeFromLeft(panelWidth).reduced(margin));
-    liveLoopPanel.setBounds(topRow.reduced(margin));
+    compactLayout = getWidth() < 1000 || getHeight() < 700;
+
+    // Touch targets stay at least a fingertip high on the small screen
+    auto buttonHeight = compactLayout ? 48 : 40;
+    auto margin = compactLayout ? 4 : 10;
     
-    // Bottom row: Sequencer and Sample Slicer
-    sequencerPanel.setBounds(area.removeFromLeft(panelWidth).reduced(margin));
-    sampleSlicerPanel.setBounds(area.reduced(margin));
+    if (compactLayout)
+    {
+        // One row of transport controls, tabs along the bottom
+        auto transportArea = area.removeFromTop(buttonHeight + margin * 2).reduced(margin);
+        loadButton.setBounds(transportArea.removeFromLeft(110).reduced(2));
+        playButton.setBounds(transportArea.removeFromLeft(90).reduced(2));
+        stopButton.setBounds(transportArea.removeFromLeft(90).reduced(2));
+        loopButton.setBounds(transportArea.removeFromLeft(80).reduced(2));
+        dspLoadButton.setBounds(transportArea.removeFromRight(110).reduced(2));
+        volumeLabel.setBounds(transportArea.removeFromLeft(70));
+        volumeSlider.setBounds(transportArea.reduced(2));
+
+        auto tabArea = area.removeFromBottom(buttonHeight + margin * 2).reduced(margin);
+        const int tabWidth = tabArea.getWidth() / (int)panelTabs.size();
+        for (auto& tab : panelTabs)
+        {
+            tab.setVisible(true);
+            tab.setBounds(tabArea.removeFromLeft(tabWidth).reduced(2));
+        }
+
+        for (auto* panel : getPanels())
+            panel->setBounds(area.reduced(margin));
+    }
+    else
+    {
+        // Transport controls at the top
+        auto transportArea = area.removeFromTop(buttonHeight * 2).reduced(margin);
+        auto loadArea = transportArea.removeFromTop(buttonHeight);
+        dspLoadButton.setBounds(loadArea.removeFromRight(120).reduced(5));
+        loadButton.setBounds(loadArea.reduced(5));
+        playButton.setBounds(transportArea.removeFromLeft(transportArea.getWidth() / 4).reduced(5));
+        stopButton.setBounds(transportArea.removeFromLeft(transportArea.getWidth() / 3).reduced(5));
+        loopButton.setBounds(transportArea.removeFromLeft(transportArea.getWidth() / 2).reduced(5));
+        
+        auto volumeArea = transportArea.removeFromTop(buttonHeight).reduced(5);
+        volumeLabel.setBounds(volumeArea.removeFromLeft(100));
+        volumeSlider.setBounds(volumeArea);
+
+        for (auto& tab : panelTabs)
+            tab.setVisible(false);
+
+        // Session grid along the bottom
+        clipLauncherPanel.setBounds(area.removeFromBottom(area.getHeight() / 3).reduced(margin));
+
+        // Split remaining area into panels (2x2 grid)
+        auto panelHeight = area.getHeight() / 2;
+        auto panelWidth = area.getWidth() / 2;
+        
+        // Top row: Effects and Live Loop
+        auto topRow = area.removeFromTop(panelHeight);
+        effectsPanel.setBounds(topRow.removeFromLeft(panelWidth).reduced(margin));
+        liveLoopPanel.setBounds(topRow.reduced(margin));
+        
+        // Bottom row: Sequencer and Sample Slicer
+        sequencerPanel.setBounds(area.removeFromLeft(panelWidth).reduced(margin));
+        sampleSlicerPanel.setBounds(area.reduced(margin));
+    }
+
+    showPanel(currentPanel);
+
+    // Load overlay floats over the top right
+    const int overlayWidth = juce::jmin(380, getWidth() - margin * 2);
+    const int overlayTop = (compactLayout ? buttonHeight + margin * 2 : buttonHeight * 2) + margin;
+    dspLoadOverlay.setBounds(getWidth() - overlayWidth - margin, overlayTop, overlayWidth,
+                             juce::jmin(dspLoadOverlay.getIdealHeight(), getHeight() - overlayTop - margin));
 }
 
 void MainComponent::buttonClicked(juce::Button* button)
@@ -106,6 +179,11 @@ void MainComponent::buttonClicked(juce::Button* button)
     {
         audioEngine.setLooping(loopButton.getToggleState());
     }
+    else if (button == &dspLoadButton)
+    {
+        dspLoadOverlay.setVisible(dspLoadButton.getToggleState());
+        dspLoadOverlay.toFront(false);
+    }
 }
 
 void MainComponent::sliderValueChanged(juce::Slider* slider)
@@ -132,6 +210,44 @@ void MainComponent::loadAudioFile()
     }
 }
 
+void MainComponent::setCachedRendering(bool shouldCache)
+{
+    for (auto* panel : getPanels())
+        panel->setBufferedToImage(shouldCache);
+}
+
+void MainComponent::setRealtimeConfig(RealtimeConfig& config)
+{
+    config.lockArena(audioEngine.getAudioArena());
+    deviceHost.setRealtimeConfig(&config);
+}
+
+std::array<juce::Component*, 5> MainComponent::getPanels()
+{
+    return { &effectsPanel, &liveLoopPanel, &sequencerPanel, &sampleSlicerPanel, &clipLauncherPanel };
+}
+
+void MainComponent::showPanel(int index)
+{
+    currentPanel = index;
+
+    const auto panels = getPanels();
+    for (size_t i = 0; i < panels.size(); ++i)
+        panels[i]->setVisible(!compactLayout || (int)i == currentPanel);
+}
+
+void MainComponent::showEngineState()
+{
+    EngineSnapshot snapshot;
+    if (!audioEngine.readUISnapshot(snapshot))
+        return;
+
+    liveLoopPanel.showSnapshot(snapshot);
+    sequencerPanel.showSnapshot(snapshot);
+    sampleSlicerPanel.showSnapshot(snapshot);
+    clipLauncherPanel.showSnapshot(snapshot);
+}
+
 void MainComponent::updatePlayButtonState()
 {
     playButton.setEnabled(true);
@@ -2,10 +2,14 @@
 
 #include <JuceHeader.h>
 #include "AudioEngine.h"
+#include "AudioDeviceHost.h"
 #include "EffectsPanel.h"
 #include "LiveLoopPanel.h"
 #include "SequencerPanel.h"
 #include "SampleSlicerPanel.h"
+#include "ClipLauncherPanel.h"
+#include "DSPLoadOverlay.h"
+#include "FrameBudgetMonitor.h"
 
 class MainComponent : public juce::Component,
                      public juce::Button::Listener,
@@ -20,22 +24,51 @@ public:
     void buttonClicked(juce::Button* button) override;
     void sliderValueChanged(juce::Slider* slider) override;
 
+    // Renders each panel into its own image, so a repaint re-renders only the
+    // invalidated part and everything else, labels and backgrounds included,
+    // is blitted. Pure software rendering; on by default.
+    void setCachedRendering(bool shouldCache);
+
+    // Locks the audio arena unless all memory is locked already, and has the
+    // audio thread raise its priority and pin itself to its core
+    void setRealtimeConfig(RealtimeConfig& config);
+
 private:
     AudioEngine audioEngine;
+    AudioDeviceHost deviceHost;
     EffectsPanel effectsPanel;
     LiveLoopPanel liveLoopPanel;
     SequencerPanel sequencerPanel;
     SampleSlicerPanel sampleSlicerPanel;
+    ClipLauncherPanel clipLauncherPanel;
+    DSPLoadOverlay dspLoadOverlay;
     
     juce::TextButton loadButton;
     juce::TextButton playButton;
     juce::TextButton stopButton;
     juce::ToggleButton loopButton;
+    juce::ToggleButton dspLoadButton;
     juce::Slider volumeSlider;
     juce::Label volumeLabel;
+
+    // Below about 1000x700, e.g. on the 800x480 touchscreen, one panel at a
+    // time fills the screen and a row of tabs picks it
+    std::array<juce::TextButton, 5> panelTabs;
+    bool compactLayout = false;
+    int currentPanel = 0;
+
+    FrameBudgetMonitor frameMonitor;
     
+    // Hands the latest engine snapshot to the panels once per display
+    // refresh, or less often while frames run over budget; declared last so
+    // it stops before the panels go
+    juce::VBlankAttachment vBlankAttachment { this, [this] { if (frameMonitor.beginFrame()) showEngineState(); } };
+
     void loadAudioFile();
     void updatePlayButtonState();
+    void showEngineState();
+    void showPanel(int index);
+    std::array<juce::Component*, 5> getPanels();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 }; 
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "MasterDynamics.h"
+
+namespace
+{
+    // The interpolated points sit between the middle two history samples
+    constexpr int interpolatorCentre = 3;
+
+    float smoothingCoefficient(double milliseconds, double sampleRate)
+    {
+        return (float)std::exp(-1.0 / (juce::jmax(0.01, milliseconds) * 0.001 * sampleRate));
+    }
+
+    int getMaxLookaheadSamples(double sampleRate)
+    {
+        return (int)std::ceil(MasterDynamics::maxLookaheadMs * 0.001 * sampleRate);
+    }
+}
+
+MasterDynamics::MasterDynamics()
+    : sampleRate(44100.0), compressorEnvelope(0.0f), compressorThreshold(-12.0f), compressorSlope(0.75f),
+      compressorKnee(6.0f), kneeStartLevel(0.0f), makeupGain(1.0f), attackCoefficient(0.0f), releaseCoefficient(0.0f),
+      isCompressorEnabled(false), delayMask(0), delayPosition(0), lookaheadSamples(0),
+      dequeMask(0), dequeFront(0), dequeBack(0), sampleIndex(0), rampSum(0.0), rampPosition(0),
+      limiterGain(1.0f), minimumLimiterGain(1.0f), limiterReleaseCoefficient(0.0f), ceiling(1.0f),
+      isLimiterEnabled(true),
+      compressorEnabled(false), thresholdDb(-12.0f), ratio(4.0f), kneeDb(6.0f), attackMs(10.0f), releaseMs(150.0f),
+      makeupDb(0.0f), limiterEnabled(true), ceilingDb(-1.0f), lookaheadMs(1.5f), limiterReleaseMs(60.0f),
+      parametersChanged(true), latencySamples(0), compressorReduction(0.0f), limiterReduction(0.0f)
+{
+    // Windowed-sinc taps for the points a quarter, half and three quarters
+    // of the way between the two centre samples, normalised for unity DC gain
+    for (int phase = 0; phase < oversampling - 1; ++phase)
+    {
+        const double fraction = (phase + 1) / (double)oversampling;
+        double sum = 0.0;
+
+        for (int tap = 0; tap < interpolatorTaps; ++tap)
+        {
+            const double distance = tap - interpolatorCentre - fraction;
+            const double x = juce::MathConstants<double>::pi * distance;
+            const double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+            const double window = 0.5 * (1.0 + std::cos(juce::MathConstants<double>::pi * distance
+                                                         / (interpolatorTaps / 2 + 1)));
+            phases[(size_t)phase][(size_t)tap] = (float)(sinc * window);
+            sum += sinc * window;
+        }
+
+        for (auto& coefficient : phases[(size_t)phase])
+            coefficient = (float)(coefficient / sum);
+    }
+
+    for (auto& channel : history)
+        channel.fill(0.0f);
+}
+
+void MasterDynamics::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+
+    const int maxLookahead = getMaxLookaheadSamples(sampleRate);
+
+    // The delay also covers the interpolator's look into the future
+    const int delaySize = juce::nextPowerOfTwo(maxLookahead + interpolatorCentre + 2);
+    delayMask = delaySize - 1;
+    for (auto& line : delayLines)
+        line.assign((size_t)delaySize, 0.0f);
+
+    const int dequeSize = juce::nextPowerOfTwo(maxLookahead + 2);
+    dequeMask = (juce::uint32)dequeSize - 1;
+    dequeIndices.assign((size_t)dequeSize, 0);
+    dequeGains.assign((size_t)dequeSize, 1.0f);
+
+    rampHistory.assign((size_t)maxLookahead + 1, 1.0f);
+
+    parametersChanged = true;
+    updateCoefficients();
+    reset();
+}
+
+void MasterDynamics::reset()
+{
+    compressorEnvelope = 0.0f;
+    resetLimiter();
+}
+
+void MasterDynamics::resetLimiter()
+{
+    for (auto& channel : history)
+        channel.fill(0.0f);
+
+    for (auto& line : delayLines)
+        std::fill(line.begin(), line.end(), 0.0f);
+
+    delayPosition = 0;
+    dequeFront = dequeBack = 0;
+    sampleIndex = 0;
+
+    std::fill(rampHistory.begin(), rampHistory.end(), 1.0f);
+    rampSum = lookaheadSamples + 1.0;
+    rampPosition = 0;
+    limiterGain = 1.0f;
+}
+
+void MasterDynamics::setParameters(const Parameters& newParameters)
+{
+    compressorEnabled = newParameters.compressorEnabled;
+    thresholdDb = juce::jlimit(-60.0f, 0.0f, newParameters.thresholdDb);
+    ratio = juce::jlimit(1.0f, 100.0f, newParameters.ratio);
+    kneeDb = juce::jlimit(0.0f, 24.0f, newParameters.kneeDb);
+    attackMs = juce::jlimit(0.1f, 500.0f, newParameters.attackMs);
+    releaseMs = juce::jlimit(1.0f, 5000.0f, newParameters.releaseMs);
+    makeupDb = juce::jlimit(0.0f, 24.0f, newParameters.makeupDb);
+    limiterEnabled = newParameters.limiterEnabled;
+    ceilingDb = juce::jlimit(-24.0f, 0.0f, newParameters.ceilingDb);
+    lookaheadMs = juce::jlimit(0.0f, maxLookaheadMs, newParameters.lookaheadMs);
+    limiterReleaseMs = juce::jlimit(1.0f, 2000.0f, newParameters.limiterReleaseMs);
+    parametersChanged = true;
+}
+
+MasterDynamics::Parameters MasterDynamics::getParameters() const
+{
+    Parameters result;
+    result.compressorEnabled = compressorEnabled.load();
+    result.thresholdDb = thresholdDb.load();
+    result.ratio = ratio.load();
+    result.kneeDb = kneeDb.load();
+    result.attackMs = attackMs.load();
+    result.releaseMs = releaseMs.load();
+    result.makeupDb = makeupDb.load();
+    result.limiterEnabled = limiterEnabled.load();
+    result.ceilingDb = ceilingDb.load();
+    result.lookaheadMs = lookaheadMs.load();
+    result.limiterReleaseMs = limiterReleaseMs.load();
+    return result;
+}
+
+int MasterDynamics::getLatencySamples() const
+{
+    return latencySamples.load();
+}
+
+void MasterDynamics::updateCoefficients()
+{
+    if (!parametersChanged.exchange(false))
+        return;
+
+    isCompressorEnabled = compressorEnabled.load();
+    compressorThreshold = thresholdDb.load();
+    compressorSlope = 1.0f - 1.0f / ratio.load();
+    compressorKnee = kneeDb.load();
+    kneeStartLevel = juce::Decibels::decibelsToGain(compressorThreshold - 0.5f * compressorKnee);
+    makeupGain = juce::Decibels::decibelsToGain(makeupDb.load());
+    attackCoefficient = smoothingCoefficient(attackMs.load(), sampleRate);
+    releaseCoefficient = smoothingCoefficient(releaseMs.load(), sampleRate);
+
+    ceiling = juce::Decibels::decibelsToGain(ceilingDb.load());
+    limiterReleaseCoefficient = smoothingCoefficient(limiterReleaseMs.load(), sampleRate);
+
+    // A new window length or switching the limiter restarts it; the delay
+    // cannot change length without a jump in the audio either way
+    const int newLookahead = juce::jmin((int)std::round(lookaheadMs.load() * 0.001 * sampleRate),
+                                        (int)rampHistory.size() - 1);
+    const bool newLimiterEnabled = limiterEnabled.load();
+
+    if (newLookahead != lookaheadSamples || newLimiterEnabled != isLimiterEnabled)
+    {
+        lookaheadSamples = juce::jmax(0, newLookahead);
+        isLimiterEnabled = newLimiterEnabled;
+        resetLimiter();
+    }
+
+    latencySamples = isLimiterEnabled ? lookaheadSamples + interpolatorCentre + 1 : 0;
+}
+
+float MasterDynamics::computeCompressorGain(float level)
+{
+    // Soft-knee gain computer in dB, then attack/release on the reduction
+    float target = 0.0f;
+
+    if (level > kneeStartLevel)
+    {
+        const float over = juce::Decibels::gainToDecibels(level) - compressorThreshold;
+
+        if (2.0f * over > compressorKnee)
+            target = compressorSlope * over;
+        else
+            target = compressorSlope * juce::square(over + 0.5f * compressorKnee) / (2.0f * compressorKnee);
+    }
+
+    const float coefficient = target > compressorEnvelope ? attackCoefficient : releaseCoefficient;
+    compressorEnvelope = target + coefficient * (compressorEnvelope - target);
+
+    if (compressorEnvelope < 1.0e-4f)
+        return makeupGain;
+
+    return makeupGain * std::pow(10.0f, -0.05f * compressorEnvelope);
+}
+
+float MasterDynamics::estimatePeak()
+{
+    float peak = 0.0f;
+
+    for (const auto& samples : history)
+    {
+        peak = juce::jmax(peak, std::abs(samples[interpolatorCentre]), std::abs(samples[interpolatorCentre + 1]));
+
+        for (const auto& coefficients : phases)
+        {
+            float interpolated = 0.0f;
+            for (int tap = 0; tap < interpolatorTaps; ++tap)
+                interpolated += coefficients[(size_t)tap] * samples[(size_t)tap];
+
+            peak = juce::jmax(peak, std::abs(interpolated));
+        }
+    }
+
+    return peak;
+}
+
+float MasterDynamics::nextLimiterGain(float requiredGain)
+{
+    const int windowLength = lookaheadSamples + 1;
+
+    // Sliding minimum: drop entries the new one makes irrelevant, then the
+    // one that has left the window
+    while (dequeBack != dequeFront && dequeGains[(dequeBack - 1) & dequeMask] >= requiredGain)
+        --dequeBack;
+
+    dequeIndices[dequeBack & dequeMask] = sampleIndex;
+    dequeGains[dequeBack & dequeMask] = requiredGain;
+    ++dequeBack;
+
+    while (dequeIndices[dequeFront & dequeMask] <= sampleIndex - windowLength)
+        ++dequeFront;
+
+    ++sampleIndex;
+
+    const float heldGain = dequeGains[dequeFront & dequeMask];
+
+    // Averaging the held minimum over the window gives a ramp that reaches
+    // it exactly when the peak that set it comes out of the delay
+    rampSum += heldGain - rampHistory[(size_t)rampPosition];
+    rampHistory[(size_t)rampPosition] = heldGain;
+    if (++rampPosition == windowLength)
+        rampPosition = 0;
+
+    const float target = juce::jmin(1.0f, (float)(rampSum / windowLength));
+
+    if (target < limiterGain)
+        limiterGain = target;
+    else
+        limiterGain = target + limiterReleaseCoefficient * (limiterGain - target);
+
+    return limiterGain;
+}
+
+void MasterDynamics::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    updateCoefficients();
+
+    auto& block = context.getOutputBlock();
+    const int numSamples = (int)block.getNumSamples();
+    const int channels = juce::jmin(numChannels, (int)block.getNumChannels());
+
+    if (channels == 0 || context.isBypassed || (!isCompressorEnabled && !isLimiterEnabled))
+        return;
+
+    float* left = block.getChannelPointer(0);
+    float* right = block.getChannelPointer((size_t)channels - 1);
+    const int delay = lookaheadSamples + interpolatorCentre + 1;
+    minimumLimiterGain = 1.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float samples[numChannels] = { left[i], right[i] };
+
+        if (isCompressorEnabled)
+        {
+            const float gain = computeCompressorGain(juce::jmax(std::abs(samples[0]), std::abs(samples[1])));
+            samples[0] *= gain;
+            samples[1] *= gain;
+        }
+
+        if (isLimiterEnabled)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& channelHistory = history[(size_t)ch];
+                std::copy(channelHistory.begin() + 1, channelHistory.end(), channelHistory.begin());
+                channelHistory.back() = samples[ch];
+
+                delayLines[(size_t)ch][(size_t)delayPosition] = samples[ch];
+            }
+
+            const float peak = estimatePeak();
+            const float gain = nextLimiterGain(peak > ceiling ? ceiling / peak : 1.0f);
+            minimumLimiterGain = juce::jmin(minimumLimiterGain, gain);
+
+            const int readPosition = (delayPosition - delay) & delayMask;
+            for (int ch = 0; ch < numChannels; ++ch)
+                samples[ch] = juce::jlimit(-ceiling, ceiling, delayLines[(size_t)ch][(size_t)readPosition] * gain);
+
+            delayPosition = (delayPosition + 1) & delayMask;
+        }
+
+        left[i] = samples[0];
+        if (channels > 1)
+            right[i] = samples[1];
+    }
+
+    compressorReduction = isCompressorEnabled ? compressorEnvelope : 0.0f;
+    limiterReduction = -juce::Decibels::gainToDecibels(minimumLimiterGain);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Last stage before the output: a stereo-linked bus compressor followed by a
+// true-peak lookahead brickwall limiter.
+//
+// The limiter estimates inter-sample peaks with a 4x polyphase interpolator,
+// takes the minimum required gain over the lookahead window with a monotonic
+// deque (O(1) per sample however long the window), and ramps into it with a
+// moving average the same length as the window. The ramp always reaches the
+// required gain by the time the peak leaves the delay line, so the output
+// never exceeds the ceiling. A final clip at the ceiling covers the small
+// error of the peak estimate.
+//
+// The added latency is the lookahead plus half the interpolator, reported
+// by getLatencySamples.
+class MasterDynamics
+{
+public:
+    static constexpr float maxLookaheadMs = 10.0f;
+
+    struct Parameters
+    {
+        bool compressorEnabled = false;
+        float thresholdDb = -12.0f;
+        float ratio = 4.0f;
+        float kneeDb = 6.0f;
+        float attackMs = 10.0f;
+        float releaseMs = 150.0f;
+        float makeupDb = 0.0f;
+
+        bool limiterEnabled = true;
+        float ceilingDb = -1.0f;
+        float lookaheadMs = 1.5f;
+        float limiterReleaseMs = 60.0f;
+    };
+
+    MasterDynamics();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setParameters(const Parameters& newParameters);
+    Parameters getParameters() const;
+
+    // Delay added by the limiter; zero while it is off
+    int getLatencySamples() const;
+
+    // Current gain reduction in dB (positive), for metering
+    float getCompressorReduction() const { return compressorReduction.load(); }
+    float getLimiterReduction() const { return limiterReduction.load(); }
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    static constexpr int numChannels = 2;
+    static constexpr int interpolatorTaps = 8;
+    static constexpr int oversampling = 4;
+
+    double sampleRate;
+
+    // Compressor
+    float compressorEnvelope;
+    float compressorThreshold;
+    float compressorSlope;
+    float compressorKnee;
+    float kneeStartLevel;
+    float makeupGain;
+    float attackCoefficient;
+    float releaseCoefficient;
+    bool isCompressorEnabled;
+
+    // Limiter: the last few input samples for the interpolator, oldest
+    // first, then the lookahead delay
+    std::array<std::array<float, interpolatorTaps>, numChannels> history;
+    std::array<std::array<float, interpolatorTaps>, oversampling - 1> phases;
+
+    std::array<std::vector<float>, numChannels> delayLines;
+    int delayMask;
+    int delayPosition;
+    int lookaheadSamples;
+
+    // Sliding minimum of the required gain, as a ring of (index, gain)
+    std::vector<juce::int64> dequeIndices;
+    std::vector<float> dequeGains;
+    juce::uint32 dequeMask;
+    juce::uint32 dequeFront;
+    juce::uint32 dequeBack;
+    juce::int64 sampleIndex;
+
+    // Moving average that turns the held minimum into a ramp
+    std::vector<float> rampHistory;
+    double rampSum;
+    int rampPosition;
+
+    float limiterGain;
+    float minimumLimiterGain;
+    float limiterReleaseCoefficient;
+    float ceiling;
+    bool isLimiterEnabled;
+
+    // Shared with the control thread
+    std::atomic<bool> compressorEnabled;
+    std::atomic<float> thresholdDb;
+    std::atomic<float> ratio;
+    std::atomic<float> kneeDb;
+    std::atomic<float> attackMs;
+    std::atomic<float> releaseMs;
+    std::atomic<float> makeupDb;
+    std::atomic<bool> limiterEnabled;
+    std::atomic<float> ceilingDb;
+    std::atomic<float> lookaheadMs;
+    std::atomic<float> limiterReleaseMs;
+    std::atomic<bool> parametersChanged;
+
+    std::atomic<int> latencySamples;
+    std::atomic<float> compressorReduction;
+    std::atomic<float> limiterReduction;
+
+    void updateCoefficients();
+    void resetLimiter();
+
+    float computeCompressorGain(float level);
+    float estimatePeak();
+    float nextLimiterGain(float requiredGain);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterDynamics)
+};
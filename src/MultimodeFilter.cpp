@@ -0,0 +1,190 @@
+#include "MultimodeFilter.h"
+#include <cstring>
+
+namespace
+{
+    // tan(pi * x) sampled over 0 <= x < 0.5, linearly interpolated
+    constexpr int tanTableSize = 4096;
+    constexpr float maxNormalisedFrequency = 0.49f;
+
+    const std::array<float, tanTableSize + 1>& getTanTable()
+    {
+        static const auto table = []
+        {
+            std::array<float, tanTableSize + 1> values {};
+            for (int i = 0; i <= tanTableSize; ++i)
+            {
+                const double x = juce::jmin((double)maxNormalisedFrequency, 0.5 * i / tanTableSize);
+                values[(size_t)i] = (float)std::tan(juce::MathConstants<double>::pi * x);
+            }
+            return values;
+        }();
+
+        return table;
+    }
+}
+
+MultimodeFilter::MultimodeFilter()
+    : sampleRate(44100.0), mode(Mode::lowpass), slope(Slope::db12), cutoff(1000.0f), resonance(0.707f), inverseQ(1.0f / 0.707f),
+      lfoPhase(0.0f), lfoIncrement(0.0f), lfoDepth(0.0f), coefficientsDirty(true)
+{
+}
+
+void MultimodeFilter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    getTanTable(); // Build it here rather than on the audio thread
+    coefficientsDirty = true;
+    reset();
+}
+
+void MultimodeFilter::reset()
+{
+    for (auto& channel : state)
+        channel = {};
+
+    lfoPhase = 0.0f;
+}
+
+void MultimodeFilter::setCutoff(float frequency)
+{
+    if (frequency != cutoff)
+    {
+        cutoff = frequency;
+        coefficientsDirty = true;
+    }
+}
+
+void MultimodeFilter::setResonance(float q)
+{
+    q = juce::jmax(0.1f, q);
+    if (q != resonance)
+    {
+        resonance = q;
+        inverseQ = 1.0f / q;
+        coefficientsDirty = true;
+    }
+}
+
+void MultimodeFilter::setLFO(float rateHz, float depthOctaves)
+{
+    lfoIncrement = (float)(rateHz / sampleRate);
+    lfoDepth = depthOctaves;
+}
+
+float MultimodeFilter::fastTan(float normalisedFrequency)
+{
+    const auto& table = getTanTable();
+    const float position = juce::jlimit(0.0f, maxNormalisedFrequency, normalisedFrequency) * (2.0f * tanTableSize);
+    const int index = juce::jmin((int)position, tanTableSize - 1);
+    const float fraction = position - (float)index;
+    return table[(size_t)index] + (table[(size_t)index + 1] - table[(size_t)index]) * fraction;
+}
+
+float MultimodeFilter::fastExp2(float x)
+{
+    // Split into integer and fraction. The fraction goes through the Taylor
+    // series of 2^f to the fifth power, within 1e-4 of exact over [0, 1);
+    // the integer is written straight into the exponent bits of a float,
+    // which the clamp keeps in the normal range.
+    x = juce::jlimit(-30.0f, 30.0f, x);
+    const float whole = std::floor(x);
+    const float f = x - whole;
+    const float p = 1.0f + f * (0.6931472f + f * (0.2402265f + f * (0.0555041f + f * (0.0096181f + f * 0.0013333f))));
+
+    const auto exponentBits = (juce::uint32)((int)whole + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &exponentBits, sizeof(scale));
+    return p * scale;
+}
+
+MultimodeFilter::Coefficients MultimodeFilter::makeCoefficients(float frequency) const
+{
+    Coefficients c;
+    const float g = fastTan(frequency / (float)sampleRate);
+    c.k = inverseQ;
+    c.a1 = 1.0f / (1.0f + g * (g + c.k));
+    c.a2 = g * c.a1;
+    c.a3 = g * c.a2;
+    return c;
+}
+
+float MultimodeFilter::processStage(StageState& stage, const Coefficients& c, float input) const
+{
+    const float v3 = input - stage.ic2;
+    const float v1 = c.a1 * stage.ic1 + c.a2 * v3;
+    const float v2 = stage.ic2 + c.a2 * stage.ic1 + c.a3 * v3;
+    stage.ic1 = 2.0f * v1 - stage.ic1;
+    stage.ic2 = 2.0f * v2 - stage.ic2;
+
+    switch (mode)
+    {
+        case Mode::lowpass:  return v2;
+        case Mode::highpass: return input - c.k * v1 - v2;
+        case Mode::bandpass: return v1;
+        case Mode::notch:    return input - c.k * v1;
+    }
+
+    return v2;
+}
+
+void MultimodeFilter::process(float* const* channels, int numChannels, int numSamples, const float* modulation)
+{
+    numChannels = juce::jmin(numChannels, maxChannels);
+    const int numStages = slope == Slope::db24 ? 2 : 1;
+    const bool modulated = modulation != nullptr || lfoDepth != 0.0f;
+
+    if (!modulated)
+    {
+        if (coefficientsDirty)
+        {
+            cached = makeCoefficients(cutoff);
+            coefficientsDirty = false;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* samples = channels[ch];
+            auto& stages = state[(size_t)ch];
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float y = samples[i];
+                for (int s = 0; s < numStages; ++s)
+                    y = processStage(stages[(size_t)s], cached, y);
+                samples[i] = y;
+            }
+        }
+        return;
+    }
+
+    // Per-sample cutoff: the coefficients are shared by both channels
+    const float nyquistLimit = maxNormalisedFrequency * (float)sampleRate;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float octaves = modulation != nullptr ? modulation[i] : 0.0f;
+
+        if (lfoDepth != 0.0f)
+        {
+            // Triangle LFO, cheaper than a sine and fine for sweeps
+            octaves += lfoDepth * (4.0f * std::abs(lfoPhase - 0.5f) - 1.0f);
+            lfoPhase += lfoIncrement;
+            if (lfoPhase >= 1.0f)
+                lfoPhase -= 1.0f;
+        }
+
+        const float frequency = juce::jlimit(10.0f, nyquistLimit, cutoff * fastExp2(octaves));
+        const auto c = makeCoefficients(frequency);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto& stages = state[(size_t)ch];
+            float y = channels[ch][i];
+            for (int s = 0; s < numStages; ++s)
+                y = processStage(stages[(size_t)s], c, y);
+            channels[ch][i] = y;
+        }
+    }
+
+    coefficientsDirty = true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Topology-preserving-transform (zero-delay feedback) state-variable filter
+// with lowpass, highpass, bandpass and notch outputs at 12 or 24 dB/octave.
+// Up to two channels share one set of coefficients, so stereo stays linked.
+//
+// Cutoff can move every sample: modulation is given in octaves, turned into
+// a frequency with a polynomial exp2 and into the filter coefficient with a
+// table lookup instead of std::tan. Without modulation the coefficients are
+// cached and only recomputed when the cutoff or resonance changes.
+//
+// Not thread-safe; owners hand parameters over to the audio thread.
+class MultimodeFilter
+{
+public:
+    enum class Mode
+    {
+        lowpass,
+        highpass,
+        bandpass,
+        notch
+    };
+
+    enum class Slope
+    {
+        db12,
+        db24
+    };
+
+    static constexpr int maxChannels = 2;
+
+    MultimodeFilter();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    void setMode(Mode newMode) { mode = newMode; }
+    void setSlope(Slope newSlope) { slope = newSlope; }
+    void setCutoff(float frequency);
+    void setResonance(float q);
+
+    Mode getMode() const { return mode; }
+    Slope getSlope() const { return slope; }
+    float getCutoff() const { return cutoff; }
+    float getResonance() const { return resonance; }
+
+    // Built-in LFO on the cutoff, depth in octaves
+    void setLFO(float rateHz, float depthOctaves);
+
+    // Filters in place. modulation, if given, holds one cutoff offset in
+    // octaves per sample, e.g. from an envelope.
+    void process(float* const* channels, int numChannels, int numSamples, const float* modulation = nullptr);
+
+    // tan(pi * normalisedFrequency) for 0 <= normalisedFrequency < 0.5
+    static float fastTan(float normalisedFrequency);
+
+    // 2^x, accurate to about 1e-4 relative
+    static float fastExp2(float x);
+
+private:
+    struct Coefficients
+    {
+        float k = 1.0f;
+        float a1 = 0.0f;
+        float a2 = 0.0f;
+        float a3 = 0.0f;
+    };
+
+    struct StageState
+    {
+        float ic1 = 0.0f;
+        float ic2 = 0.0f;
+    };
+
+    double sampleRate;
+    Mode mode;
+    Slope slope;
+    float cutoff;
+    float resonance;
+    float inverseQ;
+
+    float lfoPhase;
+    float lfoIncrement;
+    float lfoDepth;
+
+    Coefficients cached;
+    bool coefficientsDirty;
+
+    std::array<std::array<StageState, 2>, maxChannels> state;
+
+    Coefficients makeCoefficients(float frequency) const;
+    float processStage(StageState& stage, const Coefficients& c, float input) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MultimodeFilter)
+};
@@ -0,0 +1,258 @@
+#include "OfflineRenderer.h"
+
+namespace
+{
+    constexpr double defaultBeats = 16.0;
+
+    // Room for the effects' delay lines, in seconds of stereo audio at the
+    // render rate: the delays and reverbs a project can hold, with margin
+    constexpr double effectsMemorySeconds = 32.0;
+}
+
+std::vector<OfflineRenderer::Result> OfflineRenderer::renderJobs(const std::vector<Job>& jobs, const Settings& settings,
+                                                                 int numThreads, std::function<void(double)> progress)
+{
+    std::vector<Result> results(jobs.size());
+    if (jobs.empty())
+        return results;
+
+    const int threads = numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus();
+    juce::ThreadPool pool(juce::jmin(threads, (int)jobs.size()));
+
+    // Per-job progress, summed into one figure for the caller
+    std::vector<std::atomic<float>> jobProgress(jobs.size());
+    for (auto& fraction : jobProgress)
+        fraction = 0.0f;
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        pool.addJob([&, i]
+        {
+            auto reportProgress = [&](double fraction)
+            {
+                jobProgress[i] = (float)fraction;
+
+                if (progress)
+                {
+                    double total = 0.0;
+                    for (const auto& p : jobProgress)
+                        total += p.load();
+                    progress(total / (double)jobs.size());
+                }
+            };
+
+            results[i] = renderJob(jobs[i], settings, reportProgress);
+            reportProgress(1.0);
+        });
+    }
+
+    // Jobs cannot be interrupted, so wait for all of them rather than let
+    // the pool's destructor time out
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(10);
+
+    return results;
+}
+
+OfflineRenderer::Result OfflineRenderer::renderJob(const Job& job, const Settings& settings,
+                                                   const std::function<void(double)>& progress)
+{
+    Result result;
+    result.job = job;
+
+    AudioEngine engine(AudioEngine::Mode::headless);
+    auto& projects = engine.getProjectManager();
+    if (!projects.loadProject(job.projectFile))
+    {
+        result.error = "Could not load " + job.projectFile.getFullPathName();
+        return result;
+    }
+
+    ProjectData project;
+    projects.exportProjectData(project);
+
+    // A stem is its track as it reaches the master compressor and limiter.
+    // Run through them on its own it would be squashed differently from the
+    // mix, and the stems would no longer add up to it.
+    if (job.soloTrack >= 0)
+    {
+        auto dynamics = engine.getMasterDynamics().getParameters();
+        dynamics.compressorEnabled = false;
+        dynamics.limiterEnabled = false;
+        engine.getMasterDynamics().setParameters(dynamics);
+    }
+
+    // Memory is sized and the engine prepared at the render rate before
+    // any audio is handed over, so loops are converted once and land in
+    // the arena rather than being moved into it
+    reserveMemory(engine, project, settings);
+    engine.prepareToPlay(juce::jmax(1, settings.blockSize), settings.sampleRate);
+    engine.applyProjectState(project, true);
+
+    if (job.soloTrack >= 0)
+    {
+        for (int i = 0; i < AudioEngine::numTracks; ++i)
+            engine.setTrackMuted((AudioEngine::Track)i, i != job.soloTrack);
+    }
+
+    job.outputFile.deleteFile();
+    auto writer = createWriter(job.outputFile, settings.sampleRate, 2, settings.bitsPerSample);
+    if (writer == nullptr)
+    {
+        result.error = "Could not write " + job.outputFile.getFullPathName();
+        return result;
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    result.audioSeconds = render(engine, settings, *writer, progress);
+    result.renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    result.ok = result.audioSeconds >= 0.0;
+
+    if (!result.ok)
+        result.error = "Write failed for " + job.outputFile.getFullPathName();
+
+    return result;
+}
+
+double OfflineRenderer::render(AudioEngine& engine, const Settings& settings, juce::AudioFormatWriter& writer,
+                               const std::function<void(double)>& progress)
+{
+    auto write = [&writer](const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        return writer.writeFromAudioSampleBuffer(buffer, startSample, numSamples);
+    };
+
+    return renderBlocks(engine, settings, write, nullptr, progress);
+}
+
+void OfflineRenderer::reserveMemory(AudioEngine& engine, const ProjectData& project, const Settings& settings)
+{
+    // Decoded here once; applying the project reuses the pool's buffers
+    auto& pool = engine.getSamplePool();
+    auto getSeconds = [&pool](const EmbeddedAudio& audio)
+    {
+        auto buffer = audio.buffer;
+        if (buffer == nullptr && audio.key.isNotEmpty())
+            buffer = pool.getBuffer(audio.key);
+
+        const double sampleRate = audio.sampleRate > 0.0 ? audio.sampleRate : pool.getSampleRate(audio.key);
+        return buffer != nullptr && sampleRate > 0.0 ? buffer->getNumSamples() / sampleRate : 0.0;
+    };
+
+    // Nothing is recorded offline, so the looper only needs its loops. A
+    // slicer sample only referenced by file is not sized and spills to the
+    // heap instead.
+    double loopSeconds = 0.0;
+    for (const auto& track : project.looper)
+        loopSeconds += getSeconds(track.audio);
+
+    auto& looper = engine.getLiveLooper();
+    looper.setMemoryBudget(loopSeconds);
+
+    const double stereoSeconds = looper.getMemoryBudget() + getSeconds(project.slicer.sample) + effectsMemorySeconds;
+    engine.getAudioArena().reserve((size_t)std::ceil(stereoSeconds * settings.sampleRate) * 2 * sizeof(float));
+}
+
+double OfflineRenderer::render(AudioEngine& engine, const Settings& settings, juce::AudioBuffer<float>& destination,
+                               const BlockCallback& beforeBlock)
+{
+    destination.setSize(2, (int)getLengthInSamples(engine, settings));
+    int position = 0;
+
+    auto write = [&destination, &position](const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+            destination.copyFrom(ch, position, buffer, ch, startSample, numSamples);
+
+        position += numSamples;
+        return true;
+    };
+
+    return renderBlocks(engine, settings, write, beforeBlock, nullptr);
+}
+
+juce::int64 OfflineRenderer::getLengthInSamples(AudioEngine& engine, const Settings& settings)
+{
+    const double length = settings.lengthSeconds > 0.0 ? settings.lengthSeconds
+                                                       : defaultBeats * 60.0 / juce::jmax(1.0, engine.getSequencer().getTempo());
+    return (juce::int64)std::ceil((length + juce::jmax(0.0, settings.tailSeconds)) * settings.sampleRate);
+}
+
+double OfflineRenderer::renderBlocks(AudioEngine& engine, const Settings& settings, const Writer& write,
+                                     const BlockCallback& beforeBlock, const std::function<void(double)>& progress)
+{
+    const int blockSize = juce::jmax(1, settings.blockSize);
+
+    const auto totalSamples = getLengthInSamples(engine, settings);
+
+    // The limiter's lookahead delays everything; drop it so the file starts
+    // on the first beat
+    auto samplesToSkip = (juce::int64)engine.getMasterDynamics().getLatencySamples();
+
+    engine.getSequencer().start();
+    if (engine.getLiveLooper().hasLoop())
+        engine.getLiveLooper().startPlayback();
+    engine.startPlayback();
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::int64 written = 0;
+    juce::int64 engineTime = 0;
+    bool ok = true;
+
+    while (written < totalSamples)
+    {
+        buffer.clear();
+
+        if (beforeBlock)
+            beforeBlock(engineTime, buffer);
+
+        engine.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, blockSize));
+        engineTime += blockSize;
+
+        const int skip = (int)juce::jmin(samplesToSkip, (juce::int64)blockSize);
+        samplesToSkip -= skip;
+
+        const int numToWrite = (int)juce::jmin((juce::int64)(blockSize - skip), totalSamples - written);
+        if (numToWrite > 0 && !write(buffer, skip, numToWrite))
+        {
+            ok = false;
+            break;
+        }
+
+        written += numToWrite;
+
+        if (progress)
+            progress((double)written / (double)totalSamples);
+    }
+
+    engine.stopPlayback();
+    engine.getLiveLooper().stopPlayback();
+    engine.getSequencer().stop();
+    engine.releaseResources();
+
+    return ok ? (double)written / settings.sampleRate : -1.0;
+}
+
+std::unique_ptr<juce::AudioFormatWriter> OfflineRenderer::createWriter(const juce::File& file, double sampleRate,
+                                                                       int numChannels, int bitsPerSample)
+{
+    std::unique_ptr<juce::AudioFormat> format;
+    if (file.hasFileExtension("flac"))
+        format = std::make_unique<juce::FlacAudioFormat>();
+    else if (file.hasFileExtension("wav"))
+        format = std::make_unique<juce::WavAudioFormat>();
+    else
+        return nullptr;
+
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (!stream->openedOk())
+        return nullptr;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate,
+                                                                            (unsigned int)numChannels,
+                                                                            bitsPerSample, {}, 0));
+    if (writer != nullptr)
+        stream.release(); // Now owned by the writer
+
+    return writer;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioEngine.h"
+
+// Renders projects to audio files without a sound card, as fast as the CPU
+// allows. Each job loads its project into its own headless engine, so
+// several jobs, e.g. the mix and one stem per track, run side by side, one
+// per core; a single job renders on one thread. Each engine reserves only
+// the memory its project needs and never opens a MIDI device.
+//
+// Stems skip the master compressor and limiter, so they add up to the mix
+// as it enters them.
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        int bitsPerSample = 24;
+        double lengthSeconds = 0.0;     // 0: four bars at the project tempo
+        double tailSeconds = 2.0;       // Rendered after the end so effects can ring out
+    };
+
+    struct Job
+    {
+        juce::File projectFile;
+        juce::File outputFile;          // .wav or .flac
+        int soloTrack = -1;             // An AudioEngine::Track for a stem, or -1 for the full mix
+    };
+
+    struct Result
+    {
+        Job job;
+        bool ok = false;
+        juce::String error;
+        double renderSeconds = 0.0;
+        double audioSeconds = 0.0;
+    };
+
+    // Runs every job, at most numThreads at a time (0: one per core).
+    // Progress is reported from the worker threads as a fraction of all jobs.
+    static std::vector<Result> renderJobs(const std::vector<Job>& jobs, const Settings& settings, int numThreads = 0,
+                                          std::function<void(double)> progress = nullptr);
+
+    // Called before each block with the engine time of its first sample and
+    // the block's buffer, silent, which the engine takes as its input, so
+    // scripted scenarios can trigger slices, change parameters or play into
+    // the looper on cue
+    using BlockCallback = std::function<void(juce::int64, juce::AudioBuffer<float>&)>;
+
+    // Renders an engine that is already prepared at the settings' sample
+    // rate and block size, and set up, starting its transport. Returns the
+    // number of seconds written, or a negative value on failure.
+    static double render(AudioEngine& engine, const Settings& settings, juce::AudioFormatWriter& writer,
+                         const std::function<void(double)>& progress = nullptr);
+
+    // The same, into a stereo buffer sized to fit
+    static double render(AudioEngine& engine, const Settings& settings, juce::AudioBuffer<float>& destination,
+                         const BlockCallback& beforeBlock = nullptr);
+
+    // A writer for the format named by the file extension
+    static std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, double sampleRate,
+                                                                 int numChannels, int bitsPerSample);
+
+private:
+    using Writer = std::function<bool(const juce::AudioBuffer<float>&, int startSample, int numSamples)>;
+
+    static Result renderJob(const Job& job, const Settings& settings, const std::function<void(double)>& progress);
+    static void reserveMemory(AudioEngine& engine, const ProjectData& project, const Settings& settings);
+    static juce::int64 getLengthInSamples(AudioEngine& engine, const Settings& settings);
+    static double renderBlocks(AudioEngine& engine, const Settings& settings, const Writer& write,
+                               const BlockCallback& beforeBlock, const std::function<void(double)>& progress);
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Audio stored inside the project bundle. The buffer is immutable and shared,
+// so copying ProjectData never copies samples. After loading, buffer is empty
+// and key names the still-compressed entry in the SamplePool.
+struct EmbeddedAudio
+{
+    juce::String key;
+    std::shared_ptr<const juce::AudioBuffer<float>> buffer;
+    double sampleRate;
+
+    EmbeddedAudio() : sampleRate(0.0) {}
+    bool isEmpty() const { return buffer == nullptr && key.isEmpty(); }
+};
+
+struct ProjectData
+{
+    juce::String projectName;
+    juce::String projectPath;
+    double tempo;
+    double masterGain;
+    
+    // Audio file references
+    juce::StringArray audioFiles;
+    
+    // Effects settings
+    struct EffectsSettings
+    {
+        bool reverbEnabled;
+        float reverbRoomSize;
+        float reverbDamping;
+        float reverbWetLevel;
+        float reverbDryLevel;
+        
+        bool delayEnabled;
+        float delayTime;
+        float delayFeedback;
+        float delayMix;
+        
+        bool filterEnabled;
+        float filterCutoff;
+        float filterResonance;
+        
+        bool distortionEnabled;
+        float distortionDrive;
+        float distortionMix;
+    } effects;
+    
+    // Sequencer data
+    struct SequencerData
+    {
+        int numSteps;
+        double tempo;
+        std::vector<bool> stepStates;
+        std::vector<float> stepVelocities;
+    } sequencer;
+    
+    // Live looper data, one entry per track
+    struct LooperData
+    {
+        double loopLength;
+        float loopGain;
+        double loopStart;
+        double loopEnd;
+        bool hasLoop;
+        double lengthFactor;        // For the track's next recording
+        bool muted;
+        bool reversed;
+        EmbeddedAudio audio;
+
+        LooperData() : loopLength(0.0), loopGain(1.0f), loopStart(0.0), loopEnd(0.0), hasLoop(false),
+                       lengthFactor(1.0), muted(false), reversed(false) {}
+    };
+
+    std::vector<LooperData> looper;
+    double looperMasterLength;      // Seconds; 0 without loops
+    
+    // Sample slicer data
+    struct SlicerData
+    {
+        juce::String sampleFile;
+        std::vector<juce::String> sliceNames;
+        std::vector<double> sliceStartTimes;
+        std::vector<double> sliceEndTimes;
+        EmbeddedAudio sample;
+    } slicer;
+    
+    ProjectData() : tempo(120.0), masterGain(1.0), looperMasterLength(0.0)
+    {
+        effects.reverbEnabled = false;
+        effects.reverbRoomSize = 0.5f;
+        effects.reverbDamping = 0.5f;
+        effects.reverbWetLevel = 0.33f;
+        effects.reverbDryLevel = 0.67f;
+        
+        effects.delayEnabled = false;
+        effects.delayTime = 0.5f;
+        effects.delayFeedback = 0.3f;
+        effects.delayMix = 0.3f;
+        
+        effects.filterEnabled = false;
+        effects.filterCutoff = 1000.0f;
+        effects.filterResonance = 0.7f;
+        
+        effects.distortionEnabled = false;
+        effects.distortionDrive = 1.0f;
+        effects.distortionMix = 0.5f;
+        
+        sequencer.numSteps = 16;
+        sequencer.tempo = 120.0;
+        sequencer.stepStates.resize(16, false);
+        sequencer.stepVelocities.resize(16, 1.0f);
+    }
+};
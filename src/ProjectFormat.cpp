@@ -0,0 +1,353 @@
+#include "ProjectFormat.h"
+#include "SamplePool.h"
+
+namespace
+{
+    // InputStream::read takes an int, so no chunk can be larger than this;
+    // what actually bounds a chunk is the size of the file
+    constexpr juce::int64 maxChunkSize = std::numeric_limits<int>::max();
+
+    // ID, version, size and checksum
+    constexpr juce::int64 chunkHeaderSize = 4 + 4 + 8 + 4;
+
+    void writeStringList(juce::OutputStream& out, const juce::StringArray& strings)
+    {
+        out.writeInt(strings.size());
+        for (const auto& s : strings)
+            out.writeString(s);
+    }
+
+    void readStringList(juce::InputStream& in, juce::StringArray& strings)
+    {
+        strings.clear();
+        const int count = in.readInt();
+        for (int i = 0; i < count && !in.isExhausted(); ++i)
+            strings.add(in.readString());
+    }
+}
+
+juce::Array<juce::uint32> ProjectFormat::getProjectChunkIDs()
+{
+    return { metaChunk, effectsChunk, sequencerChunk, looperChunk, slicerChunk };
+}
+
+ProjectChunk ProjectFormat::encodeChunk(juce::uint32 id, const ProjectData& data)
+{
+    ProjectChunk chunk;
+    chunk.id = id;
+    chunk.version = id == looperChunk ? 3 : (id == slicerChunk ? 2 : 1);
+
+    juce::MemoryOutputStream out(chunk.data, false);
+
+    switch (id)
+    {
+        case metaChunk:
+            out.writeString(data.projectName);
+            out.writeString(data.projectPath);
+            out.writeDouble(data.tempo);
+            out.writeDouble(data.masterGain);
+            writeStringList(out, data.audioFiles);
+            break;
+
+        case effectsChunk:
+            out.writeBool(data.effects.reverbEnabled);
+            out.writeFloat(data.effects.reverbRoomSize);
+            out.writeFloat(data.effects.reverbDamping);
+            out.writeFloat(data.effects.reverbWetLevel);
+            out.writeFloat(data.effects.reverbDryLevel);
+            out.writeBool(data.effects.delayEnabled);
+            out.writeFloat(data.effects.delayTime);
+            out.writeFloat(data.effects.delayFeedback);
+            out.writeFloat(data.effects.delayMix);
+            out.writeBool(data.effects.filterEnabled);
+            out.writeFloat(data.effects.filterCutoff);
+            out.writeFloat(data.effects.filterResonance);
+            out.writeBool(data.effects.distortionEnabled);
+            out.writeFloat(data.effects.distortionDrive);
+            out.writeFloat(data.effects.distortionMix);
+            break;
+
+        case sequencerChunk:
+            out.writeInt(data.sequencer.numSteps);
+            out.writeDouble(data.sequencer.tempo);
+            out.writeInt((int)data.sequencer.stepStates.size());
+            for (bool state : data.sequencer.stepStates)
+                out.writeBool(state);
+            out.writeInt((int)data.sequencer.stepVelocities.size());
+            for (float velocity : data.sequencer.stepVelocities)
+                out.writeFloat(velocity);
+            break;
+
+        case looperChunk:
+            out.writeDouble(data.looperMasterLength);
+            out.writeInt((int)data.looper.size());
+            for (const auto& track : data.looper)
+            {
+                out.writeDouble(track.loopLength);
+                out.writeFloat(track.loopGain);
+                out.writeDouble(track.loopStart);
+                out.writeDouble(track.loopEnd);
+                out.writeBool(track.hasLoop);
+                out.writeString(track.audio.key);
+                out.writeDouble(track.lengthFactor);
+                out.writeBool(track.muted);
+                out.writeBool(track.reversed);
+            }
+            break;
+
+        case slicerChunk:
+            out.writeString(data.slicer.sampleFile);
+            out.writeInt((int)data.slicer.sliceNames.size());
+            for (size_t i = 0; i < data.slicer.sliceNames.size(); ++i)
+            {
+                out.writeString(data.slicer.sliceNames[i]);
+                out.writeDouble(i < data.slicer.sliceStartTimes.size() ? data.slicer.sliceStartTimes[i] : 0.0);
+                out.writeDouble(i < data.slicer.sliceEndTimes.size() ? data.slicer.sliceEndTimes[i] : 0.0);
+            }
+            out.writeString(data.slicer.sample.key);
+            break;
+
+        default:
+            jassertfalse;
+            break;
+    }
+
+    out.flush();
+    return chunk;
+}
+
+bool ProjectFormat::decodeChunk(const ProjectChunk& chunk, ProjectData& data)
+{
+    juce::MemoryInputStream in(chunk.data, false);
+
+    switch (chunk.id)
+    {
+        case metaChunk:
+            data.projectName = in.readString();
+            data.projectPath = in.readString();
+            data.tempo = in.readDouble();
+            data.masterGain = in.readDouble();
+            readStringList(in, data.audioFiles);
+            return true;
+
+        case effectsChunk:
+            data.effects.reverbEnabled = in.readBool();
+            data.effects.reverbRoomSize = in.readFloat();
+            data.effects.reverbDamping = in.readFloat();
+            data.effects.reverbWetLevel = in.readFloat();
+            data.effects.reverbDryLevel = in.readFloat();
+            data.effects.delayEnabled = in.readBool();
+            data.effects.delayTime = in.readFloat();
+            data.effects.delayFeedback = in.readFloat();
+            data.effects.delayMix = in.readFloat();
+            data.effects.filterEnabled = in.readBool();
+            data.effects.filterCutoff = in.readFloat();
+            data.effects.filterResonance = in.readFloat();
+            data.effects.distortionEnabled = in.readBool();
+            data.effects.distortionDrive = in.readFloat();
+            data.effects.distortionMix = in.readFloat();
+            return true;
+
+        case sequencerChunk:
+        {
+            data.sequencer.numSteps = in.readInt();
+            data.sequencer.tempo = in.readDouble();
+
+            data.sequencer.stepStates.clear();
+            const int numStates = in.readInt();
+            for (int i = 0; i < numStates && !in.isExhausted(); ++i)
+                data.sequencer.stepStates.push_back(in.readBool());
+
+            data.sequencer.stepVelocities.clear();
+            const int numVelocities = in.readInt();
+            for (int i = 0; i < numVelocities && !in.isExhausted(); ++i)
+                data.sequencer.stepVelocities.push_back(in.readFloat());
+            return true;
+        }
+
+        case looperChunk:
+        {
+            data.looper.clear();
+            data.looperMasterLength = chunk.version >= 3 ? in.readDouble() : 0.0;
+
+            // Up to version 2 a project kept the first track only
+            const int numTracks = chunk.version >= 3 ? in.readInt() : 1;
+            for (int i = 0; i < numTracks && !in.isExhausted(); ++i)
+            {
+                ProjectData::LooperData track;
+                track.loopLength = in.readDouble();
+                track.loopGain = in.readFloat();
+                track.loopStart = in.readDouble();
+                track.loopEnd = in.readDouble();
+                track.hasLoop = in.readBool();
+                if (chunk.version >= 2)
+                    track.audio.key = in.readString();
+                if (chunk.version >= 3)
+                {
+                    track.lengthFactor = in.readDouble();
+                    track.muted = in.readBool();
+                    track.reversed = in.readBool();
+                }
+                data.looper.push_back(track);
+            }
+
+            if (chunk.version < 3 && !data.looper.empty() && data.looper[0].hasLoop)
+                data.looperMasterLength = data.looper[0].loopLength;
+            return true;
+        }
+
+        case slicerChunk:
+        {
+            data.slicer.sampleFile = in.readString();
+            data.slicer.sliceNames.clear();
+            data.slicer.sliceStartTimes.clear();
+            data.slicer.sliceEndTimes.clear();
+
+            const int numSlices = in.readInt();
+            for (int i = 0; i < numSlices && !in.isExhausted(); ++i)
+            {
+                data.slicer.sliceNames.push_back(in.readString());
+                data.slicer.sliceStartTimes.push_back(in.readDouble());
+                data.slicer.sliceEndTimes.push_back(in.readDouble());
+            }
+
+            data.slicer.sample = {};
+            if (chunk.version >= 2)
+                data.slicer.sample.key = in.readString();
+            return true;
+        }
+
+        default:
+            // Unknown chunk from a newer build
+            return false;
+    }
+}
+
+bool ProjectFormat::encodeAudioChunk(const EmbeddedAudio& audio, ProjectChunk& chunk)
+{
+    if (audio.buffer == nullptr || audio.key.isEmpty())
+        return false;
+
+    chunk.id = audioChunk;
+    chunk.version = 1;
+    chunk.data.reset();
+
+    juce::MemoryOutputStream out(chunk.data, false);
+    out.writeString(audio.key);
+    out.writeDouble(audio.sampleRate);
+    out.writeInt(audio.buffer->getNumChannels());
+    out.writeInt64(audio.buffer->getNumSamples());
+    out.flush();
+
+    juce::MemoryBlock flacData;
+    if (!SamplePool::encodeFLAC(*audio.buffer, audio.sampleRate, flacData))
+        return false;
+
+    chunk.data.append(flacData.getData(), flacData.getSize());
+    return true;
+}
+
+bool ProjectFormat::decodeAudioChunk(const ProjectChunk& chunk, juce::String& key, double& sampleRate,
+                                     juce::MemoryBlock& flacData)
+{
+    if (chunk.id != audioChunk)
+        return false;
+
+    juce::MemoryInputStream in(chunk.data, false);
+    key = in.readString();
+    sampleRate = in.readDouble();
+    in.readInt();   // Channels and length are also in the FLAC stream; kept
+    in.readInt64(); // in the header for tools that only scan chunk headers
+
+    const auto headerSize = (size_t)in.getPosition();
+    if (key.isEmpty() || headerSize > chunk.data.getSize())
+        return false;
+
+    flacData.replaceAll(static_cast<const char*>(chunk.data.getData()) + headerSize,
+                        chunk.data.getSize() - headerSize);
+    return true;
+}
+
+bool ProjectFormat::writeChunks(juce::OutputStream& stream, const std::vector<const ProjectChunk*>& chunks)
+{
+    bool ok = stream.writeInt((int)magic)
+           && stream.writeInt((int)formatVersion)
+           && stream.writeInt((int)chunks.size());
+
+    for (const auto* chunk : chunks)
+    {
+        ok = ok && stream.writeInt((int)chunk->id)
+                && stream.writeInt((int)chunk->version)
+                && stream.writeInt64((juce::int64)chunk->data.getSize())
+                && stream.writeInt((int)checksum(chunk->data.getData(), chunk->data.getSize()))
+                && stream.write(chunk->data.getData(), chunk->data.getSize());
+    }
+
+    return ok;
+}
+
+bool ProjectFormat::readChunks(juce::InputStream& stream, std::vector<ProjectChunk>& chunks)
+{
+    if ((juce::uint32)stream.readInt() != magic)
+        return false;
+
+    const auto version = (juce::uint32)stream.readInt();
+    if (version == 0 || version > formatVersion)
+        return false;
+
+    // Counts and sizes are checked against what the file still holds before
+    // anything is reserved, so a corrupt or truncated file fails here rather
+    // than in a huge allocation
+    const int numChunks = stream.readInt();
+    const auto remaining = stream.getNumBytesRemaining();
+    if (numChunks < 0 || remaining < 0 || numChunks > remaining / chunkHeaderSize)
+        return false;
+
+    chunks.clear();
+    chunks.reserve((size_t)numChunks);
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        ProjectChunk chunk;
+        chunk.id = (juce::uint32)stream.readInt();
+        chunk.version = (juce::uint32)stream.readInt();
+        const auto size = stream.readInt64();
+        const auto expectedChecksum = (juce::uint32)stream.readInt();
+
+        // An empty chunk may legitimately end the file
+        if (size < 0 || size > maxChunkSize || size > stream.getNumBytesRemaining())
+            return false;
+
+        chunk.data.setSize((size_t)size);
+        if (stream.read(chunk.data.getData(), (int)size) != (int)size)
+            return false;
+
+        if (checksum(chunk.data.getData(), chunk.data.getSize()) != expectedChecksum)
+            return false;
+
+        chunks.push_back(std::move(chunk));
+    }
+
+    return true;
+}
+
+bool ProjectFormat::isBinaryProject(const juce::File& file)
+{
+    juce::FileInputStream stream(file);
+    return stream.openedOk() && (juce::uint32)stream.readInt() == magic;
+}
+
+juce::uint32 ProjectFormat::checksum(const void* data, size_t size)
+{
+    // FNV-1a: cheap, and enough to catch torn or truncated chunks
+    auto* bytes = static_cast<const juce::uint8*>(data);
+    juce::uint32 hash = 2166136261u;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ProjectData.h"
+
+// One section of a project file, already encoded
+struct ProjectChunk
+{
+    juce::uint32 id;
+    juce::uint32 version;
+    juce::MemoryBlock data;
+
+    ProjectChunk() : id(0), version(0) {}
+};
+
+// Versioned, chunked binary layout of a .groovdeck project:
+//
+//   header: "GDCK" magic, uint32 format version, uint32 chunk count
+//   chunk:  uint32 id, uint32 chunk version, uint64 payload size, uint32 checksum, payload
+//
+// All integers are little-endian. Readers skip chunk ids they do not know and
+// tolerate payloads that end early, so newer files degrade gracefully in older
+// builds and older files load in newer ones.
+class ProjectFormat
+{
+public:
+    static constexpr juce::uint32 magic = 0x4b434447; // "GDCK"
+    static constexpr juce::uint32 formatVersion = 1;
+
+    enum ChunkID : juce::uint32
+    {
+        metaChunk = 0x4154454d,      // "META"
+        effectsChunk = 0x58464645,   // "EFFX"
+        sequencerChunk = 0x4e514553, // "SEQN"
+        looperChunk = 0x504f4f4c,    // "LOOP"
+        slicerChunk = 0x52434c53,    // "SLCR"
+        audioChunk = 0x49445541      // "AUDI", one per embedded buffer
+    };
+
+    // The chunk ids that make up a project, in file order
+    static juce::Array<juce::uint32> getProjectChunkIDs();
+
+    // Section <-> chunk conversion
+    static ProjectChunk encodeChunk(juce::uint32 id, const ProjectData& data);
+    static bool decodeChunk(const ProjectChunk& chunk, ProjectData& data);
+
+    // Embedded audio: key, sample rate and channel layout followed by FLAC data.
+    // Encoding is the expensive part of a save and is safe to run in parallel.
+    static bool encodeAudioChunk(const EmbeddedAudio& audio, ProjectChunk& chunk);
+    static bool decodeAudioChunk(const ProjectChunk& chunk, juce::String& key, double& sampleRate,
+                                 juce::MemoryBlock& flacData);
+
+    // Whole-file framing. Reading needs a stream that knows its length, such
+    // as a file, to check the chunk table against it.
+    static bool writeChunks(juce::OutputStream& stream, const std::vector<const ProjectChunk*>& chunks);
+    static bool readChunks(juce::InputStream& stream, std::vector<ProjectChunk>& chunks);
+    static bool isBinaryProject(const juce::File& file);
+
+    static juce::uint32 checksum(const void* data, size_t size);
+};
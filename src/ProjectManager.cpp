@@ -1,16 +1,23 @@
 #include "ProjectManager.h"
 
-ProjectManager::ProjectManager()
-    : autoSaveEnabled(false), autoSaveInterval(5)
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+ProjectManager::ProjectManager(SamplePool& pool)
+    : samplePool(pool), autoSaveEnabled(false), autoSaveInterval(5), autoSaveVersions(3), pendingSaves(0),
+      encodeThreads(juce::jmax(1, juce::SystemStats::getNumCpus() - 1)), saveThread(1)
 {
 }
 
 ProjectManager::~ProjectManager()
 {
-    if (autoSaveEnabled)
-    {
-        performAutoSave();
-    }
+    stopTimer();
+
+    // No auto-save here: the owner makes the last one while the state
+    // captureState reads is still alive. Never drop a queued save on the floor.
+    waitForPendingSaves();
 }
 
 bool ProjectManager::createProject(const juce::String& name, const juce::File& directory)
@@ -25,6 +32,7 @@ bool ProjectManager::createProject(const juce::String& name, const juce::File& d
     currentProject->projectPath = directory.getFullPathName();
     
     projectFile = directory.getChildFile(name + ".groovdeck");
+    lastAutoSave.reset();
     return true;
 }
 
@@ -33,7 +41,9 @@ bool ProjectManager::saveProject(const juce::File& file)
     if (!currentProject)
         return false;
     
-    return saveToFile(file, *currentProject);
+    projectFile = file;
+    queueSave(file, *currentProject);
+    return true;
 }
 
 bool ProjectManager::loadProject(const juce::File& file)
@@ -46,6 +56,7 @@ bool ProjectManager::loadProject(const juce::File& file)
     {
         currentProject = std::move(newProject);
         projectFile = file;
+        lastAutoSave.reset();
         return true;
     }
     return false;
@@ -60,6 +71,33 @@ bool ProjectManager::closeProject()
     
     currentProject.reset();
     projectFile = juce::File();
+    lastAutoSave.reset();
+    return true;
+}
+
+bool ProjectManager::exportProjectAsJSON(const juce::File& file)
+{
+    if (!currentProject)
+        return false;
+
+    const auto json = juce::JSON::toString(projectDataToVar(*currentProject));
+    return writeFileAtomically(file, [&json](juce::OutputStream& stream)
+    {
+        return stream.writeText(json, false, false, "\n");
+    });
+}
+
+bool ProjectManager::waitForPendingSaves(int timeoutMilliseconds)
+{
+    const auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32)timeoutMilliseconds;
+
+    while (pendingSaves.load() > 0)
+    {
+        if (juce::Time::getMillisecondCounter() > deadline)
+            return false;
+
+        juce::Thread::sleep(1);
+    }
     return true;
 }
 
@@ -93,45 +131,303 @@ void ProjectManager::enableAutoSave(bool enable)
     autoSaveEnabled = enable;
     if (enable)
     {
-        autoSaveTimer.startTimer(autoSaveInterval * 60 * 1000); // Convert to milliseconds
+        startTimer(autoSaveInterval * 60 * 1000); // Convert to milliseconds
     }
     else
     {
-        autoSaveTimer.stopTimer();
+        stopTimer();
     }
 }
 
 void ProjectManager::setAutoSaveInterval(int minutes)
 {
-    autoSaveInterval = minutes;
+    autoSaveInterval = juce::jmax(1, minutes);
     if (autoSaveEnabled)
     {
-        autoSaveTimer.startTimer(autoSaveInterval * 60 * 1000);
+        startTimer(autoSaveInterval * 60 * 1000);
     }
 }
 
+void ProjectManager::setAutoSaveVersions(int numVersions)
+{
+    autoSaveVersions = juce::jmax(1, numVersions);
+}
+
 void ProjectManager::performAutoSave()
 {
-    if (currentProject && !projectFile.getFullPathName().isEmpty())
+    if (!currentProject || projectFile.getFullPathName().isEmpty())
+        return;
+
+    // Slow storage must not build up a backlog; the next tick catches up
+    if (isSaving())
+        return;
+
+    ProjectData snapshot;
+    if (captureState)
+        captureState(snapshot);
+    else
+        snapshot = *currentProject;
+
+    if (lastAutoSave != nullptr && hasSameContent(*lastAutoSave, snapshot))
+        return;
+
+    *currentProject = snapshot;
+    lastAutoSave = std::make_shared<const ProjectData>(snapshot);
+    queueSave(getAutoSaveFile(1), snapshot, true);
+}
+
+juce::File ProjectManager::getAutoSaveFile(int version) const
+{
+    return projectFile.getSiblingFile(projectFile.getFileNameWithoutExtension()
+                                      + ".autosave-" + juce::String(version)
+                                      + projectFile.getFileExtension());
+}
+
+void ProjectManager::timerCallback()
+{
+    performAutoSave();
+}
+
+void ProjectManager::rotateAutoSaveFiles()
+{
+    // Oldest falls off the end, every other copy moves up one
+    getAutoSaveFile(autoSaveVersions).deleteFile();
+
+    for (int version = autoSaveVersions - 1; version >= 1; --version)
+    {
+        auto file = getAutoSaveFile(version);
+        if (file.existsAsFile())
+            file.moveFileTo(getAutoSaveFile(version + 1));
+    }
+}
+
+bool ProjectManager::hasSameContent(const ProjectData& a, const ProjectData& b)
+{
+    if (a.looper.size() != b.looper.size() || a.slicer.sample.buffer != b.slicer.sample.buffer)
+        return false;
+
+    for (size_t i = 0; i < a.looper.size(); ++i)
+        if (a.looper[i].audio.buffer != b.looper[i].audio.buffer)
+            return false;
+
+    for (auto id : ProjectFormat::getProjectChunkIDs())
+    {
+        if (ProjectFormat::encodeChunk(id, a).data != ProjectFormat::encodeChunk(id, b).data)
+            return false;
+    }
+    return true;
+}
+
+void ProjectManager::queueSave(const juce::File& file, const ProjectData& data, bool rotateAutoSaves)
+{
+    // Copy on the calling thread so later edits cannot tear the save
+    auto snapshot = std::make_shared<ProjectData>(data);
+    ++pendingSaves;
+
+    saveThread.addJob([this, file, snapshot, rotateAutoSaves]
+    {
+        if (rotateAutoSaves)
+            rotateAutoSaveFiles();
+
+        const bool ok = saveToFile(file, *snapshot);
+
+        if (juce::MessageManager::getInstanceWithoutCreating() != nullptr)
+        {
+            juce::MessageManager::callAsync([safeThis = juce::WeakReference<ProjectManager>(this), file, ok]
+            {
+                if (safeThis != nullptr && safeThis->onSaveFinished)
+                    safeThis->onSaveFinished(file, ok);
+            });
+        }
+
+        --pendingSaves;
+    });
+}
+
+bool ProjectManager::saveToFile(const juce::File& file, const ProjectData& data)
+{
+    std::map<juce::String, ProjectChunk> chunks;
+    juce::StringArray order;
+    bool anyDirty = file != writtenFile || !file.existsAsFile();
+
+    for (auto id : ProjectFormat::getProjectChunkIDs())
+    {
+        auto chunk = ProjectFormat::encodeChunk(id, data);
+        const auto name = juce::String::toHexString((int)id);
+        auto written = writtenChunks.find(name);
+
+        if (written == writtenChunks.end() || written->second.data != chunk.data)
+            anyDirty = true;
+
+        chunks[name] = std::move(chunk);
+        order.add(name);
+    }
+
+    // Embedded audio: reuse the previous encoding when the buffer is the same
+    std::vector<const EmbeddedAudio*> toEncode;
+    std::vector<const EmbeddedAudio*> embedded { &data.slicer.sample };
+    for (const auto& track : data.looper)
+        embedded.push_back(&track.audio);
+
+    for (const auto* audio : embedded)
+    {
+        if (audio->buffer == nullptr || audio->key.isEmpty())
+            continue;
+
+        const auto name = "AUDI:" + audio->key;
+        auto written = writtenChunks.find(name);
+        auto source = writtenAudio.find(name);
+
+        if (written != writtenChunks.end() && source != writtenAudio.end() && source->second.lock() == audio->buffer)
+            chunks[name] = written->second;
+        else
+            toEncode.push_back(audio);
+
+        order.add(name);
+    }
+
+    if (writtenChunks.size() != chunks.size())
+        anyDirty = true;
+
+    if (!toEncode.empty())
+    {
+        anyDirty = true;
+        if (!encodeAudioChunks(toEncode, chunks))
+            return false;
+    }
+
+    if (!anyDirty)
+        return true;
+
+    std::vector<const ProjectChunk*> ordered;
+    for (const auto& name : order)
+        ordered.push_back(&chunks[name]);
+
+    const bool ok = writeFileAtomically(file, [&ordered](juce::OutputStream& stream)
+    {
+        return ProjectFormat::writeChunks(stream, ordered);
+    });
+
+    if (ok)
+    {
+        for (const auto* audio : toEncode)
+            writtenAudio["AUDI:" + audio->key] = audio->buffer;
+
+        writtenChunks = std::move(chunks);
+        writtenFile = file;
+    }
+    return ok;
+}
+
+bool ProjectManager::encodeAudioChunks(const std::vector<const EmbeddedAudio*>& audio, std::map<juce::String, ProjectChunk>& chunks)
+{
+    // One FLAC encode per buffer, spread over the worker threads
+    std::vector<ProjectChunk> encoded(audio.size());
+    std::atomic<int> remaining((int)audio.size());
+    std::atomic<bool> ok(true);
+    juce::WaitableEvent finished;
+
+    for (size_t i = 0; i < audio.size(); ++i)
     {
-        saveToFile(projectFile, *currentProject);
+        encodeThreads.addJob([&, i]
+        {
+            if (!ProjectFormat::encodeAudioChunk(*audio[i], encoded[i]))
+                ok = false;
+
+            if (--remaining == 0)
+                finished.signal();
+        });
     }
+
+    finished.wait();
+
+    for (size_t i = 0; i < audio.size(); ++i)
+        chunks["AUDI:" + audio[i]->key] = std::move(encoded[i]);
+
+    return ok.load();
 }
 
-void ProjectManager::saveToFile(const juce::File& file, const ProjectData& data)
+bool ProjectManager::writeFileAtomically(const juce::File& file, const std::function<bool(juce::OutputStream&)>& writer)
 {
-    juce::var projectVar = projectDataToVar(data);
-    juce::FileOutputStream stream(file);
-    if (stream.openedOk())
+    // Write next to the target, flush it to the disk, then rename over the
+    // old file. A crash at any point leaves either the old or the new project.
+    juce::TemporaryFile tempFile(file, juce::TemporaryFile::useHiddenFile);
+
     {
-        stream.setPosition(0);
-        stream.truncate();
-        stream.writeText(projectVar.toString(), false, false, "\n");
+        juce::FileOutputStream stream(tempFile.getFile());
+        if (!stream.openedOk())
+            return false;
+
+        if (!writer(stream))
+            return false;
+
+        stream.flush();
+        if (stream.getStatus().failed())
+            return false;
     }
+
+    syncToDisk(tempFile.getFile());
+
+    if (!tempFile.overwriteTargetFileWithTemporary())
+        return false;
+
+    // Make the rename itself durable
+    syncToDisk(file.getParentDirectory());
+    return true;
+}
+
+void ProjectManager::syncToDisk(const juce::File& file)
+{
+   #if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+    const int fd = ::open(file.getFullPathName().toRawUTF8(), O_RDONLY);
+    if (fd >= 0)
+    {
+        ::fsync(fd);
+        ::close(fd);
+    }
+   #else
+    juce::ignoreUnused(file);
+   #endif
 }
 
 bool ProjectManager::loadFromFile(const juce::File& file, ProjectData& data)
 {
+    if (ProjectFormat::isBinaryProject(file))
+    {
+        juce::FileInputStream stream(file);
+        std::vector<ProjectChunk> chunks;
+        std::map<juce::String, double> audioSampleRates;
+
+        if (!stream.openedOk() || !ProjectFormat::readChunks(stream, chunks))
+            return false;
+
+        for (const auto& chunk : chunks)
+        {
+            if (chunk.id != ProjectFormat::audioChunk)
+            {
+                ProjectFormat::decodeChunk(chunk, data);
+                continue;
+            }
+
+            // Leave the audio compressed; the pool decodes it when first used
+            juce::String key;
+            double sampleRate = 0.0;
+            juce::MemoryBlock flacData;
+
+            if (ProjectFormat::decodeAudioChunk(chunk, key, sampleRate, flacData))
+            {
+                samplePool.addCompressed(key, std::move(flacData));
+                audioSampleRates[key] = sampleRate;
+            }
+        }
+
+        for (auto& track : data.looper)
+            track.audio.sampleRate = audioSampleRates[track.audio.key];
+        data.slicer.sample.sampleRate = audioSampleRates[data.slicer.sample.key];
+        return true;
+    }
+
+    // Projects saved before the binary format were plain JSON
     juce::String jsonString = file.loadFileAsString();
     juce::var projectVar = juce::JSON::parse(jsonString);
     
@@ -203,15 +499,24 @@ juce::var ProjectManager::projectDataToVar(const ProjectData& data)
     
     obj->setProperty("sequencer", sequencerObj);
     
-    // Looper data
-    juce::DynamicObject::Ptr looperObj = new juce::DynamicObject();
-    looperObj->setProperty("loopLength", data.looper.loopLength);
-    looperObj->setProperty("loopGain", data.looper.loopGain);
-    looperObj->setProperty("loopStart", data.looper.loopStart);
-    looperObj->setProperty("loopEnd", data.looper.loopEnd);
-    looperObj->setProperty("hasLoop", data.looper.hasLoop);
+    // Looper data, one object per track
+    juce::var looperArray;
+    for (const auto& track : data.looper)
+    {
+        juce::DynamicObject::Ptr trackObj = new juce::DynamicObject();
+        trackObj->setProperty("loopLength", track.loopLength);
+        trackObj->setProperty("loopGain", track.loopGain);
+        trackObj->setProperty("loopStart", track.loopStart);
+        trackObj->setProperty("loopEnd", track.loopEnd);
+        trackObj->setProperty("hasLoop", track.hasLoop);
+        trackObj->setProperty("lengthFactor", track.lengthFactor);
+        trackObj->setProperty("muted", track.muted);
+        trackObj->setProperty("reversed", track.reversed);
+        looperArray.append(juce::var(trackObj.get()));
+    }
     
-    obj->setProperty("looper", looperObj);
+    obj->setProperty("looper", looperArray);
+    obj->setProperty("looperMasterLength", data.looperMasterLength);
     
     // Slicer data
     juce::DynamicObject::Ptr slicerObj = new juce::DynamicObject();
@@ -322,17 +627,38 @@ bool ProjectManager::varToProjectData(const juce::var& var, ProjectData& data)
         }
     }
     
-    // Looper data
+    // Looper data: an array of tracks, or in older files a single object
     juce::var looperVar = obj->getProperty("looper");
-    if (looperVar.isObject())
-    {
-        juce::DynamicObject::Ptr looperObj = looperVar.getDynamicObject();
-        data.looper.loopLength = looperObj->getProperty("loopLength");
-        data.looper.loopGain = looperObj->getProperty("loopGain");
-        data.looper.loopStart = looperObj->getProperty("loopStart");
-        data.looper.loopEnd = looperObj->getProperty("loopEnd");
-        data.looper.hasLoop = looperObj->getProperty("hasLoop");
+    data.looper.clear();
+
+    juce::Array<juce::var> trackVars;
+    if (looperVar.isArray())
+        trackVars = *looperVar.getArray();
+    else if (looperVar.isObject())
+        trackVars.add(looperVar);
+
+    for (const auto& trackVar : trackVars)
+    {
+        juce::DynamicObject::Ptr trackObj = trackVar.getDynamicObject();
+        if (trackObj == nullptr)
+            continue;
+
+        ProjectData::LooperData track;
+        track.loopLength = trackObj->getProperty("loopLength");
+        track.loopGain = trackObj->getProperty("loopGain");
+        track.loopStart = trackObj->getProperty("loopStart");
+        track.loopEnd = trackObj->getProperty("loopEnd");
+        track.hasLoop = trackObj->getProperty("hasLoop");
+        if (trackObj->hasProperty("lengthFactor"))
+            track.lengthFactor = trackObj->getProperty("lengthFactor");
+        track.muted = trackObj->getProperty("muted");
+        track.reversed = trackObj->getProperty("reversed");
+        data.looper.push_back(track);
     }
+
+    data.looperMasterLength = obj->hasProperty("looperMasterLength")
+        ? (double)obj->getProperty("looperMasterLength")
+        : (!data.looper.empty() && data.looper[0].hasLoop ? data.looper[0].loopLength : 0.0);
     
     // Slicer data
     juce::var slicerVar = obj->getProperty("slicer");
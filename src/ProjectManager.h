@@ -1,117 +1,32 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "AudioEngine.h"
-#include "LiveLooper.h"
-#include "Sequencer.h"
-#include "SampleSlicer.h"
+#include "ProjectData.h"
+#include "ProjectFormat.h"
+#include "SamplePool.h"
 
-struct ProjectData
-{
-    juce::String projectName;
-    juce::String projectPath;
-    double tempo;
-    double masterGain;
-    
-    // Audio file references
-    juce::StringArray audioFiles;
-    
-    // Effects settings
-    struct EffectsSettings
-    {
-        bool reverbEnabled;
-        float reverbRoomSize;
-        float reverbDamping;
-        float reverbWetLevel;
-        float reverbDryLevel;
-        
-        bool delayEnabled;
-        float delayTime;
-        float delayFeedback;
-        float delayMix;
-        
-        bool filterEnabled;
-        float filterCutoff;
-        float filterResonance;
-        
-        bool distortionEnabled;
-        float distortionDrive;
-        float distortionMix;
-    } effects;
-    
-    // Sequencer data
-    struct SequencerData
-    {
-        int numSteps;
-        double tempo;
-        std::vector<bool> stepStates;
-        std::vector<float> stepVelocities;
-    } sequencer;
-    
-    // Live looper data
-    struct LooperData
-    {
-        double loopLength;
-        float loopGain;
-        double loopStart;
-        double loopEnd;
-        bool hasLoop;
-    } looper;
-    
-    // Sample slicer data
-    struct SlicerData
-    {
-        juce::String sampleFile;
-        std::vector<juce::String> sliceNames;
-        std::vector<double> sliceStartTimes;
-        std::vector<double> sliceEndTimes;
-    } slicer;
-    
-    ProjectData() : tempo(120.0), masterGain(1.0)
-    {
-        effects.reverbEnabled = false;
-        effects.reverbRoomSize = 0.5f;
-        effects.reverbDamping = 0.5f;
-        effects.reverbWetLevel = 0.33f;
-        effects.reverbDryLevel = 0.67f;
-        
-        effects.delayEnabled = false;
-        effects.delayTime = 0.5f;
-        effects.delayFeedback = 0.3f;
-        effects.delayMix = 0.3f;
-        
-        effects.filterEnabled = false;
-        effects.filterCutoff = 1000.0f;
-        effects.filterResonance = 0.7f;
-        
-        effects.distortionEnabled = false;
-        effects.distortionDrive = 1.0f;
-        effects.distortionMix = 0.5f;
-        
-        sequencer.numSteps = 16;
-        sequencer.tempo = 120.0;
-        sequencer.stepStates.resize(16, false);
-        sequencer.stepVelocities.resize(16, 1.0f);
-        
-        looper.loopLength = 4.0;
-        looper.loopGain = 1.0f;
-        looper.loopStart = 0.0;
-        looper.loopEnd = 4.0;
-        looper.hasLoop = false;
-    }
-};
-
-class ProjectManager
+class ProjectManager : private juce::Timer
 {
 public:
-    ProjectManager();
-    ~ProjectManager();
+    ProjectManager(SamplePool& samplePool);
+    ~ProjectManager() override;
 
-    // Project management
+    // Project management. Saving snapshots the project on the calling thread
+    // and writes it in the background; loading reads both the binary format
+    // and older JSON projects. Embedded audio is registered with the sample
+    // pool still compressed and decoded when first used.
     bool createProject(const juce::String& name, const juce::File& directory);
     bool saveProject(const juce::File& file);
     bool loadProject(const juce::File& file);
     bool closeProject();
+    bool exportProjectAsJSON(const juce::File& file);
+
+    // Background saving
+    bool isSaving() const { return pendingSaves.load() > 0; }
+    bool waitForPendingSaves(int timeoutMilliseconds = 10000);
+
+    // Called on the message thread when a background save has finished
+    std::function<void(const juce::File&, bool)> onSaveFinished;
     
     // Project state
     bool hasProject() const { return currentProject != nullptr; }
@@ -122,22 +37,62 @@ public:
     void exportProjectData(ProjectData& data);
     void importProjectData(const ProjectData& data);
     
-    // Auto-save
+    // Auto-save. Each run captures a snapshot of the live state on the
+    // message thread (cheap: audio buffers are shared, not copied), skips the
+    // save if nothing changed since the last one, and otherwise writes it in
+    // the background as <name>.autosave-1.groovdeck, shifting older copies up
+    // to the configured number of versions.
     void enableAutoSave(bool enable);
+    bool isAutoSaveEnabled() const { return autoSaveEnabled; }
     void setAutoSaveInterval(int minutes);
+    void setAutoSaveVersions(int numVersions);
     void performAutoSave();
+    juce::File getAutoSaveFile(int version) const;
+
+    // Fills in the live engine state for auto-save; without it the last
+    // imported project data is saved. The owner makes the final auto-save
+    // on shutdown, before clearing this.
+    std::function<void(ProjectData&)> captureState;
 
 private:
+    SamplePool& samplePool;
     std::unique_ptr<ProjectData> currentProject;
     juce::File projectFile;
     bool autoSaveEnabled;
     int autoSaveInterval;
-    juce::Timer autoSaveTimer;
-    
-    void saveToFile(const juce::File& file, const ProjectData& data);
+    int autoSaveVersions;
+    std::shared_ptr<const ProjectData> lastAutoSave;
+
+    std::atomic<int> pendingSaves;
+
+    // Chunks exactly as last written, touched only by the save thread. A
+    // chunk whose new encoding matches is clean; if every chunk is clean the
+    // file on disk is already up to date and is left alone. Audio chunks are
+    // compared by buffer identity instead, since embedded buffers are never
+    // modified in place, which lets an unchanged loop skip FLAC encoding.
+    std::map<juce::String, ProjectChunk> writtenChunks;
+    std::map<juce::String, std::weak_ptr<const juce::AudioBuffer<float>>> writtenAudio;
+    juce::File writtenFile;
+
+    // Saves run one at a time on saveThread, in the order they were asked
+    // for, and encode audio on encodeThreads. Declared last, saveThread
+    // after the pool it uses, so a save still running is finished before
+    // anything it touches is destroyed.
+    juce::ThreadPool encodeThreads;
+    juce::ThreadPool saveThread;
+
+    void timerCallback() override;
+    void queueSave(const juce::File& file, const ProjectData& data, bool rotateAutoSaves = false);
+    void rotateAutoSaveFiles();
+    static bool hasSameContent(const ProjectData& a, const ProjectData& b);
+    bool saveToFile(const juce::File& file, const ProjectData& data);
+    bool encodeAudioChunks(const std::vector<const EmbeddedAudio*>& audio, std::map<juce::String, ProjectChunk>& chunks);
     bool loadFromFile(const juce::File& file, ProjectData& data);
+    static bool writeFileAtomically(const juce::File& file, const std::function<bool(juce::OutputStream&)>& writer);
+    static void syncToDisk(const juce::File& file);
     juce::var projectDataToVar(const ProjectData& data);
     bool varToProjectData(const juce::var& var, ProjectData& data);
 
+    JUCE_DECLARE_WEAK_REFERENCEABLE(ProjectManager)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProjectManager)
 }; 
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "RealtimeConfig.h"
+
+#if JUCE_LINUX
+ #include <cstring>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+   #if JUCE_LINUX
+    juce::String describeError(int error)
+    {
+        return juce::String(std::strerror(error));
+    }
+
+    // The last CPU in /sys/devices/system/cpu/isolated, e.g. "3" or "2-3",
+    // which the scheduler leaves alone; -1 if none is isolated
+    int findIsolatedCore()
+    {
+        const auto list = juce::File("/sys/devices/system/cpu/isolated").loadFileAsString().trim();
+        if (list.isEmpty())
+            return -1;
+
+        return list.fromLastOccurrenceOf(",", false, false).fromLastOccurrenceOf("-", false, false).getIntValue();
+    }
+
+    // Writes one byte per page below the caller's frame, so the stack the
+    // audio thread grows into is already backed
+    __attribute__((noinline)) void prefaultStack()
+    {
+        volatile char stack[RealtimeConfig::stackPrefaultBytes];
+        for (size_t i = 0; i < sizeof(stack); i += 4096)
+            stack[i] = 0;
+    }
+   #endif
+}
+
+RealtimeConfig::RealtimeConfig()
+{
+}
+
+RealtimeConfig::~RealtimeConfig()
+{
+    stopTimer();
+}
+
+void RealtimeConfig::applyToProcess(const Options& newOptions)
+{
+    enabled = true;
+    options = newOptions;
+    options.priority = juce::jlimit(1, 99, options.priority);
+
+   #if JUCE_LINUX
+    if (options.lockMemory)
+    {
+        // With MCL_FUTURE, allocations past a finite limit would fail
+        // outright, so everything is only locked when nothing limits it
+        rlimit limit {};
+        getrlimit(RLIMIT_MEMLOCK, &limit);
+
+        if (limit.rlim_cur != RLIM_INFINITY)
+            memoryResult = "memlock limit " + juce::String((juce::int64)limit.rlim_cur / 1024) + " KB, not locking everything";
+        else if ((allMemoryLocked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0))
+            memoryResult = "all memory locked";
+        else
+            memoryResult = "mlockall failed: " + describeError(errno);
+    }
+    else
+    {
+        memoryResult = "not locked";
+    }
+
+    // rtkit only grants realtime to threads that cannot hog the CPU; its
+    // default ceiling is 200 ms without blocking, which audio never nears
+    rlimit rtTime { 200000, 200000 };
+    setrlimit(RLIMIT_RTTIME, &rtTime);
+
+    // Keep this thread, and every thread started from it from now on,
+    // off the audio core; the audio thread moves itself onto it
+    const int numCpus = juce::SystemStats::getNumCpus();
+    const int isolatedCore = options.audioCore < 0 ? findIsolatedCore() : -1;
+    audioCore = options.audioCore >= 0 ? options.audioCore : (isolatedCore >= 0 ? isolatedCore : numCpus - 1);
+
+    if (numCpus < 2)
+    {
+        audioCore = -1;
+        coreResult = "not pinned, only one CPU";
+    }
+    else if (!juce::isPositiveAndBelow(audioCore, numCpus))
+    {
+        coreResult = "not pinned, there is no CPU " + juce::String(audioCore);
+        audioCore = -1;
+    }
+    else
+    {
+        cpu_set_t others;
+        CPU_ZERO(&others);
+        for (int cpu = 0; cpu < numCpus; ++cpu)
+            if (cpu != audioCore)
+                CPU_SET(cpu, &others);
+
+        coreResult = "audio on CPU " + juce::String(audioCore) + (audioCore == isolatedCore ? " (isolated)" : "");
+        if (sched_setaffinity(0, sizeof(others), &others) == 0)
+            coreResult << ", other threads off it";
+        else
+            coreResult << ", other threads not moved: " << describeError(errno);
+    }
+   #endif
+
+    startTimer(250);
+}
+
+void RealtimeConfig::lockArena(AudioArena& arena)
+{
+    if (!enabled || !options.lockMemory || allMemoryLocked)
+        return;
+
+    // Reserving touches every page, so it is resident before it is locked
+    if (!arena.isReserved())
+        arena.reserve(AudioArena::defaultBudget);
+
+    const auto size = juce::String((double)arena.getCapacity() / (1024.0 * 1024.0), 1) + " MB";
+    arenaResult = arena.lock() ? "audio arena locked (" + size + ")"
+                               : "audio arena not locked (" + size + "), raise the memlock limit";
+}
+
+void RealtimeConfig::applyToAudioThread()
+{
+   #if JUCE_LINUX
+    if (!enabled)
+        return;
+
+    sched_param parameters {};
+    parameters.sched_priority = options.priority;
+    schedulingError = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+
+    int policy = 0;
+    if (pthread_getschedparam(pthread_self(), &policy, &parameters) == 0)
+    {
+        grantedPolicy = policy;
+        grantedPriority = parameters.sched_priority;
+    }
+
+    if (audioCore >= 0)
+    {
+        cpu_set_t core;
+        CPU_ZERO(&core);
+        CPU_SET(audioCore, &core);
+        affinityError = pthread_setaffinity_np(pthread_self(), sizeof(core), &core);
+    }
+
+    prefaultStack();
+    threadId = (int)syscall(SYS_gettid);
+   #endif
+}
+
+void RealtimeConfig::timerCallback()
+{
+    // Each new audio thread, e.g. after a device change, is reported once
+    const int tid = threadId.load();
+    if (tid == 0 || tid == reportedThreadId)
+        return;
+
+    reportedThreadId = tid;
+    rtkitResult.clear();
+
+    if (schedulingError.load() != 0)
+        requestPriorityFromRtkit(tid);
+
+    juce::Logger::writeToLog(createReport());
+}
+
+void RealtimeConfig::requestPriorityFromRtkit(int tid)
+{
+   #if JUCE_LINUX
+    const juce::String service = "org.freedesktop.RealtimeKit1";
+    const juce::String object = "/org/freedesktop/RealtimeKit1";
+
+    // rtkit caps what it grants, so ask for no more than that; it answers
+    // e.g. "i 20"
+    int priority = options.priority;
+    juce::ChildProcess query;
+    if (query.start(juce::StringArray { "busctl", "--system", "get-property", service, object, service, "MaxRealtimePriority" }))
+    {
+        const auto answer = query.readAllProcessOutput().trim();
+        if (answer.startsWith("i "))
+            priority = juce::jmin(priority, answer.substring(2).getIntValue());
+    }
+
+    // By PID and thread ID, since the request comes from busctl, not us
+    juce::ChildProcess request;
+    if (!request.start(juce::StringArray { "busctl", "--system", "call", service, object, service, "MakeThreadRealtimeWithPID", "ttu",
+                                           juce::String((int)getpid()), juce::String(tid), juce::String(priority) }))
+    {
+        rtkitResult = "rtkit not asked, busctl missing";
+        return;
+    }
+
+    const auto answer = request.readAllProcessOutput().trim();
+    rtkitResult = request.getExitCode() == 0 ? "granted by rtkit" : "rtkit refused: " + answer;
+
+    readAudioThreadScheduling();
+   #else
+    juce::ignoreUnused(tid);
+   #endif
+}
+
+void RealtimeConfig::readAudioThreadScheduling()
+{
+   #if JUCE_LINUX
+    // Linux takes a thread ID wherever these take a process ID
+    const int tid = threadId.load();
+    sched_param parameters {};
+    const int policy = sched_getscheduler(tid);
+
+    if (policy >= 0 && sched_getparam(tid, &parameters) == 0)
+    {
+        grantedPolicy = policy;
+        grantedPriority = parameters.sched_priority;
+    }
+   #endif
+}
+
+juce::String RealtimeConfig::createReport() const
+{
+    juce::String report;
+    report << "Realtime setup" << juce::newLine;
+
+   #if JUCE_LINUX
+    if (!enabled)
+        return report << "  off" << juce::newLine;
+
+    report << "  memory:   " << memoryResult << (arenaResult.isNotEmpty() ? ", " + arenaResult : juce::String()) << juce::newLine;
+
+    if (threadId.load() == 0)
+        return report << "  audio thread not started yet" << juce::newLine;
+
+    const int policy = grantedPolicy.load();
+    juce::String scheduling;
+    if (policy == SCHED_FIFO || policy == SCHED_RR)
+        scheduling << (policy == SCHED_FIFO ? "SCHED_FIFO " : "SCHED_RR ") << grantedPriority.load();
+    else
+        scheduling << "normal priority";
+
+    if (const int error = schedulingError.load())
+        scheduling << " (asked for SCHED_FIFO " << options.priority << ": " << describeError(error)
+                   << (rtkitResult.isNotEmpty() ? "; " + rtkitResult : juce::String()) << ")";
+
+    report << "  priority: " << scheduling << juce::newLine;
+    report << "  cpu:      " << coreResult;
+    if (const int error = affinityError.load())
+        report << ", audio thread not pinned: " << describeError(error);
+    report << juce::newLine;
+    report << "  stack:    " << (int)(stackPrefaultBytes / 1024) << " KB prefaulted on the audio thread" << juce::newLine;
+   #else
+    report << "  not supported on this platform" << juce::newLine;
+   #endif
+
+    return report;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioArena.h"
+
+// Sets the process up for realtime audio: memory locked so nothing the audio
+// thread touches is ever paged out, the audio thread at SCHED_FIFO priority
+// and pinned to a core of its own, and its stack faulted in up front.
+//
+// Process-wide steps run on the message thread at startup, before the audio
+// device opens: locking memory and keeping every other thread off the audio
+// core. The audio thread configures itself from its first callback, with
+// plain system calls only. If it may not raise its own priority, the
+// message thread asks rtkit to do it. Once the audio thread has been set up
+// a report of what was granted goes to the log.
+//
+// Linux only; elsewhere every step reports itself as unsupported.
+class RealtimeConfig : private juce::Timer
+{
+public:
+    struct Options
+    {
+        int priority = 70;              // SCHED_FIFO, 1 to 99
+        int audioCore = -1;             // -1 picks an isolated core, else the last one
+        bool lockMemory = true;
+    };
+
+    static constexpr size_t stackPrefaultBytes = 128 * 1024;
+
+    RealtimeConfig();
+    ~RealtimeConfig() override;
+
+    // Message thread, at startup
+    void applyToProcess(const Options& options);
+    bool isEnabled() const { return enabled; }
+
+    // Message thread, once the arena is reserved. With all memory locked
+    // already this does nothing; otherwise, e.g. under a memlock limit too
+    // small for the whole process, it locks just the arena.
+    void lockArena(AudioArena& arena);
+
+    // Audio thread, at the start of a new audio thread's first callback.
+    // Never allocates or blocks.
+    void applyToAudioThread();
+
+    juce::String createReport() const;
+
+private:
+    bool enabled = false;
+    Options options;
+
+    // Message thread
+    bool allMemoryLocked = false;
+    juce::String memoryResult;
+    juce::String arenaResult;
+    juce::String coreResult;
+    juce::String rtkitResult;
+    int audioCore = -1;
+    int reportedThreadId = 0;
+
+    // Written by the audio thread; threadId last, once the others are set
+    std::atomic<int> schedulingError { 0 };
+    std::atomic<int> grantedPolicy { -1 };
+    std::atomic<int> grantedPriority { 0 };
+    std::atomic<int> affinityError { 0 };
+    std::atomic<int> threadId { 0 };
+
+    void timerCallback() override;
+    void requestPriorityFromRtkit(int tid);
+    void readAudioThreadScheduling();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeConfig)
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Hands objects built on the message thread to a single audio thread without
+// locks. The message thread publishes replacements; the audio thread brackets
+// each use with acquire() and release(). Replaced objects are only ever
+// deleted on the message thread, once the audio thread has let go of them.
+template <typename T>
+class RealtimeObject
+{
+public:
+    RealtimeObject() = default;
+
+    ~RealtimeObject()
+    {
+        delete latest.load();
+    }
+
+    // Message thread
+    void publish(std::unique_ptr<T> object)
+    {
+        if (auto* previous = latest.exchange(object.release()))
+            retired.emplace_back(previous);
+
+        collectGarbage();
+    }
+
+    void collectGarbage()
+    {
+        auto* inUseNow = inUse.load();
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                     [inUseNow](const std::unique_ptr<T>& object) { return object.get() != inUseNow; }),
+                      retired.end());
+    }
+
+    const T* getLatest() const { return latest.load(); }
+
+    // Audio thread. The object stays valid until release(); the retry only
+    // spins if a publish lands between the two loads.
+    const T* acquire()
+    {
+        for (;;)
+        {
+            auto* object = latest.load();
+            inUse.store(object);
+
+            if (latest.load() == object)
+                return object;
+        }
+    }
+
+    void release()
+    {
+        inUse.store(nullptr);
+    }
+
+private:
+    std::atomic<T*> latest { nullptr };
+    std::atomic<T*> inUse { nullptr };
+    std::vector<std::unique_ptr<T>> retired;
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeObject)
+};
@@ -0,0 +1,172 @@
+#include "SamplePool.h"
+
+namespace
+{
+    // Decode in blocks so large files never need a second full-size copy
+    constexpr int decodeBlockSize = 65536;
+}
+
+SamplePool::SamplePool()
+    : decodeThreads(2)
+{
+    formatManager.registerBasicFormats();
+}
+
+SamplePool::~SamplePool()
+{
+    decodeThreads.removeAllJobs(true, 5000);
+}
+
+void SamplePool::addBuffer(const juce::String& key, BufferPtr buffer, double sampleRate)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->buffer = std::move(buffer);
+    entry->sampleRate = sampleRate;
+
+    const juce::ScopedLock sl(lock);
+    entries[key] = std::move(entry);
+}
+
+void SamplePool::addCompressed(const juce::String& key, juce::MemoryBlock compressedData)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->compressedData = std::move(compressedData);
+
+    const juce::ScopedLock sl(lock);
+    entries[key] = std::move(entry);
+}
+
+void SamplePool::addFile(const juce::String& key, const juce::File& file)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->file = file;
+
+    const juce::ScopedLock sl(lock);
+    entries[key] = std::move(entry);
+}
+
+void SamplePool::remove(const juce::String& key)
+{
+    const juce::ScopedLock sl(lock);
+    entries.erase(key);
+}
+
+void SamplePool::clear()
+{
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+}
+
+bool SamplePool::contains(const juce::String& key) const
+{
+    const juce::ScopedLock sl(lock);
+    return entries.find(key) != entries.end();
+}
+
+SamplePool::BufferPtr SamplePool::getBuffer(const juce::String& key)
+{
+    if (auto buffer = getBufferIfLoaded(key))
+        return buffer;
+
+    return decodeEntry(key);
+}
+
+SamplePool::BufferPtr SamplePool::getBufferIfLoaded(const juce::String& key) const
+{
+    const juce::ScopedLock sl(lock);
+    auto it = entries.find(key);
+    return it != entries.end() ? it->second->buffer : nullptr;
+}
+
+double SamplePool::getSampleRate(const juce::String& key) const
+{
+    const juce::ScopedLock sl(lock);
+    auto it = entries.find(key);
+    return it != entries.end() ? it->second->sampleRate : 0.0;
+}
+
+void SamplePool::preload(const juce::String& key, std::function<void(BufferPtr)> onLoaded)
+{
+    decodeThreads.addJob([this, key, onLoaded]
+    {
+        auto buffer = getBuffer(key);
+
+        if (onLoaded && juce::MessageManager::getInstanceWithoutCreating() != nullptr)
+        {
+            juce::MessageManager::callAsync([safeThis = juce::WeakReference<SamplePool>(this), onLoaded, buffer]
+            {
+                if (safeThis != nullptr)
+                    onLoaded(buffer);
+            });
+        }
+    });
+}
+
+bool SamplePool::encodeFLAC(const juce::AudioBuffer<float>& buffer, double sampleRate, juce::MemoryBlock& destData)
+{
+    juce::FlacAudioFormat flac;
+    auto stream = std::make_unique<juce::MemoryOutputStream>(destData, false);
+
+    // Quality option 1 of 0-8: nearly as small as the default and several
+    // times faster to encode, which matters when this runs as an auto-save
+    std::unique_ptr<juce::AudioFormatWriter> writer(flac.createWriterFor(stream.get(), sampleRate,
+                                                                         (unsigned int)buffer.getNumChannels(),
+                                                                         24, {}, 1));
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // Now owned by the writer
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+SamplePool::BufferPtr SamplePool::decodeEntry(const juce::String& key)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        const juce::ScopedLock sl(lock);
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return nullptr;
+        entry = it->second;
+    }
+
+    // Decode outside the lock; the entry keeps the source data alive
+    std::unique_ptr<juce::AudioFormatReader> reader;
+
+    if (entry->compressedData.getSize() > 0)
+        reader.reset(formatManager.createReaderFor(std::make_unique<juce::MemoryInputStream>(entry->compressedData, false)));
+    else if (entry->file.existsAsFile())
+        reader.reset(formatManager.createReaderFor(entry->file));
+
+    if (reader == nullptr)
+        return nullptr;
+
+    auto buffer = decode(*reader);
+    const double sampleRate = reader->sampleRate;
+
+    const juce::ScopedLock sl(lock);
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second != entry)
+        return buffer; // Replaced while decoding; hand out what we have
+
+    if (entry->buffer == nullptr)
+    {
+        entry->buffer = buffer;
+        entry->sampleRate = sampleRate;
+    }
+    return entry->buffer;
+}
+
+SamplePool::BufferPtr SamplePool::decode(juce::AudioFormatReader& reader)
+{
+    const int numSamples = (int)reader.lengthInSamples;
+    auto buffer = std::make_shared<juce::AudioBuffer<float>>(2, numSamples);
+
+    for (int position = 0; position < numSamples; position += decodeBlockSize)
+    {
+        const int numToRead = juce::jmin(decodeBlockSize, numSamples - position);
+        reader.read(buffer.get(), position, numToRead, position, true, true);
+    }
+
+    return buffer;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Shared store of decoded audio, keyed by name. Entries can be registered
+// already decoded, as compressed bytes (e.g. FLAC from a project bundle) or as
+// a file on disk; the latter two are only decoded when first needed, either on
+// the caller's thread via getBuffer or on the pool's worker threads via preload.
+//
+// Buffers are immutable once in the pool and handed out as shared pointers, so
+// holding on to one is cheap and never races with a reload.
+class SamplePool
+{
+public:
+    using BufferPtr = std::shared_ptr<const juce::AudioBuffer<float>>;
+
+    SamplePool();
+    ~SamplePool();
+
+    // Registration
+    void addBuffer(const juce::String& key, BufferPtr buffer, double sampleRate);
+    void addCompressed(const juce::String& key, juce::MemoryBlock compressedData);
+    void addFile(const juce::String& key, const juce::File& file);
+    void remove(const juce::String& key);
+    void clear();
+
+    // Access. getBuffer may decode and must not be called on the audio thread.
+    bool contains(const juce::String& key) const;
+    BufferPtr getBuffer(const juce::String& key);
+    BufferPtr getBufferIfLoaded(const juce::String& key) const;
+    double getSampleRate(const juce::String& key) const;
+
+    // Decodes on a worker thread; onLoaded is called on the message thread
+    // with the buffer, or nullptr if decoding failed
+    void preload(const juce::String& key, std::function<void(BufferPtr)> onLoaded = {});
+
+    // Encodes a buffer as FLAC, e.g. for embedding into a project
+    static bool encodeFLAC(const juce::AudioBuffer<float>& buffer, double sampleRate, juce::MemoryBlock& destData);
+
+private:
+    struct Entry
+    {
+        juce::MemoryBlock compressedData;
+        juce::File file;
+        BufferPtr buffer;
+        double sampleRate = 0.0;
+    };
+
+    mutable juce::CriticalSection lock;
+    std::map<juce::String, std::shared_ptr<Entry>> entries;
+    juce::AudioFormatManager formatManager;
+    juce::ThreadPool decodeThreads;
+
+    BufferPtr decodeEntry(const juce::String& key);
+    BufferPtr decode(juce::AudioFormatReader& reader);
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(SamplePool)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplePool)
+};
@@ -2,7 +2,12 @@
 #include <random>
 
 SampleSlicer::SampleSlicer()
-    : sampleRate(44100.0), sampleLength(0.0), currentSlice(-1), playing(false), globalGain(1.0f)
+    : sourceSampleRate(44100.0), sampleGeneration(0), snapshotGeneration(-1),
+      sampleRate(44100.0), sampleLength(0.0), triggerBaseNote(36), globalGain(1.0f),
+      voiceCounter(0), numActiveVoices(0), stopRequested(false),
+      voiceFilterEnabled(false), voiceFilterMode((int)MultimodeFilter::Mode::lowpass),
+      voiceFilterSlope((int)MultimodeFilter::Slope::db12), voiceFilterCutoff(8000.0f), voiceFilterResonance(0.707f),
+      voiceEnvelopeDepth(0.0f), voiceEnvelopeDecay(0.3f)
 {
 }
 
@@ -13,47 +18,228 @@ SampleSlicer::~SampleSlicer()
 void SampleSlicer::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
 {
     sampleRate = newSampleRate;
+
+    voiceBuffer.setSize(2, juce::jmax(1, samplesPerBlockExpected));
+    envelopeBuffer.assign((size_t)voiceBuffer.getNumSamples(), 0.0f);
+
+    for (auto& voice : voices)
+    {
+        voice.filter.prepare(newSampleRate);
+        voice.active = false;
+    }
+    numActiveVoices = 0;
 }
 
 void SampleSlicer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    if (!playing || currentSlice < 0 || currentSlice >= slices.size())
+    // Skipped while a new sample is swapped in; that stops every voice anyway
+    const juce::SpinLock::ScopedTryLockType sl(sampleLock);
+    if (!sl.isLocked())
         return;
 
-    const Slice& slice = slices[currentSlice];
-    if (!slice.active)
+    handlePendingRequests();
+    renderVoices(bufferToFill);
+}
+
+void SampleSlicer::renderVoices(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (numActiveVoices.load() == 0 || voiceBuffer.getNumSamples() == 0)
+        return;
+
+    // Voices are mixed on top of whatever is in the buffer; the voice buffer
+    // holds one prepared block, so longer blocks are done in pieces
+    const int maxBlockSize = voiceBuffer.getNumSamples();
+    for (int offset = 0; offset < bufferToFill.numSamples; offset += maxBlockSize)
+    {
+        const int numSamples = juce::jmin(maxBlockSize, bufferToFill.numSamples - offset);
+        for (auto& voice : voices)
+        {
+            if (voice.active)
+                renderVoice(voice, *bufferToFill.buffer, bufferToFill.startSample + offset, numSamples);
+        }
+    }
+
+    int stillActive = 0;
+    for (const auto& voice : voices)
+        stillActive += voice.active ? 1 : 0;
+    numActiveVoices = stillActive;
+}
+
+void SampleSlicer::renderVoice(Voice& voice, juce::AudioBuffer<float>& output, int startSample, int numSamples)
+{
+    // A sample at another rate than the device is read with linear
+    // interpolation, which needs the sample after the last one it reads
+    const double increment = sourceSampleRate / sampleRate;
+    const bool interpolate = increment != 1.0;
+    const int endSample = juce::jmin(voice.endSample, sampleBuffer.getNumSamples());
+    const double lastPosition = interpolate ? endSample - 1 : endSample;
+
+    const int numToRender = juce::jlimit(0, numSamples, (int)std::ceil((lastPosition - voice.position) / increment));
+    if (numToRender <= 0)
+    {
+        voice.active = false;
         return;
+    }
+
+    const int numChannels = juce::jmin(2, output.getNumChannels());
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const int sourceChannel = juce::jmin(ch, sampleBuffer.getNumChannels() - 1);
+
+        if (!interpolate)
+        {
+            juce::FloatVectorOperations::copyWithMultiply(voiceBuffer.getWritePointer(ch),
+                                                          sampleBuffer.getReadPointer(sourceChannel, (int)voice.position),
+                                                          voice.gain, numToRender);
+            continue;
+        }
+
+        const float* in = sampleBuffer.getReadPointer(sourceChannel);
+        float* out = voiceBuffer.getWritePointer(ch);
+        double position = voice.position;
+
+        for (int i = 0; i < numToRender; ++i)
+        {
+            const int index = (int)position;
+            const float fraction = (float)(position - index);
+            out[i] = voice.gain * (in[index] + fraction * (in[index + 1] - in[index]));
+            position += increment;
+        }
+    }
+
+    if (voiceFilterEnabled.load())
+    {
+        auto& filter = voice.filter;
+        filter.setMode((MultimodeFilter::Mode)voiceFilterMode.load());
+        filter.setSlope((MultimodeFilter::Slope)voiceFilterSlope.load());
+        filter.setCutoff(voiceFilterCutoff.load());
+        filter.setResonance(voiceFilterResonance.load());
+
+        const float depth = voiceEnvelopeDepth.load();
+        const float* modulation = nullptr;
+
+        if (depth != 0.0f)
+        {
+            const float decay = (float)std::exp(-1.0 / (juce::jmax(0.001f, voiceEnvelopeDecay.load()) * sampleRate));
+            for (int i = 0; i < numToRender; ++i)
+            {
+                envelopeBuffer[(size_t)i] = depth * voice.envelope;
+                voice.envelope *= decay;
+            }
+            modulation = envelopeBuffer.data();
+        }
+
+        filter.process(voiceBuffer.getArrayOfWritePointers(), 2, numToRender, modulation);
+    }
 
-    int startSample = static_cast<int>(slice.startTime * sampleRate);
-    int endSample = static_cast<int>(slice.endTime * sampleRate);
-    int sliceLength = endSample - startSample;
+    for (int ch = 0; ch < numChannels; ++ch)
+        output.addFrom(ch, startSample, voiceBuffer, ch, 0, numToRender);
 
-    if (startSample >= sampleBuffer.getNumSamples())
+    voice.position += numToRender * increment;
+    if (voice.position >= lastPosition)
+        voice.active = false;
+}
+
+void SampleSlicer::startVoice(int sliceIndex, float velocity)
+{
+    const auto* table = sliceTable.acquire();
+    if (table == nullptr || !juce::isPositiveAndBelow(sliceIndex, (int)table->size()))
+    {
+        sliceTable.release();
         return;
+    }
 
-    auto numSamples = bufferToFill.numSamples;
-    auto* leftChannel = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
-    auto* rightChannel = bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample);
+    const Slice& slice = (*table)[(size_t)sliceIndex];
+    const bool active = slice.active;
+    const int startSample = static_cast<int>(slice.startTime * sourceSampleRate);
+    const int endSample = juce::jmin(static_cast<int>(slice.endTime * sourceSampleRate), sampleBuffer.getNumSamples());
+    sliceTable.release();
 
-    for (int i = 0; i < numSamples; ++i)
+    if (!active || startSample >= endSample)
+        return;
+
+    // A free voice, or else the one that has been playing longest
+    Voice* target = nullptr;
+    for (auto& voice : voices)
     {
-        int sampleIndex = startSample + i;
-        if (sampleIndex < endSample && sampleIndex < sampleBuffer.getNumSamples())
+        if (!voice.active)
         {
-            leftChannel[i] = sampleBuffer.getSample(0, sampleIndex) * globalGain;
-            rightChannel[i] = sampleBuffer.getSample(1, sampleIndex) * globalGain;
+            target = &voice;
+            break;
         }
-        else
+
+        if (target == nullptr || voice.startOrder < target->startOrder)
+            target = &voice;
+    }
+
+    target->active = true;
+    target->startSample = startSample;
+    target->endSample = endSample;
+    target->position = (double)startSample;
+    target->gain = globalGain * velocity;
+    target->envelope = 1.0f;
+    target->startOrder = ++voiceCounter;
+    target->filter.reset();
+
+    numActiveVoices = numActiveVoices.load() + 1;
+}
+
+void SampleSlicer::handlePendingRequests()
+{
+    if (stopRequested.exchange(false))
+    {
+        for (auto& voice : voices)
+            voice.active = false;
+        numActiveVoices = 0;
+    }
+
+    const auto scope = requestFifo.read(requestFifo.getNumReady());
+    for (int i = 0; i < scope.blockSize1; ++i)
+        startVoice(requests[(size_t)(scope.startIndex1 + i)].index, requests[(size_t)(scope.startIndex1 + i)].velocity);
+    for (int i = 0; i < scope.blockSize2; ++i)
+        startVoice(requests[(size_t)(scope.startIndex2 + i)].index, requests[(size_t)(scope.startIndex2 + i)].velocity);
+}
+
+void SampleSlicer::renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill, const juce::MidiBuffer& midiMessages)
+{
+    const juce::SpinLock::ScopedTryLockType sl(sampleLock);
+    if (!sl.isLocked())
+        return;
+
+    handlePendingRequests();
+
+    int position = 0;
+
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+        if (!message.isNoteOn())
+            continue;
+
+        const int eventPosition = juce::jlimit(0, bufferToFill.numSamples, metadata.samplePosition);
+
+        // Render up to the event, then retrigger exactly on its sample
+        if (eventPosition > position)
         {
-            leftChannel[i] = 0.0f;
-            rightChannel[i] = 0.0f;
+            renderVoices(juce::AudioSourceChannelInfo(bufferToFill.buffer,
+                                                      bufferToFill.startSample + position,
+                                                      eventPosition - position));
+            position = eventPosition;
         }
+
+        startVoice(message.getNoteNumber() - triggerBaseNote, message.getFloatVelocity());
+    }
+
+    if (position < bufferToFill.numSamples)
+    {
+        renderVoices(juce::AudioSourceChannelInfo(bufferToFill.buffer,
+                                                  bufferToFill.startSample + position,
+                                                  bufferToFill.numSamples - position));
     }
 }
 
 void SampleSlicer::releaseResources()
 {
-    sampleBuffer.clear();
 }
 
 bool SampleSlicer::loadSample(const juce::File& file)
@@ -64,17 +250,86 @@ bool SampleSlicer::loadSample(const juce::File& file)
     std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
     if (reader != nullptr)
     {
+        juce::AudioBuffer<float> buffer;
+        auto memory = allocateSample((int)reader->lengthInSamples, buffer);
+        reader->read(&buffer, 0, (int)reader->lengthInSamples, 0, true, true);
+
+        swapSample(std::move(memory), buffer, reader->sampleRate);
         sampleLength = reader->lengthInSamples / reader->sampleRate;
-        sampleBuffer.setSize(2, reader->lengthInSamples);
-        reader->read(&sampleBuffer, 0, reader->lengthInSamples, 0, true, true);
+        sampleFile = file;
+        ++sampleGeneration;
         return true;
     }
     return false;
 }
 
+void SampleSlicer::loadSample(const juce::AudioBuffer<float>& audio, double audioSampleRate, const juce::File& sourceFile)
+{
+    const int length = audio.getNumSamples();
+    juce::AudioBuffer<float> buffer;
+    auto memory = allocateSample(length, buffer);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        buffer.copyFrom(ch, 0, audio, juce::jmin(ch, audio.getNumChannels() - 1), 0, length);
+    }
+
+    const double rate = audioSampleRate > 0.0 ? audioSampleRate : sampleRate;
+    swapSample(std::move(memory), buffer, rate);
+    sampleLength = length / rate;
+    sampleFile = sourceFile;
+    ++sampleGeneration;
+}
+
+AudioArena::Block SampleSlicer::allocateSample(int numSamples, juce::AudioBuffer<float>& buffer)
+{
+    // Both channels in one block, each starting on an aligned boundary
+    const size_t channelBytes = AudioArena::roundUp((size_t)juce::jmax(0, numSamples) * sizeof(float));
+    auto memory = AudioArena::allocateFrom(audioArena, AudioArena::Subsystem::slicer, channelBytes * 2);
+
+    float* channels[] = { memory.getData<float>(), memory.getData<float>() + channelBytes / sizeof(float) };
+    buffer.setDataToReferTo(channels, 2, numSamples);
+    return memory;
+}
+
+void SampleSlicer::swapSample(AudioArena::Block memory, juce::AudioBuffer<float>& buffer, double newSampleRate)
+{
+    {
+        const juce::SpinLock::ScopedLockType sl(sampleLock);
+
+        std::swap(sampleMemory, memory);
+        sampleBuffer.setDataToReferTo(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+        sourceSampleRate = newSampleRate;
+
+        // Every voice was reading the old sample
+        for (auto& voice : voices)
+            voice.active = false;
+        numActiveVoices = 0;
+    }
+
+    // Now holds the old sample, freed only once the audio thread is off it
+    memory.release();
+}
+
+std::shared_ptr<const juce::AudioBuffer<float>> SampleSlicer::getSampleSnapshot()
+{
+    if (!hasSample())
+        return nullptr;
+
+    if (snapshotGeneration != sampleGeneration || sampleSnapshot == nullptr)
+    {
+        sampleSnapshot = std::make_shared<juce::AudioBuffer<float>>(sampleBuffer);
+        snapshotGeneration = sampleGeneration;
+    }
+
+    return sampleSnapshot;
+}
+
 void SampleSlicer::unloadSample()
 {
-    sampleBuffer.clear();
+    juce::AudioBuffer<float> none;
+    swapSample({}, none, sourceSampleRate);
+    sampleFile = juce::File();
+    ++sampleGeneration;
     clearSlices();
     sampleLength = 0.0;
 }
@@ -91,8 +346,9 @@ void SampleSlicer::autoSlice(double sliceLength)
         double endTime = (i + 1) * sliceLength;
         if (endTime > sampleLength) endTime = sampleLength;
         
-        addSlice(startTime, endTime, "Slice " + juce::String(i + 1));
+        appendSlice(startTime, endTime, "Slice " + juce::String(i + 1));
     }
+    publishSlices();
 }
 
 void SampleSlicer::sliceAtBeats(double bpm)
@@ -109,8 +365,9 @@ void SampleSlicer::sliceAtBeats(double bpm)
         double endTime = (i + 1) * beatLength;
         if (endTime > sampleLength) endTime = sampleLength;
         
-        addSlice(startTime, endTime, "Beat " + juce::String(i + 1));
+        appendSlice(startTime, endTime, "Beat " + juce::String(i + 1));
     }
+    publishSlices();
 }
 
 void SampleSlicer::sliceAtTransients(double sensitivity)
@@ -141,15 +398,28 @@ void SampleSlicer::sliceAtTransients(double sensitivity)
     // Create slices from transient points
     for (size_t i = 0; i < transientPoints.size(); ++i)
     {
-        double startTime = transientPoints[i] / sampleRate;
+        double startTime = transientPoints[i] / sourceSampleRate;
         double endTime = (i + 1 < transientPoints.size()) ? 
-                        transientPoints[i + 1] / sampleRate : sampleLength;
+                        transientPoints[i + 1] / sourceSampleRate : sampleLength;
         
-        addSlice(startTime, endTime, "Transient " + juce::String(i + 1));
+        appendSlice(startTime, endTime, "Transient " + juce::String(i + 1));
     }
+    publishSlices();
 }
 
 void SampleSlicer::addSlice(double startTime, double endTime, const juce::String& name)
+{
+    appendSlice(startTime, endTime, name);
+    publishSlices();
+}
+
+void SampleSlicer::setSlices(std::vector<Slice> newSlices)
+{
+    slices = std::move(newSlices);
+    publishSlices();
+}
+
+void SampleSlicer::appendSlice(double startTime, double endTime, const juce::String& name)
 {
     Slice slice;
     slice.startTime = startTime;
@@ -159,33 +429,82 @@ void SampleSlicer::addSlice(double startTime, double endTime, const juce::String
     slices.push_back(slice);
 }
 
+void SampleSlicer::publishSlices()
+{
+    sliceTable.publish(std::make_unique<std::vector<Slice>>(slices));
+}
+
 void SampleSlicer::removeSlice(int index)
 {
     if (index >= 0 && index < slices.size())
     {
         slices.erase(slices.begin() + index);
+        publishSlices();
     }
 }
 
 void SampleSlicer::clearSlices()
 {
     slices.clear();
-    currentSlice = -1;
-    playing = false;
+    publishSlices();
+    stopSlice();
 }
 
-void SampleSlicer::playSlice(int index)
+void SampleSlicer::playSlice(int index, float velocity)
 {
-    if (index >= 0 && index < slices.size())
+    // The slice table is checked on the audio thread, against the version
+    // the voice will actually start from
+    if (index < 0)
+        return;
+
+    // Several UI or MIDI threads may ask at once
+    const juce::SpinLock::ScopedLockType sl(requestLock);
+    const auto scope = requestFifo.write(1);
+    if (scope.blockSize1 > 0)
+        requests[(size_t)scope.startIndex1] = { index, velocity };
+    else if (scope.blockSize2 > 0)
+        requests[(size_t)scope.startIndex2] = { index, velocity };
+}
+
+void SampleSlicer::stopSlice()
+{
+    stopRequested = true;
+}
+
+int SampleSlicer::getVoicePositions(float* destination, int maxPositions) const
+{
+    const juce::SpinLock::ScopedTryLockType sl(sampleLock);
+    if (!sl.isLocked())
+        return 0;
+
+    const int length = sampleBuffer.getNumSamples();
+    if (length == 0)
+        return 0;
+
+    int numWritten = 0;
+    for (const auto& voice : voices)
     {
-        currentSlice = index;
-        playing = true;
+        if (voice.active && numWritten < maxPositions)
+            destination[numWritten++] = (float)(voice.position / length);
     }
+
+    return numWritten;
 }
 
-void SampleSlicer::stopSlice()
+void SampleSlicer::setVoiceFilter(bool enabled, MultimodeFilter::Mode mode, MultimodeFilter::Slope slope,
+                                  float cutoff, float resonance)
+{
+    voiceFilterMode = (int)mode;
+    voiceFilterSlope = (int)slope;
+    voiceFilterCutoff = cutoff;
+    voiceFilterResonance = resonance;
+    voiceFilterEnabled = enabled;
+}
+
+void SampleSlicer::setVoiceFilterEnvelope(float depthOctaves, float decaySeconds)
 {
-    playing = false;
+    voiceEnvelopeDepth = depthOctaves;
+    voiceEnvelopeDecay = decaySeconds;
 }
 
 void SampleSlicer::setSliceGain(int index, float gain)
@@ -221,6 +540,7 @@ void SampleSlicer::setSliceActive(int index, bool active)
     if (index >= 0 && index < slices.size())
     {
         slices[index].active = active;
+        publishSlices();
     }
 }
 
@@ -229,11 +549,13 @@ void SampleSlicer::randomizeSliceOrder()
     std::random_device rd;
     std::mt19937 gen(rd());
     std::shuffle(slices.begin(), slices.end(), gen);
+    publishSlices();
 }
 
 void SampleSlicer::reverseSliceOrder()
 {
     std::reverse(slices.begin(), slices.end());
+    publishSlices();
 }
 
 void SampleSlicer::updateSliceTimes()
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "MultimodeFilter.h"
+#include "AudioArena.h"
+#include "RealtimeObject.h"
 
 struct Slice
 {
@@ -12,9 +15,13 @@ struct Slice
     Slice() : startTime(0.0), endTime(1.0), name("Slice"), active(true) {}
 };
 
+// Plays slices of one sample on up to 32 voices at once. Each voice has its
+// own multimode filter, swept by a per-voice decay envelope.
 class SampleSlicer : public juce::AudioSource
 {
 public:
+    static constexpr int maxVoices = 32;
+
     SampleSlicer();
     ~SampleSlicer() override;
 
@@ -23,26 +30,55 @@ public:
     void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
     void releaseResources() override;
 
-    // Sample loading
+    // Renders the block, starting slices at the sample offsets of the note-ons
+    // in midiMessages (note triggerBaseNote plays slice 0, and so on upward)
+    void renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill, const juce::MidiBuffer& midiMessages);
+    void setTriggerBaseNote(int note) { triggerBaseNote = note; }
+    int getTriggerBaseNote() const { return triggerBaseNote; }
+
+    // Where loaded samples are kept; the heap if never set
+    void setArena(AudioArena* newArena) { audioArena = newArena; }
+
+    // Sample loading. The sample keeps its own rate and is played back at
+    // the device rate; an audioSampleRate of 0 means it already matches.
     bool loadSample(const juce::File& file);
+    void loadSample(const juce::AudioBuffer<float>& audio, double audioSampleRate = 0.0, const juce::File& sourceFile = {});
     void unloadSample();
+    juce::File getSampleFile() const { return sampleFile; }
+
+    // Project state: immutable copy of the loaded sample, re-made only after
+    // a different sample was loaded
+    std::shared_ptr<const juce::AudioBuffer<float>> getSampleSnapshot();
 
     // Slicing functions
     void autoSlice(double sliceLength);
     void sliceAtBeats(double bpm);
     void sliceAtTransients(double sensitivity);
     void addSlice(double startTime, double endTime, const juce::String& name = "");
+    void setSlices(std::vector<Slice> newSlices);
     void removeSlice(int index);
     void clearSlices();
 
-    // Slice playback
-    void playSlice(int index);
+    // Slice playback. Safe to call from any thread; the voice starts at the
+    // beginning of the next block.
+    void playSlice(int index, float velocity = 1.0f);
     void stopSlice();
+    int getNumActiveVoices() const { return numActiveVoices.load(); }
+
+    // Audio thread: where the sounding voices are, as fractions of the
+    // sample. Returns how many were written.
+    int getVoicePositions(float* destination, int maxPositions) const;
+
+    // Per-voice filter, shared settings for all voices. The envelope opens
+    // the cutoff by depthOctaves at the start of a slice and decays from there.
+    void setVoiceFilter(bool enabled, MultimodeFilter::Mode mode, MultimodeFilter::Slope slope,
+                        float cutoff, float resonance);
+    void setVoiceFilterEnvelope(float depthOctaves, float decaySeconds);
     void setSliceGain(int index, float gain);
     void setSlicePitch(int index, float pitch);
     void setSliceSpeed(int index, float speed);
 
-    // Slice management
+    // Slice management, message thread
     int getNumSlices() const { return slices.size(); }
     const Slice& getSlice(int index) const;
     void setSliceActive(int index, bool active);
@@ -51,18 +87,82 @@ public:
 
     // Sample info
     double getSampleLength() const { return sampleLength; }
-    double getSampleRate() const { return sampleRate; }
+    double getSampleRate() const { return sourceSampleRate; }     // The sample's own
     bool hasSample() const { return sampleBuffer.getNumSamples() > 0; }
 
 private:
-    juce::AudioBuffer<float> sampleBuffer;
+    AudioArena* audioArena = nullptr;
+
+    // Read by the audio thread; the message thread only swaps them while
+    // holding sampleLock, which the audio thread skips a block rather than
+    // wait for
+    AudioArena::Block sampleMemory;
+    juce::AudioBuffer<float> sampleBuffer;      // Refers to sampleMemory
+    double sourceSampleRate;
+    juce::SpinLock sampleLock;
+
+    juce::File sampleFile;
+    int sampleGeneration;
+    int snapshotGeneration;
+    std::shared_ptr<const juce::AudioBuffer<float>> sampleSnapshot;
+
+    // Edited on the message thread, which publishes a copy after every
+    // change for the audio thread to start voices from
     std::vector<Slice> slices;
+    RealtimeObject<std::vector<Slice>> sliceTable;
+
     double sampleRate;
     double sampleLength;
-    int currentSlice;
-    bool playing;
+    int triggerBaseNote;
     float globalGain;
 
+    struct Voice
+    {
+        bool active = false;
+        int startSample = 0;
+        int endSample = 0;
+        double position = 0.0;          // In the sample, at its own rate
+        float gain = 0.0f;
+        float envelope = 0.0f;
+        juce::uint32 startOrder = 0;
+        MultimodeFilter filter;
+    };
+
+    std::array<Voice, maxVoices> voices;
+    juce::uint32 voiceCounter;
+    std::atomic<int> numActiveVoices;
+    juce::AudioBuffer<float> voiceBuffer;
+    std::vector<float> envelopeBuffer;
+
+    // Play requests from outside the audio thread
+    struct PlayRequest
+    {
+        int index;
+        float velocity;
+    };
+
+    juce::AbstractFifo requestFifo { 64 };
+    std::array<PlayRequest, 64> requests;
+    juce::SpinLock requestLock;
+    std::atomic<bool> stopRequested;
+
+    std::atomic<bool> voiceFilterEnabled;
+    std::atomic<int> voiceFilterMode;
+    std::atomic<int> voiceFilterSlope;
+    std::atomic<float> voiceFilterCutoff;
+    std::atomic<float> voiceFilterResonance;
+    std::atomic<float> voiceEnvelopeDepth;
+    std::atomic<float> voiceEnvelopeDecay;
+
+    AudioArena::Block allocateSample(int numSamples, juce::AudioBuffer<float>& buffer);
+    void swapSample(AudioArena::Block memory, juce::AudioBuffer<float>& buffer, double newSampleRate);
+    void appendSlice(double startTime, double endTime, const juce::String& name);
+    void publishSlices();
+    void startVoice(int sliceIndex, float velocity);
+    void handlePendingRequests();
+    void renderVoices(const juce::AudioSourceChannelInfo& bufferToFill);
+    void renderVoice(Voice& voice, juce::AudioBuffer<float>& output, int startSample, int numSamples);
+
     void updateSliceTimes();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleSlicer)
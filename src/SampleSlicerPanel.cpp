@@ -81,6 +81,13 @@ SampleSlicerPanel::~SampleSlicerPanel()
 void SampleSlicerPanel::paint(juce::Graphics& g)
 {
     g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+
+    g.setColour(juce::Colours::darkgrey);
+    g.fillRect(voiceArea);
+
+    g.setColour(juce::Colours::white);
+    for (int i = 0; i < numVoicesShown; ++i)
+        g.fillRect(voiceX[(size_t)i], voiceArea.getY(), 2, voiceArea.getHeight());
 }
 
 void SampleSlicerPanel::resized()
@@ -96,6 +103,7 @@ void SampleSlicerPanel::resized()
     
     // Sample info
     sampleInfoLabel.setBounds(area.removeFromTop(30).reduced(margin));
+    voiceArea = area.removeFromTop(20).reduced(margin, 4);
     
     // Slicing controls
     auto sliceArea = area.removeFromTop(buttonHeight * 2).reduced(margin);
@@ -117,6 +125,23 @@ void SampleSlicerPanel::resized()
     stopSliceButton.setBounds(playbackArea.reduced(5));
 }
 
+void SampleSlicerPanel::showSnapshot(const EngineSnapshot& snapshot)
+{
+    std::array<int, EngineSnapshot::maxSlicerPlayheads> x {};
+    for (int i = 0; i < snapshot.slicerNumVoices; ++i)
+    {
+        const float fraction = juce::jlimit(0.0f, 1.0f, snapshot.slicerPlayheads[(size_t)i]);
+        x[(size_t)i] = voiceArea.getX() + juce::roundToInt(fraction * (float)(voiceArea.getWidth() - 2));
+    }
+
+    if (snapshot.slicerNumVoices == numVoicesShown && x == voiceX)
+        return;
+
+    voiceX = x;
+    numVoicesShown = snapshot.slicerNumVoices;
+    repaint(voiceArea);
+}
+
 void SampleSlicerPanel::buttonClicked(juce::Button* button)
 {
     if (button == &loadSampleButton)
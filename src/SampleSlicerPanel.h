@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "SampleSlicer.h"
+#include "EngineSnapshot.h"
 
 class SampleSlicerPanel : public juce::Component,
                          public juce::Button::Listener,
@@ -16,6 +17,9 @@ public:
     void buttonClicked(juce::Button* button) override;
     void sliderValueChanged(juce::Slider* slider) override;
 
+    // Shows where each sounding voice is in the sample
+    void showSnapshot(const EngineSnapshot& snapshot);
+
 private:
     SampleSlicer& sampleSlicer;
     
@@ -42,6 +46,9 @@ private:
     // Slice display
     juce::ListBox sliceListBox;
     juce::Label sampleInfoLabel;
+    juce::Rectangle<int> voiceArea;
+    std::array<int, EngineSnapshot::maxSlicerPlayheads> voiceX {};
+    int numVoicesShown = 0;
     
     // Slice playback
     juce::TextButton playSliceButton;
@@ -3,7 +3,7 @@
 
 Sequencer::Sequencer()
     : sampleRate(44100.0), tempo(120.0), numSteps(16), currentStep(0),
-      stepTime(0.0), currentTime(0.0), playing(false)
+      stepTime(0.0), currentTime(0.0), beatPosition(0.0), playing(false)
 {
     steps.resize(numSteps);
     updateStepTime();
@@ -52,6 +52,8 @@ void Sequencer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFi
 
         currentTime += 1.0 / sampleRate;
     }
+
+    beatPosition += numSamples * tempo / (60.0 * sampleRate);
 }
 
 void Sequencer::releaseResources()
@@ -63,6 +65,7 @@ void Sequencer::start()
     playing = true;
     currentStep = 0;
     currentTime = 0.0;
+    beatPosition = 0.0;
 }
 
 void Sequencer::stop()
@@ -74,6 +77,7 @@ void Sequencer::reset()
 {
     currentStep = 0;
     currentTime = 0.0;
+    beatPosition = 0.0;
 }
 
 void Sequencer::setTempo(double bpm)
@@ -113,6 +117,16 @@ void Sequencer::setStepDuration(int step, double duration)
         steps[step].duration = duration;
 }
 
+bool Sequencer::getStepActive(int step) const
+{
+    return step >= 0 && step < numSteps && steps[step].active;
+}
+
+float Sequencer::getStepVelocity(int step) const
+{
+    return (step >= 0 && step < numSteps) ? steps[step].velocity : 0.0f;
+}
+
 void Sequencer::clearPattern()
 {
     for (auto& step : steps)
@@ -35,12 +35,18 @@ public:
     void setStepVelocity(int step, float velocity);
     void setStepStartTime(int step, double startTime);
     void setStepDuration(int step, double duration);
+    bool getStepActive(int step) const;
+    float getStepVelocity(int step) const;
     
     // Sequencer state
     bool isPlaying() const { return playing; }
     int getCurrentStep() const { return currentStep; }
     double getTempo() const { return tempo; }
     int getNumSteps() const { return numSteps; }
+
+    // Audio thread: beats since start(), as of the start of the next block;
+    // the grid other parts of the engine line up with
+    double getBeatPosition() const { return beatPosition; }
     
     // Pattern management
     void clearPattern();
@@ -55,6 +61,7 @@ private:
     int currentStep;
     double stepTime;
     double currentTime;
+    double beatPosition;
     bool playing;
 
     void updateStepTime();
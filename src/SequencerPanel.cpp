@@ -91,6 +91,13 @@ SequencerPanel::~SequencerPanel()
 void SequencerPanel::paint(juce::Graphics& g)
 {
     g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+
+    // Behind the step buttons, so it shows around the playing one
+    if (shown.sequencerPlaying)
+    {
+        g.setColour(juce::Colours::orange.withAlpha(0.6f));
+        g.fillRect(getStepCell(shown.sequencerStep));
+    }
 }
 
 void SequencerPanel::resized()
@@ -197,6 +204,34 @@ void SequencerPanel::sliderValueChanged(juce::Slider* slider)
     }
 }
 
+void SequencerPanel::showSnapshot(const EngineSnapshot& snapshot)
+{
+    if (snapshot.sequencerNumSteps != shown.sequencerNumSteps)
+    {
+        shown.sequencerNumSteps = snapshot.sequencerNumSteps;
+        updateStepButtons();
+    }
+
+    if (snapshot.sequencerPlaying != shown.sequencerPlaying)
+        updateButtonStates();
+
+    if (snapshot.sequencerStep != shown.sequencerStep || snapshot.sequencerPlaying != shown.sequencerPlaying)
+    {
+        repaint(getStepCell(shown.sequencerStep));
+        repaint(getStepCell(snapshot.sequencerStep));
+    }
+
+    shown = snapshot;
+}
+
+juce::Rectangle<int> SequencerPanel::getStepCell(int step) const
+{
+    if (step < 0 || step >= (int)stepButtons.size())
+        return {};
+
+    return stepButtons[(size_t)step].getBounds().expanded(2);
+}
+
 void SequencerPanel::updateButtonStates()
 {
     startButton.setEnabled(!sequencer.isPlaying());
@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "Sequencer.h"
+#include "EngineSnapshot.h"
 
 class SequencerPanel : public juce::Component,
                       public juce::Button::Listener,
@@ -16,6 +17,9 @@ public:
     void buttonClicked(juce::Button* button) override;
     void sliderValueChanged(juce::Slider* slider) override;
 
+    // Highlights the playing step, repainting only the cells that change
+    void showSnapshot(const EngineSnapshot& snapshot);
+
 private:
     Sequencer& sequencer;
     
@@ -39,9 +43,12 @@ private:
     juce::Label tempoLabel;
     juce::Label stepsLabel;
     juce::Label sequencerLabel;
+
+    EngineSnapshot shown;
     
     void updateButtonStates();
     void updateStepButtons();
+    juce::Rectangle<int> getStepCell(int step) const;
     void setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& name,
                     double min, double max, double interval, double defaultValue);
 
@@ -0,0 +1,277 @@
+#include "StereoDelay.h"
+
+namespace
+{
+    // Time changes glide rather than jump, like a tape delay
+    constexpr double delayGlideSeconds = 0.05;
+
+    float onePoleCoefficient(double cutoff, double sampleRate)
+    {
+        cutoff = juce::jlimit(1.0, 0.45 * sampleRate, cutoff);
+        return (float)(1.0 - std::exp(-juce::MathConstants<double>::twoPi * cutoff / sampleRate));
+    }
+}
+
+StereoDelay::StereoDelay()
+    : sampleRate(44100.0), maxBlockSize(0), lineMask(0), writePosition(0),
+      lowpassCoefficient(1.0f), highpassCoefficient(0.0f), feedbackGain(0.3f), wetGain(0.3f), isPingPong(false),
+      timeSeconds(0.5f), feedback(0.3f), mix(0.3f), pingPong(false), tempoSync(false), beats(0.5f),
+      lowCutHz(80.0f), highCutHz(8000.0f), tempo(120.0), parametersChanged(true)
+{
+    lowpassState.fill(0.0f);
+    highpassState.fill(0.0f);
+}
+
+void StereoDelay::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    maxBlockSize = (int)spec.maximumBlockSize;
+
+    // Room for the longest delay plus the interpolation neighbour
+    const int lineSize = juce::nextPowerOfTwo((int)std::ceil(maxDelaySeconds * sampleRate) + 2);
+    lineMask = lineSize - 1;
+
+    // Two lines, then five block-sized work buffers, in one zeroed block
+    const size_t lineBytes = AudioArena::roundUp((size_t)lineSize * sizeof(float));
+    const size_t workBytes = AudioArena::roundUp((size_t)maxBlockSize * sizeof(float));
+    memory = AudioArena::allocateFrom(audioArena, AudioArena::Subsystem::effects, lineBytes * 2 + workBytes * 5);
+
+    auto* next = memory.getData<char>();
+    auto take = [&next](size_t numBytes) { auto* region = reinterpret_cast<float*>(next); next += numBytes; return region; };
+
+    for (size_t ch = 0; ch < lines.size(); ++ch)
+        lines[ch] = take(lineBytes);
+    for (size_t ch = 0; ch < lines.size(); ++ch)
+    {
+        older[ch] = take(workBytes);
+        newer[ch] = take(workBytes);
+    }
+    monoInput = take(workBytes);
+
+    delaySamples.reset(sampleRate, delayGlideSeconds);
+    updateCoefficients();
+    delaySamples.setCurrentAndTargetValue(getTargetDelaySamples());
+
+    reset();
+}
+
+void StereoDelay::reset()
+{
+    for (auto* line : lines)
+        if (line != nullptr)
+            juce::FloatVectorOperations::clear(line, lineMask + 1);
+
+    lowpassState.fill(0.0f);
+    highpassState.fill(0.0f);
+    writePosition = 0;
+}
+
+void StereoDelay::setParameters(const Parameters& newParameters)
+{
+    timeSeconds = juce::jlimit(0.0f, maxDelaySeconds, newParameters.timeSeconds);
+    feedback = juce::jlimit(0.0f, 0.98f, newParameters.feedback);
+    mix = juce::jlimit(0.0f, 1.0f, newParameters.mix);
+    pingPong = newParameters.pingPong;
+    tempoSync = newParameters.tempoSync;
+    beats = juce::jmax(0.0f, newParameters.beats);
+    lowCutHz = newParameters.lowCutHz;
+    highCutHz = newParameters.highCutHz;
+    parametersChanged = true;
+}
+
+StereoDelay::Parameters StereoDelay::getParameters() const
+{
+    Parameters result;
+    result.timeSeconds = timeSeconds.load();
+    result.feedback = feedback.load();
+    result.mix = mix.load();
+    result.pingPong = pingPong.load();
+    result.tempoSync = tempoSync.load();
+    result.beats = beats.load();
+    result.lowCutHz = lowCutHz.load();
+    result.highCutHz = highCutHz.load();
+    return result;
+}
+
+void StereoDelay::setTempo(double bpm)
+{
+    if (bpm > 0.0)
+        tempo = bpm;
+}
+
+void StereoDelay::updateCoefficients()
+{
+    lowpassCoefficient = onePoleCoefficient(highCutHz.load(), sampleRate);
+    highpassCoefficient = onePoleCoefficient(lowCutHz.load(), sampleRate);
+    feedbackGain = feedback.load();
+    wetGain = mix.load();
+    isPingPong = pingPong.load();
+}
+
+float StereoDelay::getTargetDelaySamples() const
+{
+    const double seconds = tempoSync.load() ? beats.load() * 60.0 / tempo.load() : (double)timeSeconds.load();
+    return (float)juce::jlimit(1.0, (double)lineMask - 1.0, seconds * sampleRate);
+}
+
+float StereoDelay::filterSample(int channel, float input)
+{
+    // High cut, then low cut as the difference from a second, lower lowpass
+    auto& lowpass = lowpassState[(size_t)channel];
+    auto& highpass = highpassState[(size_t)channel];
+
+    lowpass += lowpassCoefficient * (input - lowpass);
+    highpass += highpassCoefficient * (lowpass - highpass);
+    return lowpass - highpass;
+}
+
+void StereoDelay::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& outputBlock = context.getOutputBlock();
+    if (outputBlock.getNumChannels() == 0 || maxBlockSize == 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    if (parametersChanged.exchange(false))
+        updateCoefficients();
+
+    delaySamples.setTargetValue(getTargetDelaySamples());
+
+    auto block = outputBlock.getSubsetChannelBlock(0, juce::jmin(outputBlock.getNumChannels(), lines.size()));
+
+    for (size_t offset = 0; offset < block.getNumSamples(); offset += (size_t)maxBlockSize)
+    {
+        auto subBlock = block.getSubBlock(offset, juce::jmin((size_t)maxBlockSize, block.getNumSamples() - offset));
+
+        // Reads only touch samples written in earlier blocks once the delay
+        // is longer than the block, so the whole block can be done at once
+        if (!delaySamples.isSmoothing() && delaySamples.getCurrentValue() >= (float)subBlock.getNumSamples() + 1.0f)
+            processVectorised(subBlock);
+        else
+            processSamples(subBlock);
+    }
+}
+
+void StereoDelay::processSamples(juce::dsp::AudioBlock<float>& block)
+{
+    const int numChannels = (int)block.getNumChannels();
+    const bool crossFeed = isPingPong && numChannels > 1;
+
+    for (size_t i = 0; i < block.getNumSamples(); ++i)
+    {
+        const float delay = delaySamples.getNextValue();
+        const float position = (float)writePosition - delay;
+        const int whole = (int)std::floor(position);
+        const float fraction = position - (float)whole;
+
+        float repeats[2] = { 0.0f, 0.0f };
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* line = lines[(size_t)ch];
+            const float a = line[(size_t)(whole & lineMask)];
+            const float b = line[(size_t)((whole + 1) & lineMask)];
+            repeats[ch] = filterSample(ch, a + (b - a) * fraction);
+        }
+
+        if (crossFeed)
+        {
+            auto* left = block.getChannelPointer(0);
+            auto* right = block.getChannelPointer(1);
+
+            // The input enters on the left and bounces between the sides
+            lines[0][(size_t)writePosition] = (left[i] + right[i]) * 0.5f + repeats[1] * feedbackGain;
+            lines[1][(size_t)writePosition] = repeats[0] * feedbackGain;
+        }
+        else
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                lines[(size_t)ch][(size_t)writePosition] = block.getSample(ch, (int)i) + repeats[ch] * feedbackGain;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            block.setSample(ch, (int)i, repeats[ch] * wetGain);
+
+        writePosition = (writePosition + 1) & lineMask;
+    }
+}
+
+void StereoDelay::processVectorised(juce::dsp::AudioBlock<float>& block)
+{
+    const int numChannels = (int)block.getNumChannels();
+    const int numSamples = (int)block.getNumSamples();
+    const bool crossFeed = isPingPong && numChannels > 1;
+
+    // Read position is writePosition - delay, between two stored samples
+    const float delay = delaySamples.getCurrentValue();
+    const int whole = (int)std::floor(delay);
+    const float fraction = delay - (float)whole;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* newerSamples = newer[(size_t)ch];
+        auto* olderSamples = older[(size_t)ch];
+
+        readWrapped(ch, writePosition - whole, newerSamples, numSamples);
+        readWrapped(ch, writePosition - whole - 1, olderSamples, numSamples);
+
+        juce::FloatVectorOperations::multiply(newerSamples, 1.0f - fraction, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(newerSamples, olderSamples, fraction, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            newerSamples[i] = filterSample(ch, newerSamples[i]);
+    }
+
+    // Feed the input and the filtered repeats back in
+    if (crossFeed)
+    {
+        juce::FloatVectorOperations::copy(monoInput, block.getChannelPointer(0), numSamples);
+        juce::FloatVectorOperations::add(monoInput, block.getChannelPointer(1), numSamples);
+
+        juce::FloatVectorOperations::copyWithMultiply(older[0], newer[1], feedbackGain, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(older[0], monoInput, 0.5f, numSamples);
+        juce::FloatVectorOperations::copyWithMultiply(older[1], newer[0], feedbackGain, numSamples);
+    }
+    else
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            juce::FloatVectorOperations::copyWithMultiply(older[(size_t)ch], newer[(size_t)ch], feedbackGain, numSamples);
+            juce::FloatVectorOperations::add(older[(size_t)ch], block.getChannelPointer((size_t)ch), numSamples);
+        }
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        writeWrapped(ch, writePosition, older[(size_t)ch], numSamples);
+        juce::FloatVectorOperations::copyWithMultiply(block.getChannelPointer((size_t)ch), newer[(size_t)ch], wetGain, numSamples);
+    }
+
+    writePosition = (writePosition + numSamples) & lineMask;
+}
+
+void StereoDelay::readWrapped(int channel, int start, float* dest, int numSamples) const
+{
+    const float* line = lines[(size_t)channel];
+    const int lineSize = lineMask + 1;
+    start &= lineMask;
+
+    const int firstPart = juce::jmin(numSamples, lineSize - start);
+    juce::FloatVectorOperations::copy(dest, line + start, firstPart);
+
+    if (firstPart < numSamples)
+        juce::FloatVectorOperations::copy(dest + firstPart, line, numSamples - firstPart);
+}
+
+void StereoDelay::writeWrapped(int channel, int start, const float* source, int numSamples)
+{
+    float* line = lines[(size_t)channel];
+    const int lineSize = lineMask + 1;
+    start &= lineMask;
+
+    const int firstPart = juce::jmin(numSamples, lineSize - start);
+    juce::FloatVectorOperations::copy(line + start, source, firstPart);
+
+    if (firstPart < numSamples)
+        juce::FloatVectorOperations::copy(line, source + firstPart, numSamples - firstPart);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioArena.h"
+
+// Stereo or ping-pong delay with interpolated fractional reads and a
+// high-cut/low-cut filter inside the feedback loop, so repeats darken and
+// thin out. The time can follow the tempo as a number of beats. Output is
+// wet only, scaled by the mix.
+//
+// The buffer is sized for the sample rate in prepare, in one block from the
+// AudioArena if one is set. While the delay time
+// is steady and longer than the block, each block is processed as whole
+// vector operations; otherwise, e.g. while the time glides, per sample.
+class StereoDelay
+{
+public:
+    static constexpr float maxDelaySeconds = 4.0f;
+
+    struct Parameters
+    {
+        float timeSeconds = 0.5f;
+        float feedback = 0.3f;
+        float mix = 0.3f;
+        bool pingPong = false;
+        bool tempoSync = false;
+        float beats = 0.5f;         // Delay time when synced, e.g. 0.75 for a dotted eighth
+        float lowCutHz = 80.0f;     // Feedback loop filter
+        float highCutHz = 8000.0f;
+    };
+
+    StereoDelay();
+
+    // Called before prepare
+    void setArena(AudioArena* newArena) { audioArena = newArena; }
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setParameters(const Parameters& newParameters);
+    Parameters getParameters() const;
+    float getMix() const { return mix.load(); }
+
+    void setTempo(double bpm);
+
+    // Audio thread: the current delay, the longest the output can be silent
+    // between two repeats while the line still holds sound
+    int getTailSamples() const { return (int)std::ceil(delaySamples.getCurrentValue()) + 1; }
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    double sampleRate;
+    int maxBlockSize;
+
+    AudioArena* audioArena = nullptr;
+    AudioArena::Block memory;       // The lines and work space below
+
+    // One power-of-two ring per channel
+    std::array<float*, 2> lines {};
+    int lineMask;
+    int writePosition;
+
+    // Per-block work space for the vectorised path
+    std::array<float*, 2> older {};
+    std::array<float*, 2> newer {};
+    float* monoInput = nullptr;
+
+    juce::SmoothedValue<float> delaySamples;
+    std::array<float, 2> lowpassState;
+    std::array<float, 2> highpassState;
+    float lowpassCoefficient;
+    float highpassCoefficient;
+    float feedbackGain;
+    float wetGain;
+    bool isPingPong;
+
+    // Shared with the control thread
+    std::atomic<float> timeSeconds;
+    std::atomic<float> feedback;
+    std::atomic<float> mix;
+    std::atomic<bool> pingPong;
+    std::atomic<bool> tempoSync;
+    std::atomic<float> beats;
+    std::atomic<float> lowCutHz;
+    std::atomic<float> highCutHz;
+    std::atomic<double> tempo;
+    std::atomic<bool> parametersChanged;
+
+    void updateCoefficients();
+    float getTargetDelaySamples() const;
+    float filterSample(int channel, float input);
+
+    void processSamples(juce::dsp::AudioBlock<float>& block);
+    void processVectorised(juce::dsp::AudioBlock<float>& block);
+
+    void readWrapped(int channel, int start, float* dest, int numSamples) const;
+    void writeWrapped(int channel, int start, const float* source, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StereoDelay)
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Hands the latest value of a small, trivially copyable type from one
+// writer thread to one reader thread without locks. The writer fills the
+// back slot and swaps it with the middle one; the reader swaps its front
+// slot with the middle one when something newer is there. Values the
+// reader was too slow for are skipped, and neither side ever waits.
+template <typename T>
+class TripleBuffer
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "TripleBuffer copies values with plain assignment");
+
+    TripleBuffer() = default;
+
+    // Writer
+    T& getWriteBuffer() { return slots[(size_t)backIndex]; }
+
+    void publish()
+    {
+        backIndex = middle.exchange(backIndex | newFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    void write(const T& value)
+    {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    // Reader. Returns false, leaving the destination alone, when nothing
+    // has been published since the last read.
+    bool read(T& destination)
+    {
+        if ((middle.load(std::memory_order_relaxed) & newFlag) == 0)
+            return false;
+
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+        destination = slots[(size_t)frontIndex];
+        return true;
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newFlag = 4;
+
+    std::array<T, 3> slots {};
+    std::atomic<int> middle { 1 };
+    int backIndex = 0;
+    int frontIndex = 2;
+
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
@@ -0,0 +1,237 @@
+#include "Waveshaper.h"
+
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // Overloads so each curve is written once for scalars and registers
+    inline float clampTo(float x, float limit)   { return juce::jlimit(-limit, limit, x); }
+    inline Vec clampTo(Vec x, float limit)       { return Vec::min(Vec::max(x, Vec::expand(-limit)), Vec::expand(limit)); }
+
+    inline float absOf(float x)                  { return std::abs(x); }
+    inline Vec absOf(Vec x)                      { return Vec::abs(x); }
+
+    inline float floorOf(float x)                { return std::floor(x); }
+    inline Vec floorOf(Vec x)
+    {
+        // Truncation rounds negative values up; step those back down by one
+        const auto truncated = Vec::truncate(x);
+        return truncated - (Vec::expand(1.0f) & Vec::lessThan(x, truncated));
+    }
+
+    // Quintic with f(0) = 0, f'(0) = 1 and f = 1, f' = f'' = 0 at the knee,
+    // so it lands on the rails as smoothly as tanh does
+    constexpr float tanhKnee = 1.875f;
+    constexpr float tanhA = -2.0f / (3.0f * tanhKnee * tanhKnee);
+    constexpr float tanhB = 1.0f / (5.0f * tanhKnee * tanhKnee * tanhKnee * tanhKnee);
+
+    template <typename T>
+    inline T saturateTanh(T x, float)
+    {
+        x = clampTo(x, tanhKnee);
+        const T x2 = x * x;
+        return x * ((x2 * tanhB + tanhA) * x2 + 1.0f);
+    }
+
+    // Cubic: f = 1 and f' = 0 at 1.5
+    template <typename T>
+    inline T saturateSoftClip(T x, float)
+    {
+        x = clampTo(x, 1.5f);
+        return x * ((x * x) * (-4.0f / 27.0f) + 1.0f);
+    }
+
+    // Triangle fold with period 4: identity inside +-1, mirrored outside
+    template <typename T>
+    inline T saturateFoldback(T x, float)
+    {
+        const T shifted = x + 1.0f;
+        const T wrapped = shifted - floorOf(shifted * 0.25f) * 4.0f;
+        return absOf(wrapped - 2.0f) * -1.0f + 1.0f;
+    }
+
+    template <typename T>
+    inline T saturateBitcrush(T x, float levels)
+    {
+        x = clampTo(x, 1.0f);
+        return floorOf(x * levels + 0.5f) * (1.0f / levels);
+    }
+
+    template <typename Function>
+    void shapeSamples(float* samples, int numSamples, float gain, float levels, Function&& function)
+    {
+        auto* end = samples + numSamples;
+        auto* alignedStart = juce::jmin(end, Vec::getNextSIMDAlignedPtr(samples));
+
+        // Scalar head up to the first aligned sample
+        for (auto* s = samples; s < alignedStart; ++s)
+            *s = function(*s * gain, levels);
+
+        // Vector body
+        auto* s = alignedStart;
+        for (; s + Vec::size() <= end; s += Vec::size())
+        {
+            const auto shaped = function(Vec::fromRawArray(s) * gain, levels);
+            shaped.copyToRawArray(s);
+        }
+
+        // Scalar tail
+        for (; s < end; ++s)
+            *s = function(*s * gain, levels);
+    }
+}
+
+Waveshaper::Waveshaper()
+    : currentOversampler(-1), maxBlockSize(0),
+      curve((int)Curve::tanh), drive(1.0f), mix(0.5f), oversampling(2), bits(8.0f)
+{
+}
+
+void Waveshaper::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    maxBlockSize = (int)spec.maximumBlockSize;
+    int maxLatency = 0;
+
+    for (size_t i = 0; i < oversamplers.size(); ++i)
+    {
+        const bool linearPhase = i >= (size_t)numFactors;
+        const auto filter = linearPhase ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                                        : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>(
+            spec.numChannels, i % numFactors + 1, filter, false, linearPhase);
+        oversamplers[i]->initProcessing(spec.maximumBlockSize);
+        maxLatency = juce::jmax(maxLatency, (int)std::ceil(oversamplers[i]->getLatencyInSamples()));
+    }
+
+    dryBuffer.setSize((int)spec.numChannels, maxBlockSize);
+    dryDelay.prepare(spec);
+    dryDelay.setMaximumDelayInSamples(maxLatency + 1);
+
+    currentOversampler = -1;
+    reset();
+}
+
+void Waveshaper::reset()
+{
+    for (auto& oversampler : oversamplers)
+    {
+        if (oversampler != nullptr)
+            oversampler->reset();
+    }
+
+    dryDelay.reset();
+}
+
+void Waveshaper::setParameters(const Parameters& newParameters)
+{
+    curve = (int)newParameters.curve;
+    drive = juce::jmax(0.0f, newParameters.drive);
+    mix = juce::jlimit(0.0f, 1.0f, newParameters.mix);
+    oversampling = newParameters.oversampling;
+    bits = juce::jlimit(1.0f, 24.0f, newParameters.bits);
+}
+
+Waveshaper::Parameters Waveshaper::getParameters() const
+{
+    Parameters result;
+    result.curve = (Curve)curve.load();
+    result.drive = drive.load();
+    result.mix = mix.load();
+    result.oversampling = oversampling.load();
+    result.bits = bits.load();
+    return result;
+}
+
+void Waveshaper::shapeChannel(float* samples, int numSamples, Curve shape, float gain, float levels) const
+{
+    switch (shape)
+    {
+        case Curve::tanh:
+            shapeSamples(samples, numSamples, gain, levels, [](auto x, float l) { return saturateTanh(x, l); });
+            break;
+        case Curve::softClip:
+            shapeSamples(samples, numSamples, gain, levels, [](auto x, float l) { return saturateSoftClip(x, l); });
+            break;
+        case Curve::foldback:
+            shapeSamples(samples, numSamples, gain, levels, [](auto x, float l) { return saturateFoldback(x, l); });
+            break;
+        case Curve::bitcrush:
+            shapeSamples(samples, numSamples, gain, levels, [](auto x, float l) { return saturateBitcrush(x, l); });
+            break;
+    }
+}
+
+void Waveshaper::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    const int numSamples = (int)block.getNumSamples();
+    const int numChannels = juce::jmin((int)block.getNumChannels(), dryBuffer.getNumChannels());
+
+    if (maxBlockSize == 0 || numSamples > maxBlockSize || numChannels == 0)
+        return;
+
+    const auto shape = (Curve)curve.load();
+    const float gain = drive.load();
+    const float wet = mix.load();
+    const float levels = std::exp2(bits.load() - 1.0f);
+
+    // Bitcrushing wants its aliasing. Any dry signal in the mix needs the
+    // linear-phase filters, whose whole-sample latency the dry delay matches.
+    int oversampler = -1;
+    if (shape != Curve::bitcrush)
+    {
+        const int factor = oversampling.load();
+        oversampler = factor >= 8 ? 2 : factor >= 4 ? 1 : factor >= 2 ? 0 : -1;
+
+        if (oversampler >= 0 && wet < 1.0f)
+            oversampler += numFactors;
+    }
+
+    if (oversampler != currentOversampler)
+    {
+        if (oversampler >= 0)
+            oversamplers[(size_t)oversampler]->reset();
+
+        currentOversampler = oversampler;
+        dryDelay.setDelay(oversampler >= 0 ? (float)juce::roundToInt(oversamplers[(size_t)oversampler]->getLatencyInSamples())
+                                           : 0.0f);
+    }
+
+    // Keep the dry signal, delayed to line up with the oversampled path
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* in = block.getChannelPointer((size_t)ch);
+        auto* dry = dryBuffer.getWritePointer(ch);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dryDelay.pushSample(ch, in[i]);
+            dry[i] = dryDelay.popSample(ch);
+        }
+    }
+
+    auto channels = block.getSubsetChannelBlock(0, (size_t)numChannels);
+
+    if (currentOversampler >= 0)
+    {
+        auto& os = *oversamplers[(size_t)currentOversampler];
+        auto upsampled = os.processSamplesUp(channels);
+
+        for (size_t ch = 0; ch < upsampled.getNumChannels(); ++ch)
+            shapeChannel(upsampled.getChannelPointer(ch), (int)upsampled.getNumSamples(), shape, gain, levels);
+
+        os.processSamplesDown(channels);
+    }
+    else
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            shapeChannel(channels.getChannelPointer((size_t)ch), numSamples, shape, gain, levels);
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* out = channels.getChannelPointer((size_t)ch);
+        juce::FloatVectorOperations::multiply(out, wet, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(out, dryBuffer.getReadPointer(ch), 1.0f - wet, numSamples);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Drive stage with selectable transfer curves, optional 2x/4x/8x oversampling
+// and a latency-compensated dry/wet mix. Fully wet it oversamples with
+// polyphase IIR filters, cheapest and with the least latency; mixed with the
+// dry signal it uses linear-phase FIR filters instead, whose latency is a
+// whole number of samples, so the delayed dry path lines up exactly and the
+// mix does not comb-filter. The curves are
+// plain polynomials (no std::tanh) evaluated on SIMD registers over the
+// aligned part of each channel, with scalar code for the ragged ends.
+//
+//   tanh       smooth quintic saturator, tanh-like, flat beyond +-1.875
+//   softClip   cubic soft clipper, flat beyond +-1.5
+//   foldback   wave folder, reflects the signal back inside +-1
+//   bitcrush   quantises to a number of bits; not oversampled, the
+//              aliasing is the point
+class Waveshaper
+{
+public:
+    enum class Curve
+    {
+        tanh,
+        softClip,
+        foldback,
+        bitcrush
+    };
+
+    struct Parameters
+    {
+        Curve curve = Curve::tanh;
+        float drive = 1.0f;      // Input gain, 1 to 10
+        float mix = 0.5f;
+        int oversampling = 2;    // 1, 2, 4 or 8
+        float bits = 8.0f;       // Bitcrush depth
+    };
+
+    Waveshaper();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    void setParameters(const Parameters& newParameters);
+    Parameters getParameters() const;
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    // Oversamplers for 2x, 4x and 8x, IIR then FIR, all built in prepare so
+    // switching never allocates
+    static constexpr int numFactors = 3;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, numFactors * 2> oversamplers;
+    int currentOversampler;
+
+    juce::AudioBuffer<float> dryBuffer;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> dryDelay;
+    int maxBlockSize;
+
+    std::atomic<int> curve;
+    std::atomic<float> drive;
+    std::atomic<float> mix;
+    std::atomic<int> oversampling;
+    std::atomic<float> bits;
+
+    void shapeChannel(float* samples, int numSamples, Curve shape, float gain, float levels) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Waveshaper)
+};
@@ -0,0 +1,208 @@
+#include "XrunMonitor.h"
+
+namespace
+{
+    // A callback a whole period late has used up the device's spare buffer
+    // on any two-period setup, so the output has almost certainly glitched
+    constexpr double lateCallbackFactor = 2.0;
+}
+
+XrunMonitor::XrunMonitor()
+    : fifo(fifoSize), sampleRate(44100.0), ticksToMs(1000.0 / (double)juce::Time::getHighResolutionTicksPerSecond()),
+      previousStart(0), previousNumSamples(0), previousDeviceXruns(-1),
+      numXruns(0), numDropped(0), resetRequested(false)
+{
+    previousLoads.fill(0.0f);
+    for (auto& count : causeCounts)
+        count = 0;
+}
+
+XrunMonitor::~XrunMonitor()
+{
+    stopTimer();
+}
+
+void XrunMonitor::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    // The gap while the device restarts is not a dropout
+    resetRequested = true;
+
+    if (!isTimerRunning())
+        startTimerHz(10);
+}
+
+void XrunMonitor::endBlock(const DSPProfiler& profiler, int numSamples, int deviceXrunCount, const GraphState& graph)
+{
+    const auto start = profiler.getBlockStartTicks();
+    const auto& loads = profiler.getLastBlockLoads();
+    const float totalLoad = loads[(size_t)DSPProfiler::Node::total];
+
+    if (resetRequested.exchange(false))
+    {
+        previousStart = 0;
+        previousDeviceXruns = deviceXrunCount;
+    }
+
+    if (previousStart != 0 && previousNumSamples > 0)
+    {
+        const double intervalMs = (double)(start - previousStart) * ticksToMs;
+        const double expectedMs = previousNumSamples * 1000.0 / sampleRate;
+        const bool deviceReported = deviceXrunCount > previousDeviceXruns && previousDeviceXruns >= 0;
+        const bool late = intervalMs > expectedMs * lateCallbackFactor;
+
+        // An overrunning block was already recorded when it finished; the
+        // late callback after it is the same dropout
+        const bool previousOverran = previousLoads[(size_t)DSPProfiler::Node::total] >= 1.0f;
+
+        if ((deviceReported || late) && !previousOverran)
+        {
+            push(deviceReported ? Cause::deviceReported : Cause::lateCallback, intervalMs, expectedMs,
+                 previousLoads[(size_t)DSPProfiler::Node::total] * expectedMs, previousNumSamples, deviceXrunCount,
+                 previousLoads, previousGraph);
+        }
+    }
+
+    if (totalLoad >= 1.0f)
+    {
+        const double durationMs = numSamples * 1000.0 / sampleRate;
+        push(Cause::processingOverrun, 0.0, durationMs, totalLoad * durationMs, numSamples, deviceXrunCount, loads, graph);
+    }
+
+    previousStart = start;
+    previousNumSamples = numSamples;
+    previousDeviceXruns = deviceXrunCount;
+    previousLoads = loads;
+    previousGraph = graph;
+}
+
+void XrunMonitor::push(Cause cause, double intervalMs, double expectedMs, double processingMs, int numSamples,
+                       int deviceXruns, const std::array<float, DSPProfiler::numNodes>& loads, const GraphState& graph)
+{
+    ++numXruns;
+    ++causeCounts[(size_t)cause];
+
+    const auto scope = fifo.write(1);
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+    {
+        ++numDropped;
+        return;
+    }
+
+    auto& incident = pending[(size_t)(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+    incident.cause = cause;
+    incident.wallClockMs = juce::Time::getMillisecondCounterHiRes();
+    incident.intervalMs = intervalMs;
+    incident.expectedMs = expectedMs;
+    incident.processingMs = processingMs;
+    incident.numSamples = numSamples;
+    incident.deviceXruns = deviceXruns;
+    incident.nodeLoads = loads;
+    incident.graph = graph;
+}
+
+void XrunMonitor::timerCallback()
+{
+    const auto scope = fifo.read(fifo.getNumReady());
+
+    auto take = [this](int index)
+    {
+        const auto& incident = pending[(size_t)index];
+        history.push_back(incident);
+        if ((int)history.size() > maxHistory)
+            history.pop_front();
+
+        if (onXrun)
+            onXrun(incident);
+    };
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        take(scope.startIndex1 + i);
+
+    for (int i = 0; i < scope.blockSize2; ++i)
+        take(scope.startIndex2 + i);
+}
+
+std::vector<XrunMonitor::Incident> XrunMonitor::getRecentIncidents(int maxIncidents) const
+{
+    const auto count = (size_t)juce::jlimit(0, (int)history.size(), maxIncidents);
+    return { history.end() - (std::ptrdiff_t)count, history.end() };
+}
+
+void XrunMonitor::clearHistory()
+{
+    history.clear();
+}
+
+juce::String XrunMonitor::createReport(int maxIncidents) const
+{
+    const auto incidents = getRecentIncidents(maxIncidents);
+
+    juce::String report;
+    report << "Xruns: " << getNumXruns()
+           << " (late " << getNumXruns(Cause::lateCallback)
+           << ", device " << getNumXruns(Cause::deviceReported)
+           << ", overrun " << getNumXruns(Cause::processingOverrun)
+           << ", unrecorded " << getNumDropped() << ")" << juce::newLine;
+
+    // Incident times are on the millisecond counter; convert to wall time
+    const auto now = juce::Time::getCurrentTime();
+    const double counterNow = juce::Time::getMillisecondCounterHiRes();
+
+    for (const auto& incident : incidents)
+    {
+        const auto when = now - juce::RelativeTime::milliseconds((juce::int64)(counterNow - incident.wallClockMs));
+
+        report << when.formatted("%H:%M:%S") << "." << juce::String(when.getMilliseconds()).paddedLeft('0', 3)
+               << "  " << getCauseName(incident.cause)
+               << ": " << incident.numSamples << " samples, expected " << juce::String(incident.expectedMs, 2) << " ms";
+
+        if (incident.intervalMs > 0.0)
+            report << ", interval " << juce::String(incident.intervalMs, 2) << " ms";
+
+        report << ", processing " << juce::String(incident.processingMs, 2) << " ms";
+
+        if (incident.deviceXruns >= 0)
+            report << ", device xruns " << incident.deviceXruns;
+
+        report << juce::newLine << "    graph: inserts";
+        for (int i = 0; i < incident.graph.numTracks; ++i)
+            report << (i == 0 ? " " : "/") << incident.graph.insertCounts[(size_t)i];
+
+        report << ", buses";
+        for (int i = 0; i < incident.graph.numBuses; ++i)
+            report << (incident.graph.busesActive[(size_t)i] ? " on" : " off");
+
+        report << ", master FX " << (incident.graph.masterEffectsEnabled ? "on" : "off")
+               << ", slicer voices " << incident.graph.slicerVoices << juce::newLine << "    load:";
+
+        for (int i = 0; i < DSPProfiler::numNodes; ++i)
+        {
+            const float load = incident.nodeLoads[(size_t)i];
+            if (load >= 0.001f)
+                report << " " << DSPProfiler::getNodeName((DSPProfiler::Node)i) << " " << juce::String(load * 100.0f, 1) << "%";
+        }
+
+        report << juce::newLine;
+    }
+
+    return report;
+}
+
+void XrunMonitor::dumpToLog(int maxIncidents) const
+{
+    juce::Logger::writeToLog(createReport(maxIncidents));
+}
+
+juce::String XrunMonitor::getCauseName(Cause cause)
+{
+    switch (cause)
+    {
+        case Cause::lateCallback:      return "late callback";
+        case Cause::deviceReported:    return "device xrun";
+        case Cause::processingOverrun: return "processing overrun";
+    }
+
+    return {};
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSPProfiler.h"
+
+// Detects audio dropouts and keeps a post-mortem of each one.
+//
+// Once per callback the audio thread reports when the block started, how
+// long it took and the device's own xrun count. A dropout is flagged when
+// the callback came much later than the previous block's duration, when the
+// device reports new xruns, or when processing took longer than the block
+// lasts. Each incident carries the per-node load of the block that caused
+// it and a summary of the graph, and travels to the message thread through
+// a lock-free FIFO, where the most recent ones are kept for inspection.
+class XrunMonitor : private juce::Timer
+{
+public:
+    static constexpr int fifoSize = 64;
+    static constexpr int maxHistory = 256;
+    static constexpr int maxTracks = 8;
+    static constexpr int maxBuses = 4;
+
+    enum class Cause
+    {
+        lateCallback,
+        deviceReported,
+        processingOverrun
+    };
+
+    // What was running when it happened, filled in by the engine
+    struct GraphState
+    {
+        int numTracks = 0;
+        int numBuses = 0;
+        std::array<int, maxTracks> insertCounts {};
+        std::array<bool, maxBuses> busesActive {};
+        bool masterEffectsEnabled = false;
+        int slicerVoices = 0;
+    };
+
+    struct Incident
+    {
+        Cause cause = Cause::lateCallback;
+        double wallClockMs = 0.0;       // Time::getMillisecondCounterHiRes
+        double intervalMs = 0.0;        // Since the previous callback started
+        double expectedMs = 0.0;        // Duration of the previous block
+        double processingMs = 0.0;      // Time spent in the offending block
+        int numSamples = 0;
+        int deviceXruns = 0;
+        std::array<float, DSPProfiler::numNodes> nodeLoads {};
+        GraphState graph;
+    };
+
+    XrunMonitor();
+    ~XrunMonitor() override;
+
+    // Also starts handing incidents to the message thread, so a monitor
+    // that is never prepared runs no timer
+    void prepare(double sampleRate);
+
+    // Audio thread, at the end of each callback. deviceXrunCount is the
+    // device's running total, or -1 if it does not report one.
+    void endBlock(const DSPProfiler& profiler, int numSamples, int deviceXrunCount, const GraphState& graph);
+
+    // Any thread
+    int getNumXruns() const { return numXruns.load(); }
+    int getNumXruns(Cause cause) const { return causeCounts[(size_t)cause].load(); }
+    int getNumDropped() const { return numDropped.load(); }
+
+    // Message thread. Most recent last.
+    std::vector<Incident> getRecentIncidents(int maxIncidents) const;
+    juce::String createReport(int maxIncidents) const;
+    void dumpToLog(int maxIncidents = 16) const;
+    void clearHistory();
+
+    static juce::String getCauseName(Cause cause);
+
+    // Called on the message thread for every new incident
+    std::function<void(const Incident&)> onXrun;
+
+private:
+    juce::AbstractFifo fifo;
+    std::array<Incident, fifoSize> pending;
+    std::deque<Incident> history;
+
+    // Audio thread only
+    double sampleRate;
+    double ticksToMs;
+    juce::int64 previousStart;
+    int previousNumSamples;
+    int previousDeviceXruns;
+    std::array<float, DSPProfiler::numNodes> previousLoads;
+    GraphState previousGraph;
+
+    std::atomic<int> numXruns;
+    std::array<std::atomic<int>, 3> causeCounts;
+    std::atomic<int> numDropped;
+    std::atomic<bool> resetRequested;
+
+    void push(Cause cause, double intervalMs, double expectedMs, double processingMs, int numSamples,
+              int deviceXruns, const std::array<float, DSPProfiler::numNodes>& loads, const GraphState& graph);
+
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(XrunMonitor)
+};
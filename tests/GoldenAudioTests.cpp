@@ -0,0 +1,391 @@
+// Renders fixed scenarios through the offline engine and compares each one
+// with its reference WAV, so DSP and threading rewrites can be shown not to
+// change the sound.
+//
+//   groovdeck_tests [--golden=<dir>] [--update] [--exact] [--tolerance=<dB>] [--filter=<text>] [--out=<dir>]
+//
+//   --golden=<dir>     Reference directory (default: tests/golden)
+//   --update           Write the references instead of comparing with them
+//   --exact            Require every sample to match in every scenario
+//   --tolerance=<dB>   Largest residual peak allowed otherwise (default: -90)
+//   --filter=<text>    Only run scenarios whose name contains the text
+//   --out=<dir>        Also write each render and its residual, for listening
+//
+// A scenario marked exact is always compared bit for bit. Each result shows
+// the null-test residual, i.e. render minus reference, as peak and RMS
+// level, and the CPU time the render took.
+//
+// Exits with 0 when every scenario passes and 1 on any failure, including a
+// scenario without a reference: references are written with --update and
+// committed under tests/golden, so a missing one is a broken checkout.
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+namespace
+{
+    struct Options
+    {
+        juce::File goldenDirectory;
+        juce::File outputDirectory;
+        juce::String filter;
+        double toleranceDb = -90.0;
+        bool update = false;
+        bool exact = false;
+    };
+
+    struct Scenario
+    {
+        juce::String name;
+        bool exact = false;                 // Bit for bit; kept to paths without reverb or oversampling
+        double lengthSeconds = 4.0;
+        std::function<void(AudioEngine&)> setup;
+        std::function<void(AudioEngine&, juce::int64, juce::AudioBuffer<float>& input)> cue;
+    };
+
+    OfflineRenderer::Settings getSettings(const Scenario& scenario)
+    {
+        OfflineRenderer::Settings settings;
+        settings.sampleRate = 48000.0;
+        settings.blockSize = 256;
+        settings.lengthSeconds = scenario.lengthSeconds;
+        settings.tailSeconds = 1.0;
+        return settings;
+    }
+
+    // Seeded, so every run and every machine gets the same input
+    juce::AudioBuffer<float> makeHits(double seconds, double sampleRate, double hitsPerSecond, juce::int64 seed)
+    {
+        juce::Random random(seed);
+        juce::AudioBuffer<float> buffer(2, (int)(seconds * sampleRate));
+
+        const int hitLength = juce::jmax(1, (int)(sampleRate / hitsPerSecond));
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* samples = buffer.getWritePointer(ch);
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const float phase = (float)(i % hitLength) / (float)hitLength;
+                const float tone = std::sin(juce::MathConstants<float>::twoPi * 110.0f * (float)i / (float)sampleRate);
+                samples[i] = (0.6f * tone + 0.4f * (random.nextFloat() * 2.0f - 1.0f)) * std::exp(-10.0f * phase) * 0.5f;
+            }
+        }
+
+        return buffer;
+    }
+
+    // Whether the block starting at time holds the given moment
+    bool isCued(juce::int64 time, double seconds)
+    {
+        const auto cueTime = (juce::int64)(seconds * 48000.0);
+        return time <= cueTime && cueTime < time + 256;
+    }
+
+    // Adds the part of source that falls in the block starting at time,
+    // source starting at startTime
+    void playInto(juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>& source, juce::int64 time, juce::int64 startTime)
+    {
+        const auto from = juce::jmax(time, startTime);
+        const auto to = juce::jmin(time + input.getNumSamples(), startTime + source.getNumSamples());
+
+        for (auto t = from; t < to; ++t)
+            for (int ch = 0; ch < input.getNumChannels(); ++ch)
+                input.addSample(ch, (int)(t - time), source.getSample(ch, (int)(t - startTime)));
+    }
+
+    void setPattern(Sequencer& sequencer, double bpm, int numSteps, const std::function<bool(int)>& isActive)
+    {
+        sequencer.setTempo(bpm);
+        sequencer.setSteps(numSteps);
+        sequencer.clearPattern();
+
+        for (int step = 0; step < numSteps; ++step)
+        {
+            sequencer.setStepActive(step, isActive(step));
+            sequencer.setStepVelocity(step, 0.5f + 0.5f * (float)((step * 5) % 8) / 7.0f);
+        }
+    }
+
+    std::vector<Scenario> createScenarios()
+    {
+        using Track = AudioEngine::Track;
+        using Effect = EffectsProcessor::Effect;
+
+        std::vector<Scenario> scenarios;
+
+        scenarios.push_back({ "sequencer_pattern", true, 4.0, [](AudioEngine& engine)
+        {
+            setPattern(engine.getSequencer(), 128.0, 16, [](int step) { return step % 4 == 0 || step % 7 == 3; });
+        }, nullptr });
+
+        // A base loop, then a second layer on another track loaded halfway
+        // through, which has to come in phase-locked to the first
+        scenarios.push_back({ "looper_layers", true, 6.0, [](AudioEngine& engine)
+        {
+            engine.getLiveLooper().loadLoop(0, makeHits(2.0, 48000.0, 2.0, 10));
+            engine.getLiveLooper().setTrackGain(0, 0.8f);
+        },
+        [](AudioEngine& engine, juce::int64 time, juce::AudioBuffer<float>&)
+        {
+            if (!isCued(time, 3.0))
+                return;
+
+            auto& looper = engine.getLiveLooper();
+            looper.loadLoop(1, makeHits(2.0, 48000.0, 6.0, 11));
+            looper.setTrackGain(1, 0.4f);
+            looper.startPlayback(1);
+        } });
+
+        // A loop recorded from the input, then a second pass overdubbed onto
+        // it while it plays, both through the engine's input as when live
+        scenarios.push_back({ "looper_overdub", true, 7.0, [](AudioEngine& engine)
+        {
+            engine.getLiveLooper().setTrackGain(0, 0.8f);
+        },
+        [base = makeHits(2.0, 48000.0, 2.0, 12), layer = makeHits(2.0, 48000.0, 5.0, 13)]
+        (AudioEngine& engine, juce::int64 time, juce::AudioBuffer<float>& input)
+        {
+            auto& looper = engine.getLiveLooper();
+
+            if (isCued(time, 0.0) || isCued(time, 3.0))
+                looper.startRecording(0);
+            else if (isCued(time, 2.0) || isCued(time, 5.0))
+                looper.stopRecording(0);
+
+            playInto(input, base, time, 0);
+            playInto(input, layer, time, 3 * 48000);
+        } });
+
+        scenarios.push_back({ "slicer_voices", false, 4.0, [](AudioEngine& engine)
+        {
+            auto& slicer = engine.getSampleSlicer();
+            slicer.loadSample(makeHits(4.0, 48000.0, 4.0, 20));
+            slicer.sliceAtTransients(0.5);
+            slicer.setVoiceFilter(true, MultimodeFilter::Mode::lowpass, MultimodeFilter::Slope::db24, 1500.0f, 2.0f);
+            slicer.setVoiceFilterEnvelope(3.0f, 0.15f);
+        },
+        [](AudioEngine& engine, juce::int64 time, juce::AudioBuffer<float>&)
+        {
+            // A hit every 64 blocks, overlapping so several voices ring at once
+            const juce::int64 block = time / 256;
+            auto& slicer = engine.getSampleSlicer();
+            if (block % 64 == 0 && slicer.getNumSlices() > 0)
+                slicer.playSlice((int)((block / 64) * 3 % slicer.getNumSlices()), 0.9f);
+        } });
+
+        scenarios.push_back({ "effects_chain", false, 4.0, [](AudioEngine& engine)
+        {
+            setPattern(engine.getSequencer(), 120.0, 8, [](int step) { return step != 5; });
+
+            auto& slicer = engine.getSampleSlicer();
+            slicer.loadSample(makeHits(2.0, 48000.0, 2.0, 30));
+            slicer.autoSlice(0.5);
+            slicer.playSlice(0);
+
+            if (auto* filter = dynamic_cast<FilterUnit*>(engine.getTrackEffects(Track::slicer).addEffect(Effect::filter)))
+            {
+                filter->setMode(MultimodeFilter::Mode::bandpass, MultimodeFilter::Slope::db12);
+                filter->setParameters(900.0f, 3.0f);
+                filter->setLFO(2.0f, 1.5f);
+            }
+
+            engine.setTrackSend(Track::sequencer, AudioEngine::Bus::delay, 0.4f);
+            engine.setTrackSend(Track::slicer, AudioEngine::Bus::reverb, 0.5f);
+
+            auto& effects = engine.getEffectsProcessor();
+            effects.setFilterParameters(4000.0f, 1.2f);
+            effects.setDistortionParameters(4.0f, 0.3f);
+            effects.setDelayParameters(0.25f, 0.45f, 0.3f);
+            effects.setReverbParameters(0.6f, 0.4f, 0.25f, 0.8f);
+            effects.setDistortionOversampling(2);
+            for (int i = 0; i < EffectsProcessor::numEffects; ++i)
+                effects.setEffectEnabled((Effect)i, true);
+            engine.setEffectsEnabled(true);
+
+            auto dynamics = engine.getMasterDynamics().getParameters();
+            dynamics.compressorEnabled = true;
+            dynamics.thresholdDb = -18.0f;
+            dynamics.ratio = 3.0f;
+            dynamics.limiterEnabled = true;
+            engine.getMasterDynamics().setParameters(dynamics);
+        }, nullptr });
+
+        return scenarios;
+    }
+
+    juce::String toDb(float gain)
+    {
+        return gain > 0.0f ? juce::String(juce::Decibels::gainToDecibels(gain, -400.0f), 1) + " dB" : "silent";
+    }
+
+    bool readReference(const juce::File& file, juce::AudioBuffer<float>& reference)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return false;
+
+        reference.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
+        return reader->read(&reference, 0, reference.getNumSamples(), 0, true, true);
+    }
+
+    // 32-bit float, so a reference holds the render bit for bit
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        file.deleteFile();
+        auto writer = OfflineRenderer::createWriter(file, sampleRate, audio.getNumChannels(), 32);
+        return writer != nullptr && writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+    enum class Outcome
+    {
+        passed,
+        failed,
+        missing
+    };
+
+    Outcome run(const Scenario& scenario, const Options& options)
+    {
+        const auto settings = getSettings(scenario);
+
+        AudioEngine engine(AudioEngine::Mode::headless);
+        engine.prepareToPlay(settings.blockSize, settings.sampleRate);
+        scenario.setup(engine);
+
+        OfflineRenderer::BlockCallback cue;
+        if (scenario.cue)
+            cue = [&](juce::int64 time, juce::AudioBuffer<float>& input) { scenario.cue(engine, time, input); };
+
+        juce::AudioBuffer<float> render;
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const double audioSeconds = OfflineRenderer::render(engine, settings, render, cue);
+        const double cpuMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+        std::cout << scenario.name.paddedRight(' ', 20) << juce::String(cpuMs, 1).paddedLeft(' ', 9) << " ms cpu"
+                  << juce::String(audioSeconds * 1000.0 / juce::jmax(1.0e-6, cpuMs), 1).paddedLeft(' ', 8) << "x  ";
+
+        const auto referenceFile = options.goldenDirectory.getChildFile(scenario.name + ".wav");
+
+        if (options.outputDirectory != juce::File())
+            writeWav(options.outputDirectory.getChildFile(scenario.name + ".wav"), render, settings.sampleRate);
+
+        if (options.update)
+        {
+            const bool written = writeWav(referenceFile, render, settings.sampleRate);
+            std::cout << (written ? "updated" : "could not write " + referenceFile.getFullPathName()) << std::endl;
+            return written ? Outcome::passed : Outcome::failed;
+        }
+
+        juce::AudioBuffer<float> reference;
+        if (!referenceFile.existsAsFile() || !readReference(referenceFile, reference))
+        {
+            std::cout << "no reference" << std::endl;
+            return Outcome::missing;
+        }
+
+        if (reference.getNumChannels() != render.getNumChannels() || reference.getNumSamples() != render.getNumSamples())
+        {
+            std::cout << "FAILED: " << render.getNumSamples() << " samples rendered, reference has "
+                      << reference.getNumSamples() << std::endl;
+            return Outcome::failed;
+        }
+
+        juce::AudioBuffer<float> residual(render);
+        float peak = 0.0f;
+        double sumOfSquares = 0.0;
+        int numDiffering = 0;
+
+        for (int ch = 0; ch < residual.getNumChannels(); ++ch)
+        {
+            auto* samples = residual.getWritePointer(ch);
+            const auto* expected = reference.getReadPointer(ch);
+
+            for (int i = 0; i < residual.getNumSamples(); ++i)
+            {
+                samples[i] -= expected[i];
+
+                // Compare the bits, so -0 against +0 or a NaN shows up too
+                if (std::memcmp(render.getReadPointer(ch) + i, expected + i, sizeof(float)) != 0)
+                    ++numDiffering;
+
+                peak = juce::jmax(peak, std::abs(samples[i]));
+                sumOfSquares += (double)samples[i] * samples[i];
+            }
+        }
+
+        const float rms = (float)std::sqrt(sumOfSquares / juce::jmax(1, residual.getNumChannels() * residual.getNumSamples()));
+
+        if (options.outputDirectory != juce::File() && numDiffering > 0)
+            writeWav(options.outputDirectory.getChildFile(scenario.name + "-residual.wav"), residual, settings.sampleRate);
+
+        const bool exact = options.exact || scenario.exact;
+        const bool passed = exact ? numDiffering == 0
+                                  : peak <= juce::Decibels::decibelsToGain((float)options.toleranceDb, -400.0f);
+
+        std::cout << (passed ? "ok    " : "FAILED") << "  residual peak " << toDb(peak) << ", rms " << toDb(rms)
+                  << ", " << numDiffering << " samples differ" << (exact ? " (exact)" : "") << std::endl;
+
+        return passed ? Outcome::passed : Outcome::failed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // The engine's timers and MIDI device watcher expect JUCE to be set up
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+
+    Options options;
+    options.update = args.containsOption("--update");
+    options.exact = args.containsOption("--exact");
+
+    options.goldenDirectory = args.containsOption("--golden")
+        ? juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--golden").unquoted())
+        : juce::File::getCurrentWorkingDirectory().getChildFile("tests/golden");
+
+    if (args.containsOption("--out"))
+    {
+        options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out").unquoted());
+        options.outputDirectory.createDirectory();
+    }
+
+    if (args.containsOption("--tolerance"))
+        options.toleranceDb = args.getValueForOption("--tolerance").getDoubleValue();
+    if (args.containsOption("--filter"))
+        options.filter = args.getValueForOption("--filter");
+
+    if (options.update)
+        options.goldenDirectory.createDirectory();
+
+    int numPassed = 0, numFailed = 0, numMissing = 0;
+
+    for (const auto& scenario : createScenarios())
+    {
+        if (options.filter.isNotEmpty() && !scenario.name.containsIgnoreCase(options.filter))
+            continue;
+
+        switch (run(scenario, options))
+        {
+            case Outcome::passed:  ++numPassed; break;
+            case Outcome::failed:  ++numFailed; break;
+            case Outcome::missing: ++numMissing; break;
+        }
+    }
+
+    std::cout << numPassed << " passed, " << numFailed << " failed, " << numMissing << " without a reference" << std::endl;
+
+    if (numFailed > 0)
+        return 1;
+
+    if (numMissing > 0)
+    {
+        std::cout << "Write the missing references with: groovdeck_tests --update --golden="
+                  << options.goldenDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}